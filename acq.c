@@ -0,0 +1,93 @@
+/*
+ * acq.c
+ *
+ *  Created on: 17.10.2026
+ *      Author: agent
+ *
+ *  Description: pipelined T/RH acquisition (see acq.h)
+ *
+ *  Functions:
+ *  	acq_init(cfg) .. stage functions
+ *  	acq_run(n) .. n samples, returns samples passed to sample stage
+ *
+ */
+
+// sensor driver
+#include "sht11.h"
+// self
+#include "acq.h"
+
+/** module local definitions */
+
+// stage functions
+acq_cfg_t acq_cfg;
+
+// first attempt of current measurement already started (overlapped with a stage)
+unsigned char acq_started = 0;
+
+// last RH (used when RH measurement is skipped)
+unsigned int acq_h = 0;
+
+//----------------------------------------------------------------------------------
+// measure function for sht_measure_retry(): the first attempt was started before
+// the stage work, so it is just waited for, retries start a new one
+//----------------------------------------------------------------------------------
+static unsigned char acq_measure(unsigned int *value, unsigned char mode)
+{
+	if (acq_started) acq_started = 0;
+	else if (sht_measure_async(mode,0)!=0) return sht_measure_async_result(value);
+	return sht_measure_async_wait(value);
+}
+
+//----------------------------------------------------------------------------------
+// start measurement (result is taken later by sht_measure_retry)
+//----------------------------------------------------------------------------------
+static void acq_start(unsigned char mode)
+{
+	sht_measure_async(mode,0); // start error is kept as async result
+	acq_started = 1;
+}
+
+//----------------------------------------------------------------------------------
+// set stage functions
+//----------------------------------------------------------------------------------
+void acq_init(const acq_cfg_t *cfg)
+{
+	acq_cfg = *cfg;
+}
+
+//----------------------------------------------------------------------------------
+// acquire n samples back to back, returns samples passed to sample stage
+//----------------------------------------------------------------------------------
+unsigned int acq_run(unsigned int n)
+{
+	unsigned int t, pt = 0, ph = 0, done = 0;
+	unsigned char res, pres = 0, rh, pending = 0;
+
+	while (n--)
+	{
+		res = sht_get_resolution();
+		acq_start(TEMP);
+		if (pending) // previous sample while T converts
+		{
+			pending = 0;
+			acq_cfg.sample(pt,ph,pres);
+			done++;
+		}
+		if (sht_measure_retry(&t,TEMP,acq_measure)!=0) continue;
+
+		rh = (acq_cfg.need_rh==0) || acq_cfg.need_rh(t,res);
+		if (rh) acq_start(HUMI);
+		if (acq_cfg.temp) acq_cfg.temp(t,res); // T while RH converts
+		if (rh && (sht_measure_retry(&acq_h,HUMI,acq_measure)!=0)) continue;
+
+		pt = t; ph = acq_h; pres = res;
+		pending = 1;
+	}
+	if (pending) // last sample
+	{
+		acq_cfg.sample(pt,ph,pres);
+		done++;
+	}
+	return done;
+}
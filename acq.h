@@ -0,0 +1,44 @@
+/*
+ * acq.h
+ *
+ *  Created on: 17.10.2026
+ *      Author: agent
+ *
+ *  Description: pipelined T/RH acquisition (sensor converts while CPU processes)
+ *
+ *  Functions:
+ *  	acq_init(cfg) .. set stage functions
+ *  	acq_run(n) .. acquire n samples back to back (measure task takes 1)
+ *
+ *  Every conversion is started before the CPU work which doesn't need it:
+ *  	T conversion .. sample stage of previous sample (back to back samples only)
+ *  	RH conversion .. T stage of this sample
+ *  the sample stage of the last sample runs after its RH conversion. A back to back
+ *  cycle takes max(T conversion, sample stage) + max(RH conversion, T stage) instead
+ *  of the sum of all four (RH can't start before T is read out).
+ *  With one sample per run only the T stage is overlapped, so all work which needs T
+ *  only (T conversion) belongs there, but nothing visible outside: the sample is dropped
+ *  when its RH fails, so T is published with RH by sample stage. Sample stage of a
+ *  sample runs before T stage of the next one (T stage results can be kept for it).
+ *  Uart transmit runs in interrupts, so the data published by a stage drains
+ *  during the following conversion.
+ *
+ *  Stages run while a measurement is in progress, so they must not use the sensor
+ *  bus. Failed measurements go through sht_measure_retry() (recovery, retries),
+ *  sample is dropped when T or RH fails.
+ */
+
+#ifndef __ACQ_H__
+#define __ACQ_H__
+
+// stage functions (raw register values, resolution SHT_RES_x)
+typedef struct {
+	unsigned char (*need_rh)(unsigned int t, unsigned char res); // RH measured after this T (NULL .. always)
+	void (*temp)(unsigned int t, unsigned char res); // T stage (NULL .. none)
+	void (*sample)(unsigned int t, unsigned int h, unsigned char res); // sample stage (h is the last one when skipped)
+} acq_cfg_t;
+
+void acq_init(const acq_cfg_t *cfg);
+unsigned int acq_run(unsigned int n);
+
+#endif
@@ -0,0 +1,102 @@
+/*
+ * adapt.c
+ *
+ *  Created on: 17.10.2026
+ *      Author: agent
+ *
+ *  Description: adaptive measurement interval (see adapt.h)
+ *
+ *  Functions:
+ *  	adapt_init(cfg) .. configuration
+ *  	adapt_need_rh(t,res) .. RH skip decision (called after T measurement)
+ *  	adapt_update(t,h,res) .. next interval (called after sample)
+ *
+ */
+
+// sensor driver (resolution, raw value difference)
+#include "sht11.h"
+// self
+#include "adapt.h"
+
+/** module local definitions */
+
+// configuration
+adapt_cfg_t adapt_cfg;
+
+// reference sample (last T, last measured RH), its resolution and valid flag
+unsigned int adapt_ref_t, adapt_ref_h;
+unsigned char adapt_ref_res, adapt_valid = 0;
+
+// current interval, quiet samples counter, RH skipped in a row, RH decision
+unsigned long adapt_interval;
+unsigned char adapt_quiet, adapt_skip, adapt_rh;
+
+//----------------------------------------------------------------------------------
+// set configuration (next sample is reference, interval fast)
+//----------------------------------------------------------------------------------
+void adapt_init(const adapt_cfg_t *cfg)
+{
+	adapt_cfg = *cfg;
+	adapt_valid = 0;
+	adapt_interval = cfg->fast;
+}
+
+//----------------------------------------------------------------------------------
+// RH measurement needed (T changed, RH skipped too many times, no reference)
+//----------------------------------------------------------------------------------
+unsigned char adapt_need_rh(unsigned int t, unsigned char res)
+{
+	adapt_rh = 1;
+	if ((adapt_valid==0)||(res!=adapt_ref_res)) return 1;
+	if (sht_raw_delta(t,adapt_ref_t,SHT_T_SHIFT(res))>=adapt_cfg.t_quiet) return 1;
+	if (adapt_skip>=adapt_cfg.rh_skip) return 1;
+	adapt_rh = 0;
+	return 0;
+}
+
+//----------------------------------------------------------------------------------
+// new sample (h is ignored when RH was skipped), returns next interval
+//----------------------------------------------------------------------------------
+unsigned long adapt_update(unsigned int t, unsigned int h, unsigned char res)
+{
+	unsigned int dt, dh = 0;
+
+	if ((adapt_valid==0)||(res!=adapt_ref_res)) // first sample (or resolution changed)
+	{
+		adapt_ref_t = t;
+		adapt_ref_h = h;
+		adapt_ref_res = res;
+		adapt_valid = 1;
+		adapt_quiet = adapt_skip = 0;
+		adapt_interval = adapt_cfg.fast;
+		return adapt_interval;
+	}
+
+	dt = sht_raw_delta(t,adapt_ref_t,SHT_T_SHIFT(res));
+	adapt_ref_t = t;
+	if (adapt_rh)
+	{
+		dh = sht_raw_delta(h,adapt_ref_h,SHT_H_SHIFT(res));
+		adapt_ref_h = h;
+		adapt_skip = 0;
+	}
+	else adapt_skip++;
+
+	if ((dt>=adapt_cfg.t_change)||(dh>=adapt_cfg.h_change)) // change .. fast
+	{
+		adapt_quiet = 0;
+		adapt_interval = adapt_cfg.fast;
+	}
+	else if ((dt<adapt_cfg.t_quiet)&&(dh<adapt_cfg.h_quiet)) // quiet .. slower
+	{
+		if (++adapt_quiet>=adapt_cfg.grow)
+		{
+			adapt_quiet = 0;
+			adapt_interval <<= 1;
+			if (adapt_interval>adapt_cfg.slow) adapt_interval = adapt_cfg.slow;
+		}
+	}
+	else adapt_quiet = 0; // hysteresis band .. keep interval
+
+	return adapt_interval;
+}
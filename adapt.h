@@ -0,0 +1,48 @@
+/*
+ * adapt.h
+ *
+ *  Created on: 17.10.2026
+ *      Author: agent
+ *
+ *  Description: adaptive measurement interval (change driven, with hysteresis)
+ *
+ *  Functions:
+ *  	adapt_init(cfg) .. set configuration, restart at fast interval
+ *  	adapt_need_rh(t,res) .. RH measurement needed after this T (0 skip, reuse last RH)
+ *  	adapt_update(t,h,res) .. new sample (raw register values), returns next interval
+ *
+ *  Deltas are taken between consecutive samples, in high resolution register
+ *  units (14bit T, 12bit RH, low resolution values are scaled up).
+ *  	any delta >= change threshold .. interval snaps back to fast
+ *  	all deltas < quiet threshold .. after cfg.grow such samples interval doubles (up to slow)
+ *  	between thresholds .. interval is kept (hysteresis band, noise doesn't toggle rate)
+ *  RH is skipped while T delta is under quiet threshold, at most cfg.rh_skip times in a row.
+ *
+ *  Interval units are up to the caller (main.c uses scheduler ticks).
+ */
+
+#ifndef __ADAPT_H__
+#define __ADAPT_H__
+
+// configuration
+typedef struct {
+	unsigned int t_quiet, t_change;	// T delta thresholds (14bit register, 0.01 C)
+	unsigned int h_quiet, h_change;	// RH delta thresholds (12bit register, approx. 0.03 %)
+	unsigned char grow;				// quiet samples before interval doubles
+	unsigned char rh_skip;			// max. RH measurements skipped in a row
+	unsigned long fast, slow;		// interval limits
+} adapt_cfg_t;
+
+// default thresholds (T 0.04/0.10 C, RH approx. 0.3/0.8 %)
+#define ADAPT_T_QUIET 4
+#define ADAPT_T_CHANGE 10
+#define ADAPT_H_QUIET 10
+#define ADAPT_H_CHANGE 25
+#define ADAPT_GROW 3
+#define ADAPT_RH_SKIP 3
+
+void adapt_init(const adapt_cfg_t *cfg);
+unsigned char adapt_need_rh(unsigned int t, unsigned char res);
+unsigned long adapt_update(unsigned int t, unsigned int h, unsigned char res);
+
+#endif
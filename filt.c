@@ -0,0 +1,122 @@
+/*
+ * filt.c
+ *
+ *  Created on: 17.10.2026
+ *      Author: agent
+ *
+ *  Description: sample filter in raw register domain (see filt.h)
+ *
+ *  Functions:
+ *  	filt_init(cfg) .. configuration
+ *  	filt_add(t,h,res) .. filtered sample and publish decision (called after sample)
+ *
+ */
+
+// sensor driver (resolution, raw value difference)
+#include "sht11.h"
+// self
+#include "filt.h"
+
+/** module local definitions */
+
+// configuration
+filt_cfg_t filt_cfg;
+
+// one channel (median window, EMA accumulator, last published value)
+typedef struct {
+	unsigned int win[FILT_MEDIAN_MAX];
+	unsigned long acc;
+	unsigned int pub;
+} filt_ch_t;
+
+filt_ch_t filt_t, filt_h;
+
+// samples in median window, next window position, resolution, valid flag, not published count
+unsigned char filt_n, filt_pos, filt_res, filt_valid = 0, filt_held;
+
+//----------------------------------------------------------------------------------
+// median of n values of window (insertion sort of a copy, n <= FILT_MEDIAN_MAX)
+//----------------------------------------------------------------------------------
+static unsigned int filt_median(const unsigned int *win, unsigned char n)
+{
+	unsigned int s[FILT_MEDIAN_MAX], v;
+	unsigned char i, j;
+
+	for (i=0;i<n;i++)
+	{
+		v = win[i];
+		for (j=i;(j>0)&&(s[j-1]>v);j--) s[j] = s[j-1];
+		s[j] = v;
+	}
+	return s[(n-1)>>1];
+}
+
+//----------------------------------------------------------------------------------
+// median and EMA stages of channel (x is the newest value, already in window, thr is
+// publish threshold, shift scales low resolution deltas)
+//----------------------------------------------------------------------------------
+static unsigned int filt_channel(filt_ch_t *ch, unsigned int x, unsigned char first, unsigned int thr, unsigned char shift)
+{
+	unsigned char k = filt_cfg.shift;
+	unsigned long half;
+
+	if (filt_cfg.median>1) x = filt_median(ch->win,filt_n);
+	if (k==0) return x;
+	half = 1UL<<(k-1);
+	// jump far above publish threshold (not noise) restarts average, no lag behind a step
+	if (thr && (sht_raw_delta(x,(ch->acc + half)>>k,shift)>thr*FILT_STEP)) first = 1;
+	// acc = y * 2^k, y += (x - y) / 2^k, y rounded in both places (no bias up or down)
+	if (first) ch->acc = (unsigned long)x<<k;
+	else ch->acc += x - ((ch->acc + half)>>k);
+	return (ch->acc + half)>>k;
+}
+
+//----------------------------------------------------------------------------------
+// set configuration (filter restarts with next sample)
+//----------------------------------------------------------------------------------
+void filt_init(const filt_cfg_t *cfg)
+{
+	filt_cfg = *cfg;
+	if (filt_cfg.median<1) filt_cfg.median = 1;
+	if (filt_cfg.median>FILT_MEDIAN_MAX) filt_cfg.median = FILT_MEDIAN_MAX;
+	if (filt_cfg.shift>8) filt_cfg.shift = 8;
+	filt_valid = 0;
+}
+
+//----------------------------------------------------------------------------------
+// new sample, t and h replaced by filtered values, returns 1 to publish
+//----------------------------------------------------------------------------------
+unsigned char filt_add(unsigned int *t, unsigned int *h, unsigned char res)
+{
+	unsigned int ft, fh;
+	unsigned char first = (filt_valid==0)||(res!=filt_res);
+
+	if (first) // first sample (or resolution changed)
+	{
+		filt_n = filt_pos = 0;
+		filt_res = res;
+	}
+	filt_t.win[filt_pos] = *t;
+	filt_h.win[filt_pos] = *h;
+	if (++filt_pos>=filt_cfg.median) filt_pos = 0;
+	if (filt_n<filt_cfg.median) filt_n++;
+
+	ft = filt_channel(&filt_t,*t,first,filt_cfg.t_thr,SHT_T_SHIFT(res));
+	fh = filt_channel(&filt_h,*h,first,filt_cfg.h_thr,SHT_H_SHIFT(res));
+	*t = ft;
+	*h = fh;
+
+	if (first
+		|| (sht_raw_delta(ft,filt_t.pub,SHT_T_SHIFT(res))>filt_cfg.t_thr)
+		|| (sht_raw_delta(fh,filt_h.pub,SHT_H_SHIFT(res))>filt_cfg.h_thr)
+		|| (filt_cfg.hold && (filt_held>=filt_cfg.hold)))
+	{
+		filt_t.pub = ft;
+		filt_h.pub = fh;
+		filt_valid = 1;
+		filt_held = 0;
+		return 1;
+	}
+	filt_held++;
+	return 0;
+}
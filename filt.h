@@ -0,0 +1,53 @@
+/*
+ * filt.h
+ *
+ *  Created on: 17.10.2026
+ *      Author: agent
+ *
+ *  Description: sample filter in raw register domain (between measurement and conversion)
+ *
+ *  Functions:
+ *  	filt_init(cfg) .. set configuration, restart filter
+ *  	filt_add(t,h,res) .. new sample (raw register values), replaced by filtered ones,
+ *  		returns 1 if the sample is to be published
+ *
+ *  Stages (T and RH the same way):
+ *  	median of last cfg.median samples .. single sample outliers rejected (1 .. off)
+ *  	exponential moving average y += (x - y) / 2^cfg.shift, kept with cfg.shift
+ *  		fractional bits (integer only, no multiplication) (0 .. off), restarted from
+ *  		median value on a jump of more than FILT_STEP thresholds (follows a step at once)
+ *  	publish .. filtered value differs from last published one by more than threshold,
+ *  		or cfg.hold samples were not published (0 .. no limit)
+ *  Thresholds are in high resolution register units (14bit T, 12bit RH, low resolution
+ *  values scaled up). Resolution change restarts the filter (the first sample is published).
+ *  More samples per measure task (main.c TASK_MEASURE_SAMPLES) oversample the filter.
+ */
+
+#ifndef __FILT_H__
+#define __FILT_H__
+
+// max. median window
+#define FILT_MEDIAN_MAX 7
+
+// EMA restart on jump of more than FILT_STEP * threshold (far above sensor noise)
+#define FILT_STEP 8
+
+// configuration
+typedef struct {
+	unsigned char median;			// median window (1 .. FILT_MEDIAN_MAX)
+	unsigned char shift;			// EMA shift (0 .. 8)
+	unsigned int t_thr, h_thr;		// publish thresholds (14bit T, 12bit RH register)
+	unsigned char hold;				// max. samples not published in a row (0 .. no limit)
+} filt_cfg_t;
+
+// default configuration (median of 3, EMA 1/4, T 0.05 C, RH approx. 0.3 %, 12 samples)
+#define FILT_MEDIAN 3
+#define FILT_SHIFT 2
+#define FILT_T_THR 5
+#define FILT_H_THR 8
+#define FILT_HOLD 12
+
+void filt_init(const filt_cfg_t *cfg);
+unsigned char filt_add(unsigned int *t, unsigned int *h, unsigned char res);
+
+#endif
@@ -0,0 +1,343 @@
+/*
+ * history.c
+ *
+ *  Created on: 17.10.2026
+ *      Author: agent
+ *
+ *  Description: sample history module (see history.h for formats)
+ *
+ *  Functions:
+ *  	hist_init() .. initialization (finds newest flash block)
+ *  	hist_add(t,h,res) .. store raw sample
+ *  	hist_sync() .. write open block now
+ *  	hist_count(), hist_get(n,*t,*h) .. RAM ring access
+ *  	hist_dump_start(), hist_dump_getc() .. history dump (uart tx source)
+ *
+ *  Flash is written from main loop only (interrupts are disabled during
+ *  erase/write, approx. 20ms per block). SHT_HOST build keeps flash in RAM.
+ *
+ */
+
+// include section
+#include <stdint.h>
+#ifndef SHT_HOST
+#include <msp430g2553.h>
+#else
+#include <string.h>
+#endif
+// self
+#include "history.h"
+
+/** module local definitions */
+
+#ifndef SHT_HOST
+// flash segment address
+#define HIST_SEG(n) ((unsigned char*)HIST_SEG_ADDR+(unsigned int)(n)*HIST_SEG_SIZE)
+#else
+// simulated flash (test can inspect content and erase counts)
+unsigned char hist_flash[HIST_SEG_COUNT*HIST_SEG_SIZE];
+unsigned int hist_erases[HIST_SEG_COUNT];
+#define HIST_SEG(n) (&hist_flash[(unsigned int)(n)*HIST_SEG_SIZE])
+#endif
+
+// dump states
+enum {HIST_DUMP_IDLE,HIST_DUMP_SEG,HIST_DUMP_BLK,HIST_DUMP_RING,HIST_DUMP_END};
+
+// RAM ring (index of newest sample, count)
+unsigned int hist_ring_t[HIST_RING_LEN], hist_ring_h[HIST_RING_LEN];
+unsigned char hist_ring_ptr = 0, hist_ring_cnt = 0;
+
+// open block (length 0 .. empty), last sample in block, decimation counter
+unsigned char hist_blk[HIST_SEG_SIZE];
+unsigned char hist_blk_len = 0;
+unsigned int hist_last_t, hist_last_h;
+unsigned char hist_decim = HIST_DECIM-1;
+
+// next flash segment and sequence number
+unsigned char hist_seg = 0;
+unsigned int hist_seq = 0;
+
+// dump status (current line: prefix, bytes, position)
+volatile unsigned char hist_dump_state = HIST_DUMP_IDLE;
+unsigned char hist_dump_n;
+char hist_dump_prefix;
+const unsigned char *hist_dump_ptr;
+unsigned char hist_dump_len, hist_dump_pos;
+unsigned char hist_dump_buf[4];
+
+/** flash section */
+
+// flash timing generator from MCLK (= SMCLK, UART_SMCLK as in uart.h), 333kHz: MCLK/3 at 1MHz,
+// MCLK/24 at 8MHz, MCLK/48 at 16MHz
+#ifndef UART_SMCLK
+#define UART_SMCLK 1000000
+#endif
+#define HIST_FLASH_FN (UART_SMCLK/333333-1)
+#if (HIST_FLASH_FN<0)||(HIST_FLASH_FN>63)||(UART_SMCLK/(HIST_FLASH_FN+1)<257000)||(UART_SMCLK/(HIST_FLASH_FN+1)>476000)
+#error "history: no flash clock divider in 257-476kHz for UART_SMCLK"
+#endif
+
+//----------------------------------------------------------------------------------
+// erase segment (only if not erased yet) and write block
+//----------------------------------------------------------------------------------
+static void hist_flash_write(unsigned char seg, const unsigned char *data, unsigned char len)
+{
+	unsigned char *p = HIST_SEG(seg);
+	unsigned char i;
+
+	for (i=0;i<HIST_SEG_SIZE;i++) if (p[i]!=0xFF) break;
+#ifndef SHT_HOST
+	__disable_interrupt();
+	FCTL2 = FWKEY + FSSEL_1 + HIST_FLASH_FN;	// MCLK/(FN+1) (flash timing generator 257-476kHz)
+	FCTL3 = FWKEY;						// unlock (segment A stays locked by LOCKA)
+	if (i<HIST_SEG_SIZE)
+	{
+		FCTL1 = FWKEY + ERASE;			// segment erase
+		*p = 0;							// dummy write starts erase
+	}
+	FCTL1 = FWKEY + WRT;				// byte write
+	for (i=0;i<len;i++) p[i] = data[i];
+	FCTL1 = FWKEY;
+	FCTL3 = FWKEY + LOCK;				// lock
+	__enable_interrupt();
+#else
+	if (i<HIST_SEG_SIZE)
+	{
+		memset(p,0xFF,HIST_SEG_SIZE);
+		hist_erases[seg]++;
+	}
+	for (i=0;i<len;i++) p[i] &= data[i]; // flash can only clear bits
+#endif
+}
+
+/** block section */
+
+//----------------------------------------------------------------------------------
+// write open block to next segment (segments are used in circle)
+//----------------------------------------------------------------------------------
+static void hist_flush(void)
+{
+	if (hist_blk_len==0) return;
+	if (hist_seq==0xFFFF) hist_seq = 0; // 0xFFFF is erased segment
+	hist_blk[0] = hist_seq;
+	hist_blk[1] = hist_seq>>8;
+	hist_flash_write(hist_seg,hist_blk,hist_blk_len);
+	hist_seq++;
+	if (++hist_seg>=HIST_SEG_COUNT) hist_seg = 0;
+	hist_blk_len = 0;
+}
+
+//----------------------------------------------------------------------------------
+// encode difference (zigzag, varint), returns length (1..3)
+//----------------------------------------------------------------------------------
+static unsigned char hist_varint(unsigned char *buf, unsigned int diff)
+{
+	int16_t d = (int16_t)diff;
+	uint16_t z = ((uint16_t)d<<1) ^ (uint16_t)(d>>15);
+	unsigned char len = 0;
+	while (z>=0x80)
+	{
+		buf[len++] = (z&0x7F)|0x80;
+		z >>= 7;
+	}
+	buf[len++] = z;
+	return len;
+}
+
+//----------------------------------------------------------------------------------
+// append sample to open block (full block or resolution change .. flush)
+//----------------------------------------------------------------------------------
+static void hist_block_add(unsigned int t, unsigned int h, unsigned char flags)
+{
+	unsigned char buf[6], len, i;
+
+	if ((hist_blk_len!=0) && ((hist_blk[3]!=flags)||(hist_blk[2]==255))) hist_flush();
+	if (hist_blk_len!=0)
+	{
+		len = hist_varint(buf,t-hist_last_t);
+		len += hist_varint(&buf[len],h-hist_last_h);
+		if ((hist_blk_len+len)<=HIST_SEG_SIZE)
+		{
+			for (i=0;i<len;i++) hist_blk[hist_blk_len++] = buf[i];
+			hist_blk[2]++;
+			hist_last_t = t;
+			hist_last_h = h;
+			return;
+		}
+		hist_flush();
+	}
+	// new block
+	hist_blk[2] = 1;
+	hist_blk[3] = flags;
+	hist_blk[4] = t; hist_blk[5] = t>>8;
+	hist_blk[6] = h; hist_blk[7] = h>>8;
+	hist_blk_len = HIST_HDR_LEN;
+	hist_last_t = t;
+	hist_last_h = h;
+}
+
+/** interface section */
+
+//----------------------------------------------------------------------------------
+// initialization (next segment is the one after newest block)
+//----------------------------------------------------------------------------------
+void hist_init(void)
+{
+	unsigned char n, found = 0;
+	unsigned int seq, last = 0;
+
+	hist_seg = 0;
+	hist_seq = 0;
+	for (n=0;n<HIST_SEG_COUNT;n++)
+	{
+		const unsigned char *p = HIST_SEG(n);
+		seq = p[0] | ((unsigned int)p[1]<<8);
+		if (seq==0xFFFF) continue; // erased
+		if ((found==0) || ((int16_t)(seq-last)>0))
+		{
+			found = 1;
+			last = seq;
+			hist_seg = (n+1<HIST_SEG_COUNT) ? n+1 : 0;
+			hist_seq = seq+1;
+		}
+	}
+}
+
+//----------------------------------------------------------------------------------
+// store sample (RAM ring, every HIST_DECIM-th to flash block)
+//----------------------------------------------------------------------------------
+void hist_add(unsigned int t, unsigned int h, unsigned char res)
+{
+	hist_ring_ptr = (hist_ring_ptr+1)&(HIST_RING_LEN-1);
+	hist_ring_t[hist_ring_ptr] = t;
+	hist_ring_h[hist_ring_ptr] = h;
+	if (hist_ring_cnt<HIST_RING_LEN) hist_ring_cnt++;
+
+	// blocks are postponed while dump reads them
+	if (hist_dump_state!=HIST_DUMP_IDLE) return;
+	if (++hist_decim<HIST_DECIM) return;
+	hist_decim = 0;
+	hist_block_add(t,h,res?HIST_FLAG_LOWRES:0);
+}
+
+//----------------------------------------------------------------------------------
+// write open block now (next samples start new block), postponed while dump runs
+//----------------------------------------------------------------------------------
+void hist_sync(void)
+{
+	if (hist_dump_state!=HIST_DUMP_IDLE) return;
+	hist_flush();
+}
+
+//----------------------------------------------------------------------------------
+// RAM ring access (n=0 newest)
+//----------------------------------------------------------------------------------
+unsigned char hist_count(void)
+{
+	return hist_ring_cnt;
+}
+
+void hist_get(unsigned char n, unsigned int *t, unsigned int *h)
+{
+	unsigned char i = (hist_ring_ptr-n)&(HIST_RING_LEN-1);
+	*t = hist_ring_t[i];
+	*h = hist_ring_h[i];
+}
+
+/** dump section */
+
+//----------------------------------------------------------------------------------
+// start dump (oldest flash block first), returns 1 if dump is running
+//----------------------------------------------------------------------------------
+char hist_dump_start(void)
+{
+	if ((hist_dump_state!=HIST_DUMP_IDLE)||(hist_dump_pos!=0)) return 1;
+	hist_dump_n = 0;
+	hist_dump_pos = 0;
+	hist_dump_state = HIST_DUMP_SEG;
+	return 0;
+}
+
+//----------------------------------------------------------------------------------
+// select next dump line (0 nothing left)
+//----------------------------------------------------------------------------------
+static unsigned char hist_dump_next(void)
+{
+	while (1) switch (hist_dump_state)
+	{
+		case HIST_DUMP_SEG:
+			if (hist_dump_n>=HIST_SEG_COUNT)
+			{
+				hist_dump_state = HIST_DUMP_BLK;
+				break;
+			}
+			{
+				unsigned char seg = hist_seg+hist_dump_n++;
+				if (seg>=HIST_SEG_COUNT) seg -= HIST_SEG_COUNT;
+				hist_dump_ptr = HIST_SEG(seg);
+			}
+			if ((hist_dump_ptr[0]&hist_dump_ptr[1])==0xFF) break; // erased
+			// used length (data never ends with 0xFF)
+			hist_dump_len = HIST_SEG_SIZE;
+			while (hist_dump_ptr[hist_dump_len-1]==0xFF) hist_dump_len--;
+			hist_dump_prefix = 'B';
+			return 1;
+		case HIST_DUMP_BLK:
+			hist_dump_state = HIST_DUMP_RING;
+			hist_dump_n = hist_ring_cnt;
+			if (hist_blk_len==0) break;
+			hist_dump_ptr = hist_blk;
+			hist_dump_len = hist_blk_len;
+			hist_dump_prefix = 'B';
+			return 1;
+		case HIST_DUMP_RING:
+			if (hist_dump_n==0)
+			{
+				hist_dump_state = HIST_DUMP_END;
+				break;
+			}
+			{
+				unsigned int t, h;
+				hist_get(--hist_dump_n,&t,&h);
+				hist_dump_buf[0] = t>>8; hist_dump_buf[1] = t;
+				hist_dump_buf[2] = h>>8; hist_dump_buf[3] = h;
+			}
+			hist_dump_ptr = hist_dump_buf;
+			hist_dump_len = 4;
+			hist_dump_prefix = 'R';
+			return 1;
+		case HIST_DUMP_END:
+			hist_dump_state = HIST_DUMP_IDLE;
+			hist_dump_len = 0;
+			hist_dump_prefix = 'E';
+			return 1;
+		default:
+			return 0;
+	}
+}
+
+//----------------------------------------------------------------------------------
+// next dump character (-1 end of dump)
+//----------------------------------------------------------------------------------
+int hist_dump_getc(void)
+{
+	unsigned char p, b;
+
+	if (hist_dump_pos==0) // line start
+	{
+		if (hist_dump_next()==0) return -1;
+		hist_dump_pos = 1;
+		return hist_dump_prefix;
+	}
+	p = hist_dump_pos-1;
+	if (p<(hist_dump_len<<1))
+	{
+		hist_dump_pos++;
+		b = hist_dump_ptr[p>>1];
+		if ((p&1)==0) b >>= 4;
+		b &= 0x0F;
+		return (b<10) ? ('0'+b) : ('A'+b-10);
+	}
+	hist_dump_pos = 0;
+	return '\n';
+}
@@ -0,0 +1,70 @@
+/*
+ * history.h
+ *
+ *  Created on: 17.10.2026
+ *      Author: agent
+ *
+ *  Description: sample history (RAM ring of raw samples and delta compressed
+ *  	blocks in information flash)
+ *
+ *  Functions:
+ *  	hist_init() .. initialization (finds newest flash block)
+ *  	hist_add(t,h,res) .. store raw sample (register values and resolution)
+ *  	hist_sync() .. write open block to flash now (bounds loss on power off)
+ *  	hist_count() .. samples in RAM ring
+ *  	hist_get(n,*t,*h) .. RAM ring sample (0 newest)
+ *  	hist_dump_start() .. start history dump (0 started, 1 already running)
+ *  	hist_dump_getc() .. next dump character (-1 end), uart tx source
+ *
+ *  Every sample goes to the RAM ring, every HIST_DECIM-th one is appended to
+ *  the open block. A full block is written to the next flash segment (segments
+ *  are used in circle, so all of them wear the same, one erase per block).
+ *
+ *  Block format (HIST_SEG_SIZE bytes, little endian, unused bytes 0xFF):
+ *  	0..1 .. sequence number (0xFFFF erased segment)
+ *  	2 .. sample count
+ *  	3 .. flags (bit 0 .. low resolution)
+ *  	4..7 .. first sample (T, RH register values)
+ *  	8.. .. next samples as differences (dT, dRH), zigzag, varint (7 bits per byte)
+ *
+ *  Dump format (text lines):
+ *  	Bxxxx.. .. block (hex bytes) oldest first, the open block last
+ *  	Rttttdddd .. RAM ring sample (hex T, RH register values) oldest first
+ *  	E .. end of dump
+ */
+
+#ifndef __HISTORY_H__
+#define __HISTORY_H__
+
+// flash segments (default info flash D, C, B .. segment A holds calibration data)
+#ifndef HIST_SEG_ADDR
+#define HIST_SEG_ADDR 0x1000
+#endif
+#ifndef HIST_SEG_COUNT
+#define HIST_SEG_COUNT 3
+#endif
+#define HIST_SEG_SIZE 64
+
+// RAM ring length (samples, power of 2)
+#ifndef HIST_RING_LEN
+#define HIST_RING_LEN 16
+#endif
+
+// flash decimation (every 12th sample, 1 minute at 5s period)
+#ifndef HIST_DECIM
+#define HIST_DECIM 12
+#endif
+
+// block header length and flags
+#define HIST_HDR_LEN 8
+#define HIST_FLAG_LOWRES 0x01
+
+void hist_init(void);
+void hist_add(unsigned int t, unsigned int h, unsigned char res);
+void hist_sync(void);
+unsigned char hist_count(void);
+void hist_get(unsigned char n, unsigned int *t, unsigned int *h);
+char hist_dump_start(void);
+int hist_dump_getc(void);
+
+#endif
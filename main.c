@@ -36,60 +36,269 @@
 #include "timer.h"
 #include "sht11.h"
 #include "sht11con.h"
+#include "history.h"
+#include "proto.h"
+#include "prof.h"
+#include "adapt.h"
+#include "filt.h"
+#include "acq.h"
 
 #ifdef DEBUG
 #include "uart.h"
 #endif
 
 // board (leds, button)
-#define LED_INIT() {P1DIR|=0x41;P1OUT&=~0x41;}
 #define LED_RED_ON() {P1OUT|=0x01;}
 #define LED_RED_OFF() {P1OUT&=~0x01;}
 #define LED_RED_SWAP() {P1OUT^=0x01;}
+#ifndef SHT_SPI
+#define LED_INIT() {P1DIR|=0x41;P1OUT&=~0x41;}
 #define LED_GREEN_ON() {P1OUT|=0x40;}
 #define LED_GREEN_OFF() {P1OUT&=~0x40;}
 #define LED_GREEN_SWAP() {P1OUT^=0x40;}
+#else // P1.6 is sensor DATA (USCI_B0 SOMI)
+#define LED_INIT() {P1DIR|=0x01;P1OUT&=~0x01;}
+#define LED_GREEN_ON()
+#define LED_GREEN_OFF()
+#define LED_GREEN_SWAP()
+#endif
+
+// DCO calibration for MCLK = SMCLK (UART_SMCLK, the same define as uart.h and sht11hal.h)
+#ifndef UART_SMCLK
+#define UART_SMCLK 1000000
+#endif
+#if UART_SMCLK==16000000
+#define DCO_CALBC1 CALBC1_16MHZ
+#define DCO_CALDCO CALDCO_16MHZ
+#elif UART_SMCLK==8000000
+#define DCO_CALBC1 CALBC1_8MHZ
+#define DCO_CALDCO CALDCO_8MHZ
+#elif UART_SMCLK==1000000
+#define DCO_CALBC1 CALBC1_1MHZ
+#define DCO_CALDCO CALDCO_1MHZ
+#else
+#error "main: no DCO calibration for UART_SMCLK"
+#endif
 
 // hw depended init
 void board_init(void)
 {
 	// oscillator
-	BCSCTL1 = CALBC1_1MHZ;		// Set DCO
-	DCOCTL = CALDCO_1MHZ;
+	BCSCTL1 = DCO_CALBC1;		// Set DCO
+	DCOCTL = DCO_CALDCO;
+	BCSCTL3 |= LFXT1S_2;		// ACLK = VLO (scheduler, sht asynchronous measurement)
 
 	LED_INIT(); // leds
 }
 
+
+#ifdef DEBUG
+// sensor error counters dump (uart 'e'), hex line: noack,timeout,crc,connresets,softresets,recovered,failed
+#define ERR_COUNTERS (sizeof(sht_err_stats_t)/sizeof(unsigned int))
+sht_err_stats_t err_dump;
+unsigned char err_dump_n = ERR_COUNTERS, err_dump_d = 0;
+
+int err_dump_getc(void)
+{
+	unsigned int v;
+	if (err_dump_n>=ERR_COUNTERS) return -1;
+	if (err_dump_d==4) // separator after 4 digits
+	{
+		err_dump_d = 0;
+		err_dump_n++;
+		return (err_dump_n==ERR_COUNTERS)?'\n':',';
+	}
+	v = (((unsigned int*)&err_dump)[err_dump_n]>>(12-4*err_dump_d))&0x0F;
+	err_dump_d++;
+	return (v<10)?('0'+v):('A'+v-10);
+}
+
+// uart commands (binary frames, 'h' .. history dump, 'e' .. sensor errors, 'p' .. profiling stats),
+// returns 1 if handled
+int uart_command(char c)
+{
+	if (proto_rx(c)) return 1;
+	if (c=='h')
+	{
+		if (hist_dump_start()==0) uart_send_source(hist_dump_getc);
+		return 1;
+	}
+	if (c=='e')
+	{
+		if (err_dump_n>=ERR_COUNTERS) // not running
+		{
+			sht_get_err_stats(&err_dump);
+			err_dump_n = 0;
+			if (uart_send_source(err_dump_getc)!=0) err_dump_n = ERR_COUNTERS;
+		}
+		return 1;
+	}
+	#ifdef SHT_PROF
+	if (c=='p')
+	{
+		if (prof_dump_start()==0) uart_send_source(prof_dump_getc);
+		return 1;
+	}
+	#endif
+	return 0;
+}
+#endif
+
+// task periods (measure interval can be changed at runtime by sched_set_period)
+#define TASK_MEASURE_PERIOD TIMER_S(5)
+#define TASK_TRANSMIT_PERIOD TIMER_S(60)
+#define TASK_FLUSH_PERIOD TIMER_S(3600)
+
+// samples per measure task (back to back, conversions overlapped with processing, see acq.h)
+#define TASK_MEASURE_SAMPLES 1
+
+char task_measure_id;
+
+#ifdef DEBUG
+// '?' answer not published (back buffer was being sent), retried by transmit task
+unsigned char debug_unpublished = 0;
+#endif
+
+#ifdef SHT_ADAPT
+// adaptive measurement interval (5s .. 80s)
+const adapt_cfg_t adapt_config = {ADAPT_T_QUIET,ADAPT_T_CHANGE,ADAPT_H_QUIET,ADAPT_H_CHANGE,
+	ADAPT_GROW,ADAPT_RH_SKIP,TASK_MEASURE_PERIOD,16*TASK_MEASURE_PERIOD};
+unsigned long measure_period = TASK_MEASURE_PERIOD;
+#endif
+
+#ifdef SHT_FILT
+// raw sample filter (median, EMA, published on change or after a minute)
+const filt_cfg_t filt_config = {FILT_MEDIAN,FILT_SHIFT,FILT_T_THR,FILT_H_THR,FILT_HOLD};
+#endif
+
+#if defined(DEBUG) && !defined(SHT_FILT)
+// T of the sample being measured (converted by T stage, used by its sample stage)
+int16_t stage_TvalC;
+
+// T stage (runs while RH converts) - T conversion only, debug values are set by sample
+// stage (a failed RH readout must not leave this T next to RH of the previous sample)
+void stage_temp(unsigned int Tval, unsigned char res)
+{
+	if (res==SHT_RES_LOW) sht2int_lowres(Tval,0,&stage_TvalC,0);
+	else sht2int(Tval,0,&stage_TvalC,0);
+}
+#endif
+
+// sample stage (filter, history, measure interval, RH conversion, debug values, stream),
+// runs while the next T converts when samples go back to back
+void stage_sample(unsigned int Tval, unsigned int Hval, unsigned char res)
+{
+	#ifdef DEBUG
+	int16_t TvalC,HvalC;
+	#endif
+	#ifdef SHT_FILT
+	unsigned char publish = filt_add(&Tval,&Hval,res); // filtered raw values
+	#endif
+	hist_add(Tval,Hval,res); // raw values to history (filtered with SHT_FILT)
+	#ifdef SHT_ADAPT
+	{
+		unsigned long period = adapt_update(Tval,Hval,res);
+		if (period!=measure_period)
+		{
+			measure_period = period;
+			sched_set_period(task_measure_id,period);
+		}
+	}
+	#endif
+	#ifdef SHT_FILT
+	if (publish==0) return; // no change above threshold (nothing converted or sent)
+	#endif
+	#ifdef DEBUG
+	#ifdef SHT_FILT
+	if (res==SHT_RES_LOW) sht2int_lowres(Tval,Hval,&TvalC,&HvalC);
+	else sht2int(Tval,Hval,&TvalC,&HvalC);
+	#else
+	TvalC = stage_TvalC; // converted while RH was converting
+	if (res==SHT_RES_LOW) sht2int_lowres(Tval,Hval,0,&HvalC);
+	else sht2int(Tval,Hval,0,&HvalC);
+	#endif
+	set_debug_value(int2bcd(TvalC),0);
+	set_debug_value(int2bcd(HvalC),1);
+	set_debug_value(int2bcd(sht_dewpoint(TvalC,HvalC)),2);
+	set_debug_value(int2bcd(sht_abshum(TvalC,HvalC)),3);
+	debug_unpublished = (publish_debug_values()!=0); // '?' answer (T and RH of one sample)
+	proto_sample(TvalC,HvalC); // binary protocol (stream)
+	#endif
+}
+
+// acquisition stages (RH skipped while T is steady with SHT_ADAPT)
+const acq_cfg_t acq_config = {
+	#ifdef SHT_ADAPT
+	adapt_need_rh,
+	#else
+	0,
+	#endif
+	#if defined(DEBUG) && !defined(SHT_FILT)
+	stage_temp,
+	#else
+	0,
+	#endif
+	stage_sample};
+
+// measure task (pipelined sensor readout, bus recovery and retries inside)
+void task_measure(void)
+{
+	LED_GREEN_ON();
+	acq_run(TASK_MEASURE_SAMPLES);
+	LED_GREEN_OFF();
+}
+
+#ifdef DEBUG
+// transmit task (stream samples not sent yet, host gets data at least once per period)
+void task_transmit(void)
+{
+	if (debug_unpublished) debug_unpublished = (publish_debug_values()!=0);
+	proto_flush();
+}
+#endif
+
+// flash flush task (open history block to flash, limits loss on power off)
+void task_flush(void)
+{
+	hist_sync();
+}
+
 // main program body
 int main(void)
 {
 	WDTCTL = WDTPW + WDTHOLD;	// Stop WDT
 
 	board_init(); 	// init oscilator and leds
-	timer_init(); 	// init timer
+	timer_init(); 	// init timer (scheduler)
 	sht11_init(); 	// init sht sensor
+	hist_init(); 	// init history (flash blocks)
 
 	#ifdef DEBUG
 	uart_init(); // init debug interface
 	set_debug_value(0x0,0);	// store value for debug interface
 	set_debug_value(0x0,1);
+	set_debug_value(0x0,2);
+	set_debug_value(0x0,3);
+	publish_debug_values();
+	uart_set_rx_handler(uart_command);
 	#endif
 
+	#ifdef SHT_ADAPT
+	adapt_init(&adapt_config);
+	#endif
+	#ifdef SHT_FILT
+	filt_init(&filt_config);
+	#endif
+	acq_init(&acq_config);
+	task_measure_id = sched_add(task_measure,TASK_MEASURE_PERIOD);
+	#ifdef DEBUG
+	sched_add(task_transmit,TASK_TRANSMIT_PERIOD);
+	#endif
+	sched_add(task_flush,TASK_FLUSH_PERIOD);
+
 	while(1)
 	{
-		unsigned int Tval,Hval;
-		int TvalC,HvalC;
-		LED_GREEN_ON();
-		if ((sht_measure_check(&Tval,TEMP)==0) && (sht_measure_check(&Hval,HUMI)==0))
-		{
-			sht2int(Tval,Hval,&TvalC,&HvalC);
-			#ifdef DEBUG
-			set_debug_value(int2bcd(TvalC),0);
-			set_debug_value(int2bcd(HvalC),1);
-			#endif
-		}
-	    LED_GREEN_OFF();
-		__bis_SR_register(CPUOFF + GIE); // enter sleep mode (leave on timer interrupt)
+		sched_run(); // run due tasks, sleep in LPM3 between them
 	}
 
 	return -1;
@@ -0,0 +1,147 @@
+/*
+ * prof.c
+ *
+ *  Created on: 17.10.2026
+ *      Author: agent
+ *
+ *  Description: cycle profiling stats table (see prof.h, built only with SHT_PROF)
+ *
+ *  Functions:
+ *  	prof_add(phase,ticks) .. add phase duration (called from phases end, also interrupts)
+ *  	prof_get(phase,*stat), prof_reset() .. stats table access
+ *  	prof_dump_start(), prof_dump_getc() .. stats table dump (uart tx source)
+ *
+ */
+
+// self
+#include "prof.h"
+
+#ifdef SHT_PROF
+
+#ifdef SHT_HOST
+#define __get_interrupt_state() 0
+#define __set_interrupt_state(x) ((void)(x))
+#define __disable_interrupt()
+#endif
+
+/** module local definitions */
+
+// stats table
+prof_stat_t prof_tab[PROF_PHASES];
+
+// dump status (phase of current line, line buffer, position)
+volatile unsigned char prof_dump_active = 0;
+unsigned char prof_dump_n;
+char prof_dump_line[36];
+unsigned char prof_dump_len, prof_dump_pos;
+
+/** stats section */
+
+//----------------------------------------------------------------------------------
+// add phase duration (count saturates, so mean stays valid)
+//----------------------------------------------------------------------------------
+void prof_add(unsigned char phase, unsigned int ticks)
+{
+	prof_stat_t *s = &prof_tab[phase];
+	if (s->count==0xFFFF) return;
+	if ((s->count==0)||(ticks<s->min)) s->min = ticks;
+	if (ticks>s->max) s->max = ticks;
+	s->sum += ticks;
+	s->count++;
+}
+
+//----------------------------------------------------------------------------------
+// get phase stats (copy, interrupts can add meanwhile)
+//----------------------------------------------------------------------------------
+void prof_get(unsigned char phase, prof_stat_t *stat)
+{
+	unsigned int ie = __get_interrupt_state();
+	__disable_interrupt();
+	*stat = prof_tab[phase];
+	__set_interrupt_state(ie);
+}
+
+//----------------------------------------------------------------------------------
+// clear stats table
+//----------------------------------------------------------------------------------
+void prof_reset(void)
+{
+	unsigned char i;
+	unsigned int ie = __get_interrupt_state();
+	__disable_interrupt();
+	for (i=0;i<PROF_PHASES;i++)
+	{
+		prof_tab[i].count = 0;
+		prof_tab[i].min = prof_tab[i].max = 0;
+		prof_tab[i].sum = 0;
+	}
+	__set_interrupt_state(ie);
+}
+
+/** dump section */
+
+//----------------------------------------------------------------------------------
+// hex digits to line buffer
+//----------------------------------------------------------------------------------
+static void prof_hex(unsigned long v, unsigned char digits)
+{
+	while (digits--)
+	{
+		unsigned char d = (v>>(digits*4))&0x0F;
+		prof_dump_line[prof_dump_len++] = (d<10) ? ('0'+d) : ('A'+d-10);
+	}
+}
+
+//----------------------------------------------------------------------------------
+// start dump, returns 1 if dump is running
+//----------------------------------------------------------------------------------
+char prof_dump_start(void)
+{
+	if (prof_dump_active) return 1;
+	prof_dump_n = 0;
+	prof_dump_len = prof_dump_pos = 0;
+	prof_dump_active = 1;
+	return 0;
+}
+
+//----------------------------------------------------------------------------------
+// next dump character (-1 end of dump)
+//----------------------------------------------------------------------------------
+int prof_dump_getc(void)
+{
+	if (prof_dump_pos>=prof_dump_len) // next line
+	{
+		prof_stat_t s;
+		prof_dump_len = prof_dump_pos = 0;
+		if (prof_dump_n>PROF_PHASES)
+		{
+			prof_dump_active = 0;
+			return -1;
+		}
+		if (prof_dump_n==PROF_PHASES)
+		{
+			prof_dump_line[prof_dump_len++] = 'E';
+		}
+		else
+		{
+			prof_get(prof_dump_n,&s);
+			prof_dump_line[prof_dump_len++] = 'P';
+			prof_hex(prof_dump_n,1);
+			prof_dump_line[prof_dump_len++] = ',';
+			prof_hex(s.count,4);
+			prof_dump_line[prof_dump_len++] = ',';
+			prof_hex((unsigned long)s.min*PROF_TICK_CYCLES,8);
+			prof_dump_line[prof_dump_len++] = ',';
+			prof_hex((unsigned long)s.max*PROF_TICK_CYCLES,8);
+			prof_dump_line[prof_dump_len++] = ',';
+			// mean divided first (sum*PROF_TICK_CYCLES overflows after 2^29 ticks),
+			// remainder keeps it exact
+			prof_hex(s.count ? (s.sum/s.count)*PROF_TICK_CYCLES+(s.sum%s.count)*PROF_TICK_CYCLES/s.count : 0,8);
+		}
+		prof_dump_line[prof_dump_len++] = '\n';
+		prof_dump_n++;
+	}
+	return prof_dump_line[prof_dump_pos++];
+}
+
+#endif
@@ -0,0 +1,87 @@
+/*
+ * prof.h
+ *
+ *  Created on: 17.10.2026
+ *      Author: agent
+ *
+ *  Description: cycle profiling of driver phases (opt-in, build with SHT_PROF)
+ *
+ *  Functions:
+ *  	prof_add(phase,ticks) .. add phase duration to stats table
+ *  	prof_get(phase,*stat) .. phase stats
+ *  	prof_reset() .. clear stats table
+ *  	prof_dump_start(), prof_dump_getc() .. stats table dump (uart tx source)
+ *
+ *  Macros (empty without SHT_PROF):
+ *  	PROF_START(v) .. declare v and store timestamp
+ *  	PROF_END(phase,v) .. add time from v to phase stats
+ *
+ *  Timestamps are taken from free running Timer_A (timer.c runs it from SMCLK/8
+ *  instead of ACLK in SHT_PROF build), so the resolution is 8 cycles and a phase
+ *  must be shorter than 0.5s (at 1MHz SMCLK, UART_SMCLK). The CPU sleeps in LPM0
+ *  there (scheduler and conversion wait), so the timer keeps counting while asleep.
+ *  SHT_HOST build takes timestamps from simulator (test/shtsim) the same way.
+ *
+ *  Dump format (text lines, hex, durations in cycles):
+ *  	Pphase,count,min,max,mean
+ *  	E .. end of dump
+ */
+
+#ifndef __PROF_H__
+#define __PROF_H__
+
+// profiled phases
+enum {
+	PROF_TRANSSTART,	// sht_transstart()
+	PROF_WRITE_BYTE,	// sht_write_byte()
+	PROF_WAIT,			// sht_measure() conversion wait loop
+	PROF_READ,			// sht_measure_read()
+	PROF_READ_ISR,		// one asynchronous readout interrupt
+	PROF_SHT2INT,		// sht2int()
+	PROF_INT2BCD,		// int2bcd()
+	PROF_DEWPOINT,		// sht_dewpoint()
+	PROF_READ_BYTE,		// sht_read_byte()
+	PROF_PHASES
+};
+
+// cycles per timestamp tick
+#define PROF_TICK_CYCLES 8
+
+// phase stats (ticks)
+typedef struct {
+	unsigned int count;
+	unsigned int min, max;
+	unsigned long sum;
+} prof_stat_t;
+
+#ifdef SHT_PROF
+
+#if defined(UART_SMCLK)&&(UART_SMCLK!=1000000)
+#error "prof: SHT_PROF timestamps (16 bit, SMCLK/8) need UART_SMCLK 1MHz"
+#endif
+
+#ifndef SHT_HOST
+#include <msp430g2553.h>
+#define PROF_NOW() TAR
+#else
+unsigned int shtsim_tar(void);
+#define PROF_NOW() shtsim_tar()
+#endif
+
+#define PROF_START(v) unsigned int v = PROF_NOW()
+#define PROF_END(phase,v) prof_add((phase),PROF_NOW()-(v))
+
+void prof_add(unsigned char phase, unsigned int ticks);
+void prof_get(unsigned char phase, prof_stat_t *stat);
+void prof_reset(void);
+char prof_dump_start(void);
+int prof_dump_getc(void);
+
+#else
+
+#define PROF_START(v)
+#define PROF_END(phase,v)
+
+#endif
+
+#endif
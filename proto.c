@@ -0,0 +1,285 @@
+/*
+ * proto.c
+ *
+ *  Created on: 17.10.2026
+ *      Author: agent
+ *
+ *  Description: binary framed uart protocol (see proto.h for frame format)
+ *
+ *  Functions:
+ *  	proto_rx(c) .. command frame receiver (called from uart rx interrupt)
+ *  	proto_sample(t,h) .. collect sample for stream (called from main loop)
+ *  	proto_flush() .. send collected samples before the frame is full
+ *  	proto_drops() .. dropped frames/samples counter
+ *
+ *  Frames are sent by uart tx source (one frame buffer), answers which come
+ *  while a frame is being sent are queued and sent right after it. While other
+ *  source runs (history dump) the frames wait for it, if uart can't take them
+ *  stream data is dropped and answers (ack, poll) stay pending for next send.
+ *
+ */
+
+// include section
+#ifndef SHT_HOST
+#include <msp430g2553.h>
+#else
+#define __disable_interrupt()
+#define __enable_interrupt()
+#endif
+
+#include "uart.h"
+#include "sht11.h" // crc
+// self
+#include "proto.h"
+
+/** module local definitions */
+
+// receiver states
+enum {PROTO_RX_SYNC,PROTO_RX_TYPE,PROTO_RX_SEQ,PROTO_RX_LEN,PROTO_RX_DATA,PROTO_RX_CRC};
+
+// pending answers
+#define PROTO_PEND_ACK 0x01
+#define PROTO_PEND_POLL 0x02
+#define PROTO_PEND_DATA 0x04
+
+// transmitter (frame buffer, length, position, busy flag, frame counter)
+unsigned char proto_tx[PROTO_FRAME_MAX];
+unsigned char proto_tx_len, proto_tx_pos;
+volatile unsigned char proto_tx_busy = 0;
+unsigned char proto_tx_seq = 0;
+volatile unsigned char proto_pending = 0;
+unsigned char proto_ack_seq, proto_ack_res;
+
+// receiver (state, frame, crc)
+unsigned char proto_rx_state = PROTO_RX_SYNC;
+unsigned char proto_rx_type, proto_rx_seq, proto_rx_len, proto_rx_pos;
+unsigned char proto_rx_data[PROTO_RX_MAX];
+sht_crc_t proto_rx_crc;
+
+// samples (last one for polling, collected ones for stream)
+int proto_last[PROTO_CHANNELS];
+int proto_smp[PROTO_MAX_SAMPLES][PROTO_CHANNELS];
+unsigned char proto_smp_cnt = 0;
+unsigned char proto_stream = 0; // samples per frame (0 .. stream off)
+unsigned int proto_drop_cnt = 0;
+
+/** transmitter section */
+
+//----------------------------------------------------------------------------------
+// build frame (header, payload already in buffer from index 4, crc)
+//----------------------------------------------------------------------------------
+static void proto_frame(unsigned char type, unsigned char len)
+{
+	sht_crc_t crc;
+	unsigned char i;
+
+	proto_tx[0] = PROTO_SYNC;
+	proto_tx[1] = type;
+	proto_tx[2] = proto_tx_seq++;
+	proto_tx[3] = len;
+	sht_crc_init(&crc,0);
+	for (i=1;i<len+4;i++) sht_crc_update(&crc,proto_tx[i]);
+	proto_tx[len+4] = sht_crc_final(&crc);
+	proto_tx_len = len+PROTO_OVERHEAD;
+	proto_tx_pos = 0;
+}
+
+//----------------------------------------------------------------------------------
+// build data frame (count samples from buf)
+//----------------------------------------------------------------------------------
+static void proto_frame_data(int (*buf)[PROTO_CHANNELS], unsigned char count)
+{
+	unsigned char i, ch, *p = &proto_tx[6];
+
+	proto_tx[4] = count;
+	proto_tx[5] = PROTO_CHANNELS;
+	for (i=0;i<count;i++)
+		for (ch=0;ch<PROTO_CHANNELS;ch++)
+		{
+			*p++ = buf[i][ch];
+			*p++ = (unsigned int)buf[i][ch]>>8;
+		}
+	proto_frame(PROTO_DATA,2+count*PROTO_CHANNELS*2);
+}
+
+//----------------------------------------------------------------------------------
+// build next pending frame (0 nothing pending)
+//----------------------------------------------------------------------------------
+static unsigned char proto_next(void)
+{
+	if (proto_pending&PROTO_PEND_ACK)
+	{
+		proto_pending &= ~PROTO_PEND_ACK;
+		proto_tx[4] = proto_ack_seq;
+		proto_tx[5] = proto_ack_res;
+		proto_frame(PROTO_ACK,2);
+		return 1;
+	}
+	if (proto_pending&PROTO_PEND_POLL)
+	{
+		proto_pending &= ~PROTO_PEND_POLL;
+		proto_frame_data(&proto_last,1);
+		return 1;
+	}
+	if (proto_pending&PROTO_PEND_DATA)
+	{
+		proto_pending &= ~PROTO_PEND_DATA;
+		proto_frame_data(proto_smp,proto_smp_cnt);
+		proto_smp_cnt = 0;
+		return 1;
+	}
+	return 0;
+}
+
+//----------------------------------------------------------------------------------
+// uart tx source (next frame byte, pending frames follow, -1 when all sent)
+//----------------------------------------------------------------------------------
+static int proto_getc(void)
+{
+	if (proto_tx_pos>=proto_tx_len)
+	{
+		if (proto_next()==0)
+		{
+			proto_tx_busy = 0;
+			return -1;
+		}
+	}
+	return proto_tx[proto_tx_pos++];
+}
+
+//----------------------------------------------------------------------------------
+// send pending frames (call with interrupts disabled)
+//----------------------------------------------------------------------------------
+static void proto_send(void)
+{
+	if (proto_tx_busy) return; // sent after current frame
+	proto_tx_len = proto_tx_pos = 0;
+	proto_tx_busy = 1;
+	if (uart_queue_source(proto_getc)!=0) // uart used by other sources (dump running, one waiting)
+	{
+		proto_tx_busy = 0;
+		if (proto_pending&PROTO_PEND_DATA) // stream data dropped, answers retried by next send
+		{
+			proto_pending &= ~PROTO_PEND_DATA;
+			proto_smp_cnt = 0;
+			proto_drop_cnt++;
+		}
+	}
+}
+
+/** receiver section */
+
+//----------------------------------------------------------------------------------
+// execute received command
+//----------------------------------------------------------------------------------
+static void proto_command(void)
+{
+	proto_ack_seq = proto_rx_seq;
+	proto_ack_res = 0;
+	switch (proto_rx_type)
+	{
+		case PROTO_CMD_POLL:
+			proto_pending |= PROTO_PEND_POLL;
+			break;
+		case PROTO_CMD_STREAM:
+			if ((proto_rx_len==1)&&(proto_rx_data[0]<=PROTO_MAX_SAMPLES))
+			{
+				proto_stream = proto_rx_data[0];
+				proto_smp_cnt = 0;
+			}
+			else proto_ack_res = 1;
+			proto_pending |= PROTO_PEND_ACK;
+			break;
+		default:
+			proto_ack_res = 1;
+			proto_pending |= PROTO_PEND_ACK;
+			break;
+	}
+	proto_send();
+}
+
+//----------------------------------------------------------------------------------
+// received char (returns 0 if char is not part of a frame)
+//----------------------------------------------------------------------------------
+int proto_rx(char c)
+{
+	unsigned char b = c;
+
+	if ((proto_rx_state!=PROTO_RX_SYNC)&&(proto_rx_state!=PROTO_RX_CRC)) sht_crc_update(&proto_rx_crc,b);
+	switch (proto_rx_state)
+	{
+		case PROTO_RX_SYNC:
+			if (b!=PROTO_SYNC) return 0;
+			sht_crc_init(&proto_rx_crc,0);
+			proto_rx_state = PROTO_RX_TYPE;
+			break;
+		case PROTO_RX_TYPE:
+			proto_rx_type = b;
+			proto_rx_state = PROTO_RX_SEQ;
+			break;
+		case PROTO_RX_SEQ:
+			proto_rx_seq = b;
+			proto_rx_state = PROTO_RX_LEN;
+			break;
+		case PROTO_RX_LEN:
+			proto_rx_len = b;
+			proto_rx_pos = 0;
+			if (b>PROTO_RX_MAX) proto_rx_state = PROTO_RX_SYNC; // not a command frame
+			else proto_rx_state = (b!=0) ? PROTO_RX_DATA : PROTO_RX_CRC;
+			break;
+		case PROTO_RX_DATA:
+			proto_rx_data[proto_rx_pos++] = b;
+			if (proto_rx_pos>=proto_rx_len) proto_rx_state = PROTO_RX_CRC;
+			break;
+		default: // crc
+			proto_rx_state = PROTO_RX_SYNC;
+			if (b==sht_crc_final(&proto_rx_crc)) proto_command();
+			break;
+	}
+	return 1;
+}
+
+/** interface section */
+
+//----------------------------------------------------------------------------------
+// new sample (stream frame is sent when it has requested count of samples)
+//----------------------------------------------------------------------------------
+void proto_sample(int t, int h)
+{
+	__disable_interrupt();
+	proto_last[0] = t;
+	proto_last[1] = h;
+	if (proto_stream!=0)
+	{
+		if (proto_smp_cnt>=PROTO_MAX_SAMPLES) // previous frame still waiting
+		{
+			proto_smp_cnt = 0;
+			proto_drop_cnt++;
+		}
+		proto_smp[proto_smp_cnt][0] = t;
+		proto_smp[proto_smp_cnt][1] = h;
+		proto_smp_cnt++;
+		if (proto_smp_cnt>=proto_stream) proto_pending |= PROTO_PEND_DATA;
+	}
+	if (proto_pending) proto_send(); // new frame or answers waiting for uart
+	__enable_interrupt();
+}
+
+//----------------------------------------------------------------------------------
+// send collected stream samples now (shorter data frame)
+//----------------------------------------------------------------------------------
+void proto_flush(void)
+{
+	__disable_interrupt();
+	if (proto_smp_cnt!=0) proto_pending |= PROTO_PEND_DATA;
+	if (proto_pending) proto_send(); // also answers waiting for uart
+	__enable_interrupt();
+}
+
+//----------------------------------------------------------------------------------
+// dropped frames/samples
+//----------------------------------------------------------------------------------
+unsigned int proto_drops(void)
+{
+	return proto_drop_cnt;
+}
@@ -0,0 +1,67 @@
+/*
+ * proto.h
+ *
+ *  Created on: 17.10.2026
+ *      Author: agent
+ *
+ *  Description: binary framed uart protocol (polling and streaming of samples)
+ *
+ *  Functions:
+ *  	proto_rx(c) .. received char (uart rx handler, returns 1 if char belongs to frame)
+ *  	proto_sample(t,h) .. new sample (T, RH * 10), sent when stream frame is full
+ *  	proto_flush() .. send collected stream samples now (periodic transmit task), also
+ *  		answers which waited for uart
+ *  	proto_drops() .. frames/samples dropped (transmitter busy)
+ *
+ *  Frame (both directions):
+ *  	0 .. sync 0xA5
+ *  	1 .. type
+ *  	2 .. sequence number (device counts its frames, host its commands)
+ *  	3 .. payload length
+ *  	4.. .. payload
+ *  	last .. crc (bytes 1 .. end of payload, the same crc-8 as sensor, start value 0)
+ *
+ *  Commands (host -> device):
+ *  	PROTO_CMD_POLL .. no payload, answer is data frame with last sample
+ *  	PROTO_CMD_STREAM .. payload samples per frame (1 .. PROTO_MAX_SAMPLES, 0 stop),
+ *  		answer is ack frame, then data frame after every n samples
+ *
+ *  Answers (device -> host):
+ *  	PROTO_DATA .. payload sample count, channels, values (int16 little endian, sample by sample)
+ *  	PROTO_ACK .. payload command sequence number, result (0 ok, 1 bad command)
+ *
+ *  Frames with wrong crc are ignored (host repeats the command after timeout).
+ *  Gaps in data frame sequence numbers mean dropped frames.
+ */
+
+#ifndef __PROTO_H__
+#define __PROTO_H__
+
+// frame sync
+#define PROTO_SYNC 0xA5
+
+// frame types
+#define PROTO_CMD_POLL 0x01
+#define PROTO_CMD_STREAM 0x02
+#define PROTO_DATA 0x81
+#define PROTO_ACK 0x82
+
+// channels (T, RH) and max. samples per data frame
+#define PROTO_CHANNELS 2
+#ifndef PROTO_MAX_SAMPLES
+#define PROTO_MAX_SAMPLES 4
+#endif
+
+// max. command payload
+#define PROTO_RX_MAX 4
+
+// frame overhead (sync, type, seq, len, crc) and max. data frame length
+#define PROTO_OVERHEAD 5
+#define PROTO_FRAME_MAX (PROTO_OVERHEAD+2+PROTO_MAX_SAMPLES*PROTO_CHANNELS*2)
+
+int proto_rx(char c);
+void proto_sample(int t, int h);
+void proto_flush(void);
+unsigned int proto_drops(void);
+
+#endif
@@ -8,7 +8,7 @@
  *
  *  interface functions:
  *
- *		sht11_init() .. module initialization (setting ports)
+ *		sht11_init() .. module initialization (setting ports, resolution)
  * 		sht_measure_start(mode) .. send start measure command (mode HUMI or TEMP)
  * 		sht_measure_test_done() .. test if measurement is done
  *		sht_measure_read(*p_value, *p_checksum) .. readout measurement and checksum
@@ -16,94 +16,190 @@
  *		sht_write_statusreg(*p_value) .. write status register
  * 		sht_read_statusreg(*p_value, *p_checksum) .. read status register
  *		sht_crc(*data, dlen) .. calculate crc
- *		sht_measure_check(*value, mode) .. measure and check crc
+ *		sht_crc_status(status, *data, dlen) .. calculate crc (given status register)
+ *		sht_crc_init/update/update_rev/final .. streaming crc (one byte per lookup)
+ *		sht_measure_check(*value, mode) .. measure and check crc (error class SHT_ERR_x)
+ *		sht_measure_retry(*value, mode, measure) .. measure with error recovery and retries
+ *		sht_recover(error) .. recovery action (connection reset, soft reset with status restore)
+ *		sht_get_err_stats(*stats), sht_clear_err_stats() .. error and recovery counters
+ *		sht_set_resolution(res) .. set resolution (status register)
+ *		sht_get_resolution() .. get current resolution
+ *		sht_measure_async(mode, callback) .. start measurement without waiting
+ *		sht_measure_async_done() .. test if asynchronous measurement is done
+ *		sht_measure_async_result(*value) .. get asynchronous measurement result
+ *		sht_measure_async_wait(*value) .. sleep (LPM3, LPM0 with SHT_PROF) until done, get result
+ *
+ *  interrupt routines (asynchronous measurement):
+ *
+ *		Port 2 interrupt .. DATA falling edge (conversion done), starts readout
+ *			(SHT_SPI build reads the whole answer by USCI right there)
+ *		Timer1 A0 interrupt .. readout state machine (one SCK edge per tick) and timeout
+ *
+ *  asynchronous measurement needs ACLK running (VLO or crystal)
+ *  hardware dependent parts are in sht11hal.h (SHT_HOST builds it against test/shtsim)
+ *  SHT_SPI build clocks the 8 data bits of every byte by USCI_B0 (transmission start
+ *  and ACK clocks stay on pins, wiring in sht11hal.h)
  *
  */
 
 /** include section */
 
-// register names
-#include <msp430g2553.h>
+// hardware abstraction (pins, delays, interrupts)
+#include "sht11hal.h"
 // self
 #include "sht11.h"
+// cycle profiling (SHT_PROF)
+#include "prof.h"
 
 /** module local definitions */
 
-// hardware dependent defines
-// delay
-#define delay_us(x) __delay_cycles(x)
-// port (DATA P2.0, SCK P2.1)
-#define SHT_PORT_INIT() {P2DIR|=0x03;P2OUT&=~0x03;}
-#define SHT_DATA_OUT(x) {if (x!=0) P2DIR|=0x01; else P2DIR&=~0x01;}
-#define SHT_DATA_IN (((P2IN&0x01)!=0)?1:0)
-#define SHT_SCK(x) {if (x!=0) P2OUT|=0x02; else P2OUT&=~0x02;}
+// async timer periods (ACLK ticks, VLO approx. 12kHz, up to 20kHz)
+#define SHT_TIMER_LOOP 2			// timeout ticks per wait loop (100us at 20kHz)
+#define SHT_TIMER_CLOCK 1			// SCK half period (2 ticks)
+
+// power-up / soft reset time (us)
+#define SHT_RESET_TIME 11000
 
 // communication
 #define		noACK	0
 #define		ACK		1
 
-// crc lookup table
+// status register shadow (resolution, crc start value)
+unsigned char sht_status = 0;
+
+// error recovery (failed attempts in a row, retry tokens, counters)
+unsigned char sht_rec_run = 0;
+unsigned char sht_rec_budget = SHT_RETRY_BUDGET;
+sht_err_stats_t sht_err_stats;
+
+// asynchronous measurement states
+enum {SHT_AS_IDLE,SHT_AS_WAIT,SHT_AS_READ,SHT_AS_DONE};
+
+// asynchronous measurement status
+volatile unsigned char sht_as_state = SHT_AS_IDLE;
+unsigned char sht_as_mode;
+unsigned char sht_as_error;
+unsigned char sht_as_byte, sht_as_bit;
+unsigned char sht_as_data[3];
+unsigned int sht_as_value;
+sht_callback_t sht_as_callback = 0;
+
+// crc lookup table (bit reversed domain - reflected polynomial, sensor checksum is reversed
+// crc, so it can be compared without final reverse, data bytes are taken bit reversed)
 const unsigned char crc_lut[] = {
 //   0   1   2   3   4   5   6   7   8   9   A   B   C   D   E   F
-    0  , 49, 98, 83,196,245,166,151,185,136,219,234,125, 76, 31, 46,  // 0
-    67 ,114, 33, 16,135,182,229,212,250,203,152,169, 62, 15, 92,109,  // 1
-    134,183,228,213, 66,115, 32, 17, 63, 14, 93,108,251,202,153,168,  // 2
-    197,244,167,150,  1, 48, 99, 82,124, 77, 30, 47,184,137,218,235,  // 3
-    61 , 12, 95,110,249,200,155,170,132,181,230,215, 64,113, 34, 19,  // 4
-    126, 79, 28, 45,186,139,216,233,199,246,165,148,  3, 50, 97, 80,  // 5
-    187,138,217,232,127, 78, 29, 44,  2, 51, 96, 81,198,247,164,149,  // 6
-    248,201,154,171, 60, 13, 94,111, 65,112, 35, 18,133,180,231,214,  // 7
-    122, 75, 24, 41,190,143,220,237,195,242,161,144,  7, 54,101, 84,  // 8
-    57 ,  8, 91,106,253,204,159,174,128,177,226,211, 68,117, 38, 23,  // 9
-    252,205,158,175, 56,  9, 90,107, 69,116, 39, 22,129,176,227,210,  // A
-    191,142,221,236,123, 74, 25, 40,  6, 55,100, 85,194,243,160,145,  // B
-    71 ,118, 37, 20,131,178,225,208,254,207,156,173, 58, 11, 88,105,  // C
-    4  , 53,102, 87,192,241,162,147,189,140,223,238,121, 72, 27, 42,  // D
-    193,240,163,146,  5, 52,103, 86,120, 73, 26, 43,188,141,222,239,  // E
-    130,179,224,209, 70,119, 36, 21, 59, 10, 89,104,255,206,157,172}; // F
+    0  , 94,188,226, 97, 63,221,131,194,156,126, 32,163,253, 31, 65,  // 0
+    157,195, 33,127,252,162, 64, 30, 95,  1,227,189, 62, 96,130,220,  // 1
+    35 ,125,159,193, 66, 28,254,160,225,191, 93,  3,128,222, 60, 98,  // 2
+    190,224,  2, 92,223,129, 99, 61,124, 34,192,158, 29, 67,161,255,  // 3
+    70 , 24,250,164, 39,121,155,197,132,218, 56,102,229,187, 89,  7,  // 4
+    219,133,103, 57,186,228,  6, 88, 25, 71,165,251,120, 38,196,154,  // 5
+    101, 59,217,135,  4, 90,184,230,167,249, 27, 69,198,152,122, 36,  // 6
+    248,166, 68, 26,153,199, 37,123, 58,100,134,216, 91,  5,231,185,  // 7
+    140,210, 48,110,237,179, 81, 15, 78, 16,242,172, 47,113,147,205,  // 8
+    17 , 79,173,243,112, 46,204,146,211,141,111, 49,178,236, 14, 80,  // 9
+    175,241, 19, 77,206,144,114, 44,109, 51,209,143, 12, 82,176,238,  // A
+    50 ,108,142,208, 83, 13,239,177,240,174, 76, 18,145,207, 45,115,  // B
+    202,148,118, 40,171,245, 23, 73,  8, 86,180,234,105, 55,213,139,  // C
+    87 ,  9,235,181, 54,104,138,212,149,203, 41,119,244,170, 72, 22,  // D
+    233,183, 85, 11,136,214, 52,106, 43,117,151,201, 74, 20,246,168,  // E
+    116, 42,200,150, 21, 75,169,247,182,232, 10, 84,215,137,107, 53}; // F
+
+// 4bit reverse (for bytes not collected bit reversed)
+const unsigned char crc_rev4[] = {0x0,0x8,0x4,0xC,0x2,0xA,0x6,0xE,0x1,0x9,0x5,0xD,0x3,0xB,0x7,0xF};
+
+// running crc of current transmission (started by transstart, updated by write/read byte)
+sht_crc_t sht_crc_ctx;
 
 /** Sensibus basics section */
 
+void sht_ack_clock(unsigned char ack);
+
+#ifdef SHT_SPI
+//----------------------------------------------------------------------------------
+// 8 data bits by USCI_B0 (SCK, and DATA if out, handed over for the byte only),
+// returns byte sampled on DATA
+//----------------------------------------------------------------------------------
+unsigned char sht_spi_byte(unsigned char value, unsigned char out)
+{
+	SHT_SPI_ON(out);
+	SHT_SPI_TX(value);
+	while (!SHT_SPI_DONE);
+	value = SHT_SPI_RX;
+	SHT_SPI_OFF();
+	return value;
+}
+#endif
+
 //----------------------------------------------------------------------------------
 // writes a byte on the Sensibus and checks the acknowledge
 //----------------------------------------------------------------------------------
 char sht_write_byte(unsigned char value)
 {
-	unsigned char i,error=0;
+	unsigned char error=0;
+	PROF_START(prof);
+#ifdef SHT_SPI
+	sht_spi_byte(value,1);                 //8 clocks by USCI (DATA driven by SIMO)
+	sht_crc_update(&sht_crc_ctx,value);    //running crc
+#else
+	unsigned char i,rval=0;
 	for (i=0x80;i>0;i>>=1)             	//shift bit for masking
   	{
-		if (i & value) 	SHT_DATA_OUT(0)		//masking value with i , write to SENSI-BUS
+		rval>>=1;                           //bit reversed copy (for crc)
+		if (i & value) {SHT_DATA_OUT(0);rval|=0x80;}	//masking value with i , write to SENSI-BUS
     		else SHT_DATA_OUT(1);
 		SHT_SCK(1);                          //clk for SENSI-BUS
 		delay_us(5);						//pulswith approx. 5 us
 		SHT_SCK(0);
   	}
+	sht_crc_update_rev(&sht_crc_ctx,rval); //running crc
+#endif
 	SHT_DATA_OUT(0);                       //release DATA-line
 	SHT_SCK(1);                            //clk #9 for ack
 	error=SHT_DATA_IN;                    //check ack (DATA will be pulled down by SHT11)
 	SHT_SCK(0);
+	PROF_END(PROF_WRITE_BYTE,prof);
 	return error;                     	//error=1 in case of no acknowledge
 }
 
 //----------------------------------------------------------------------------------
 // reads a byte form the Sensibus and gives an acknowledge in case of "ack=1"
+// acknowledged bytes are data (added to running crc), the last one (noACK) is checksum
 //----------------------------------------------------------------------------------
 char sht_read_byte(unsigned char ack)
 {
-	unsigned char i,val=0;
+	unsigned char val=0;
+	PROF_START(prof);
 	SHT_DATA_OUT(0);             			//release DATA-line
+#ifdef SHT_SPI
+	val=sht_spi_byte(0xFF,0);              //8 clocks by USCI (DATA on SOMI)
+	if (ack) sht_crc_update(&sht_crc_ctx,val); //running crc
+#else
+	unsigned char i,rval=0;
 	for (i=0x80;i>0;i>>=1)             	//shift bit for masking
 	{
 		SHT_SCK(1);          				//clk for SENSI-BUS
-		if (SHT_DATA_IN) val=(val | i);   	//read bit
+		rval>>=1;
+		if (SHT_DATA_IN) {val=(val | i);rval|=0x80;}	//read bit (and bit reversed copy)
 		SHT_SCK(0);
   	}
+	if (ack) sht_crc_update_rev(&sht_crc_ctx,rval); //running crc
+#endif
+	sht_ack_clock(ack);
+	PROF_END(PROF_READ_BYTE,prof);
+	return val;
+}
+
+//----------------------------------------------------------------------------------
+// clk #9 of a read byte, acknowledge in case of "ack=1"
+//----------------------------------------------------------------------------------
+void sht_ack_clock(unsigned char ack)
+{
 	SHT_DATA_OUT(ack);               		//in case of "ack==1" pull down DATA-Line
 	SHT_SCK(1);                            //clk #9 for ack
 	delay_us(5);         					//pulswith approx. 5 us
 	SHT_SCK(0);
 	SHT_DATA_OUT(0);                 		//release DATA-line
-	return val;
 }
 
 //----------------------------------------------------------------------------------
@@ -115,6 +211,8 @@ char sht_read_byte(unsigned char ack)
 //----------------------------------------------------------------------------------
 void sht_transstart(void)
 {
+	PROF_START(prof);
+	sht_crc_init(&sht_crc_ctx,sht_status); //new running crc
 	SHT_DATA_OUT(0);
 	SHT_SCK(0);                   //Initial state
 	delay_us(1);
@@ -129,6 +227,7 @@ void sht_transstart(void)
 	SHT_DATA_OUT(0);
 	delay_us(1);
 	SHT_SCK(0);
+	PROF_END(PROF_TRANSSTART,prof);
 }
 
 //----------------------------------------------------------------------------------
@@ -161,9 +260,20 @@ char sht_softreset(void)
 	unsigned char error=0;
 	sht_connectionreset();              //reset communication
 	error+=sht_write_byte(RESET);      //send RESET-command to sensor
+	if (error==0) sht_status=0; //status register cleared
 	return error;                     //error=1 in case of no response form the sensor
 }
 
+//----------------------------------------------------------------------------------
+// measurement timeout (100us wait loops) for current resolution
+//----------------------------------------------------------------------------------
+unsigned int sht_timeout(unsigned char mode)
+{
+	if (sht_status&STATUS_LOWRES)
+		return (mode==TEMP)?SHT_TIMEOUT_12BIT:SHT_TIMEOUT_8BIT;
+	return (mode==TEMP)?SHT_TIMEOUT_14BIT:SHT_TIMEOUT_12BIT;
+}
+
 /** interface functions section */
 
 //----------------------------------------------------------------------------------
@@ -172,6 +282,31 @@ char sht_softreset(void)
 void sht11_init(void)
 {
 	SHT_PORT_INIT();
+#ifdef SHT_SPI
+	SHT_SPI_INIT();
+#endif
+#if (SHT_RESOLUTION!=SHT_RES_HIGH)
+	delay_us(SHT_RESET_TIME); // sensor power-up
+	sht_set_resolution(SHT_RESOLUTION);
+#endif
+}
+
+//----------------------------------------------------------------------------------
+// set resolution (SHT_RES_HIGH, SHT_RES_LOW) - writes status register, 0 if ok
+//----------------------------------------------------------------------------------
+char sht_set_resolution(unsigned char res)
+{
+	unsigned char st = sht_status & ~STATUS_LOWRES;
+	if (res==SHT_RES_LOW) st |= STATUS_LOWRES;
+	return sht_write_statusreg(&st);
+}
+
+//----------------------------------------------------------------------------------
+// get current resolution
+//----------------------------------------------------------------------------------
+unsigned char sht_get_resolution(void)
+{
+	return (sht_status&STATUS_LOWRES)?SHT_RES_LOW:SHT_RES_HIGH;
 }
 
 //----------------------------------------------------------------------------------
@@ -202,9 +337,11 @@ char sht_measure_test_done(void)
 //----------------------------------------------------------------------------------
 void sht_measure_read(unsigned char *p_value, unsigned char *p_checksum)
 {
+	PROF_START(prof);
 	*(p_value+1) = sht_read_byte(ACK); 	// read the first byte (MSB)
 	*(p_value) 	 = sht_read_byte(ACK); 	// read the second byte (LSB)
 	*p_checksum  = sht_read_byte(noACK); // read checksum
+	PROF_END(PROF_READ,prof);
 }
 
 //----------------------------------------------------------------------------------
@@ -212,28 +349,30 @@ void sht_measure_read(unsigned char *p_value, unsigned char *p_checksum)
 //----------------------------------------------------------------------------------
 char sht_measure(unsigned char *p_value, unsigned char *p_checksum, unsigned char mode)
 {
-  unsigned error=0;
   unsigned int i=0;
+  unsigned int timeout=sht_timeout(mode);
 
-  error += sht_measure_start(mode); //start measurement
+  if (sht_measure_start(mode)!=0) return SHT_ERR_ACK; //start measurement (no wait if not started)
 
-  while (i<20000) // test measurement done (aprox. 2s)
+  PROF_START(prof);
+  while (i<timeout) // test measurement done (timeout depends on resolution)
   {
 	  if (sht_measure_test_done()==1) break;
 	  delay_us(100);
 	  i++;
   }
-  if (i==20000) error++;
+  PROF_END(PROF_WAIT,prof);
+  if (i==timeout) return SHT_ERR_TIMEOUT;
 
   // read and check measurement
   sht_measure_read(p_value,p_checksum);
 
-  // return error count (0 if value ok)
-  return error;
+  // return error (0 if value ok)
+  return 0;
 }
 
 //----------------------------------------------------------------------------------
-// reads the status register with checksum (8-bit)
+// reads the status register with checksum (8-bit), error also if crc doesn't match
 //----------------------------------------------------------------------------------
 char sht_read_statusreg(unsigned char *p_value, unsigned char *p_checksum)
 {
@@ -242,7 +381,8 @@ char sht_read_statusreg(unsigned char *p_value, unsigned char *p_checksum)
   error=sht_write_byte(STATUS_REG_R); //send command to sensor
   *p_value=sht_read_byte(ACK);        //read status register (8-bit)
   *p_checksum=sht_read_byte(noACK);   //read checksum (8-bit)
-  return error;                     //error=1 in case of no response form the sensor
+  if (*p_checksum!=sht_crc_final(&sht_crc_ctx)) error++; //check running crc
+  return error;                     //error>=1 in case of no response form the sensor or crc error
 }
 
 //----------------------------------------------------------------------------------
@@ -254,34 +394,53 @@ char sht_write_statusreg(unsigned char *p_value)
   sht_transstart();                   //transmission start
   error+=sht_write_byte(STATUS_REG_W);//send command to sensor
   error+=sht_write_byte(*p_value);    //send value of status register
+  if (error==0) sht_status=*p_value; //update shadow (resolution, crc start value)
   return error;                     //error>=1 in case of no response form the sensor
 }
 
 //----------------------------------------------------------------------------------
-// calculate crc
+// crc streaming interface (reversed domain, start value is status register nibble)
+//----------------------------------------------------------------------------------
+void sht_crc_init(sht_crc_t *ctx, unsigned char status)
+{
+	*ctx = status&0x0F;
+}
+
+void sht_crc_update(sht_crc_t *ctx, unsigned char data)
+{
+	// data byte bit reversed (two nibbles)
+	*ctx = crc_lut[*ctx ^ ((crc_rev4[data&0x0F]<<4)|crc_rev4[data>>4])];
+}
+
+void sht_crc_update_rev(sht_crc_t *ctx, unsigned char rdata)
+{
+	*ctx = crc_lut[*ctx ^ rdata];
+}
+
+unsigned char sht_crc_final(const sht_crc_t *ctx)
+{
+	return *ctx; // already reversed (the same order as sensor checksum)
+}
+
+//----------------------------------------------------------------------------------
+// calculate crc (starting with current status register nibble)
 //----------------------------------------------------------------------------------
 unsigned char sht_crc(unsigned char* data, unsigned char dlen)
 {
-    unsigned char crc = 0,ret = 0;
-    unsigned char i;
+    return sht_crc_status(sht_status,data,dlen);
+}
 
-    // get crc (xor -> lookup table)
-    for (i=dlen;i!=0;i--)
-    {
-        crc ^= *data++;
-        crc = crc_lut[crc];
-    }
+//----------------------------------------------------------------------------------
+// calculate crc starting with given status register nibble
+//----------------------------------------------------------------------------------
+unsigned char sht_crc_status(unsigned char status, unsigned char* data, unsigned char dlen)
+{
+    sht_crc_t crc;
 
-    // reverse result
-    ret |= crc&0x01;
-    for (i=7;i!=0;i--)
-    {
-        ret<<=1;
-        crc>>=1;
-        ret |= crc&0x01;
-    }
+    sht_crc_init(&crc,status);
+    for (;dlen!=0;dlen--) sht_crc_update(&crc,*data++);
 
-    return ret;
+    return sht_crc_final(&crc);
 }
 
 //----------------------------------------------------------------------------------
@@ -289,19 +448,254 @@ unsigned char sht_crc(unsigned char* data, unsigned char dlen)
 //----------------------------------------------------------------------------------
 unsigned char sht_measure_check(unsigned int *value, unsigned char mode)
 {
-	unsigned char checksum;
+	unsigned char checksum, error;
 	unsigned int val;
-	unsigned char data[3];
-	if (sht_measure((unsigned char*)&val,&checksum,mode)!=0) return 1;
-	switch (mode)
+	error = sht_measure((unsigned char*)&val,&checksum,mode);
+	if (error!=0) return error;
+	if (checksum!=sht_crc_final(&sht_crc_ctx)) return SHT_ERR_CRC; // running crc (command, MSB, LSB)
+	*value=val;
+	return 0;
+}
+
+/** error recovery section */
+
+//----------------------------------------------------------------------------------
+// soft reset, wait reset time, restore status register (resolution, heater), 0 if ok
+//----------------------------------------------------------------------------------
+char sht_reset_restore(void)
+{
+	unsigned char st = sht_status; // cleared by reset
+	sht_err_stats.softresets++;
+	if (sht_softreset()!=0) return 1;
+	delay_us(SHT_RESET_TIME);
+	if (st==0) return 0;
+	return sht_write_statusreg(&st);
+}
+
+//----------------------------------------------------------------------------------
+// recovery action for failed attempt, level = failures in a row before this one
+// (+1 for no ack and timeout, crc error alone is just noise)
+//   level 0 .. nothing (new transmission start is enough)
+//   level 1 .. connection reset (sensor interface leaves latched readout)
+//   level 2+ .. soft reset (hung sensor), status register restored
+//----------------------------------------------------------------------------------
+void sht_recover(unsigned char error)
+{
+	unsigned char level = sht_rec_run;
+	switch (error)
 	{
-		case TEMP: data[0]=MEASURE_TEMP; break;
-		case HUMI: data[0]=MEASURE_HUMI; break;
-		default: return 1;
+		case SHT_ERR_ACK: sht_err_stats.noack++; level++; break;
+		case SHT_ERR_TIMEOUT: sht_err_stats.timeout++; level++; break;
+		case SHT_ERR_CRC: sht_err_stats.crc++; break;
+		default: return;
 	}
-	data[1]=(unsigned int)val>>8;
-	data[2]=val;
-	if (checksum!=sht_crc(data,3)) return 1;
-	*value=val;
+	if (level>=2) sht_reset_restore();
+	else if (level==1)
+	{
+		sht_err_stats.connresets++;
+		sht_connectionreset();
+	}
+	if (sht_rec_run<255) sht_rec_run++;
+}
+
+//----------------------------------------------------------------------------------
+// measure with recovery (max. SHT_RETRY_MAX retries while retry budget lasts), error
+// class of the last attempt (0 if value ok); recovery runs after every failed attempt,
+// so the next measurement starts on clean bus even when no retry is left
+//----------------------------------------------------------------------------------
+unsigned char sht_measure_retry(unsigned int *value, unsigned char mode, sht_measure_fn_t measure)
+{
+	unsigned char error, retry = 0;
+	while ((error = measure(value,mode))!=0)
+	{
+		sht_recover(error);
+		if ((retry==SHT_RETRY_MAX)||(sht_rec_budget==0))
+		{
+			sht_err_stats.failed++;
+			return error;
+		}
+		sht_rec_budget--;
+		retry++;
+	}
+	sht_rec_run = 0;
+	if (retry!=0) sht_err_stats.recovered++;
+	if (sht_rec_budget<SHT_RETRY_BUDGET) sht_rec_budget++;
+	return 0;
+}
+
+//----------------------------------------------------------------------------------
+// error and recovery counters
+//----------------------------------------------------------------------------------
+void sht_get_err_stats(sht_err_stats_t *stats)
+{
+	*stats = sht_err_stats;
+}
+
+void sht_clear_err_stats(void)
+{
+	sht_err_stats_t zero = {0};
+	sht_err_stats = zero;
+}
+
+/** asynchronous measurement section */
+
+//----------------------------------------------------------------------------------
+// finish asynchronous measurement (called from interrupts)
+//----------------------------------------------------------------------------------
+void sht_as_finish(void)
+{
+	SHT_TIMER_STOP();
+	SHT_DATA_IRQ_OFF();
+	if (sht_as_error==0)
+	{
+		sht_as_value = ((unsigned int)sht_as_data[0]<<8) | sht_as_data[1];
+		sht_crc_update(&sht_crc_ctx,sht_as_data[0]); // running crc (command added by start)
+		sht_crc_update(&sht_crc_ctx,sht_as_data[1]);
+		if (sht_as_data[2]!=sht_crc_final(&sht_crc_ctx)) sht_as_error = SHT_ERR_CRC;
+	}
+	sht_as_state = SHT_AS_DONE;
+	if (sht_as_callback) sht_as_callback(sht_as_error,sht_as_value);
+}
+
+//----------------------------------------------------------------------------------
+// start asynchronous measurement (0 started, 1 error)
+//----------------------------------------------------------------------------------
+char sht_measure_async(unsigned char mode, sht_callback_t callback)
+{
+	if ((sht_as_state==SHT_AS_WAIT)||(sht_as_state==SHT_AS_READ)) return 1; // busy
+	sht_as_mode = mode;
+	sht_as_callback = callback;
+	sht_as_error = 0;
+	sht_as_state = SHT_AS_WAIT;
+	if (sht_measure_start(mode)!=0)
+	{
+		sht_as_error = SHT_ERR_ACK;
+		sht_as_state = SHT_AS_DONE;
+		return 1;
+	}
+	SHT_TIMER_START(sht_timeout(mode)*SHT_TIMER_LOOP); // timeout
+	SHT_DATA_IRQ_ON(); // wait for DATA falling edge
+	if (sht_measure_test_done()) SHT_DATA_IRQ_FORCE(); // already done (don't miss the edge)
 	return 0;
 }
+
+//----------------------------------------------------------------------------------
+// test asynchronous measurement done (1 done, 0 not)
+//----------------------------------------------------------------------------------
+char sht_measure_async_done(void)
+{
+	return (sht_as_state==SHT_AS_DONE)?1:0;
+}
+
+//----------------------------------------------------------------------------------
+// get asynchronous measurement result (0 ok, SHT_ERR_x error or not done)
+//----------------------------------------------------------------------------------
+unsigned char sht_measure_async_result(unsigned int* value)
+{
+	if (sht_as_state!=SHT_AS_DONE) return SHT_ERR_BUSY;
+	if (sht_as_error!=0) return sht_as_error;
+	*value = sht_as_value;
+	return 0;
+}
+
+//----------------------------------------------------------------------------------
+// sleep (LPM3, LPM0 with SHT_PROF) until asynchronous measurement done, get result (0 ok, SHT_ERR_x)
+//----------------------------------------------------------------------------------
+unsigned char sht_measure_async_wait(unsigned int* value)
+{
+	SHT_IRQ_DISABLE(); // no wake up lost between test and sleep
+	while (!sht_measure_async_done())
+		if (!SHT_SLEEP()) break;
+	SHT_IRQ_ENABLE();
+	return sht_measure_async_result(value);
+}
+
+/** interrupt routines section */
+
+// Port 2 interrupt service routine (DATA falling edge .. conversion done)
+#pragma vector=PORT2_VECTOR
+__interrupt void Port_2(void)
+{
+	SHT_DATA_IRQ_OFF();
+	if (sht_as_state!=SHT_AS_WAIT) return;
+	sht_as_state = SHT_AS_READ;
+	sht_as_byte = 0;
+	sht_as_bit = 0;
+	sht_as_data[0] = sht_as_data[1] = sht_as_data[2] = 0;
+	SHT_DATA_OUT(0); // release DATA-line
+#ifdef SHT_SPI
+	// whole readout by USCI here (SMCLK runs in interrupt), no readout clock ticks
+	PROF_START(prof);
+	for (;sht_as_byte<3;sht_as_byte++)
+	{
+		sht_as_data[sht_as_byte] = sht_spi_byte(0xFF,0);
+		sht_ack_clock(sht_as_byte<2); // ACK for value bytes, noACK for checksum
+	}
+	sht_as_finish();
+	PROF_END(PROF_READ_ISR,prof);
+	__bic_SR_register_on_exit(LPM3_bits); // wake up main loop
+#else
+	SHT_TIMER_START(SHT_TIMER_CLOCK); // start readout clock
+#endif
+}
+
+// Timer1 A0 interrupt service routine (readout state machine, one SCK edge per call)
+//   bits 0..7 .. SCK high, sample DATA, SCK low
+//   bit 8 .. ACK (bytes 0,1) or noACK (checksum), SCK high, SCK low, release DATA
+#pragma vector=TIMER1_A0_VECTOR
+__interrupt void Timer1_A0(void)
+{
+	static unsigned char sck = 0;
+	PROF_START(prof);
+
+	if (sht_as_state==SHT_AS_WAIT) // conversion timeout
+	{
+		sht_as_error = SHT_ERR_TIMEOUT;
+		sht_as_finish();
+		__bic_SR_register_on_exit(LPM3_bits);
+		PROF_END(PROF_READ_ISR,prof);
+		return;
+	}
+	if (sht_as_state!=SHT_AS_READ)
+	{
+		PROF_END(PROF_READ_ISR,prof);
+		return;
+	}
+
+	if (sck==0) // rising edge
+	{
+		if (sht_as_bit<8)
+		{
+			SHT_SCK(1);
+			if (SHT_DATA_IN) sht_as_data[sht_as_byte] |= (0x80>>sht_as_bit);
+		}
+		else
+		{
+			if (sht_as_byte<2) SHT_DATA_OUT(ACK) // ACK for value bytes
+			else SHT_DATA_OUT(noACK); // noACK for checksum
+			SHT_SCK(1);
+		}
+		sck = 1;
+		PROF_END(PROF_READ_ISR,prof);
+		return;
+	}
+
+	// falling edge
+	SHT_SCK(0);
+	sck = 0;
+	if (sht_as_bit<8)
+	{
+		sht_as_bit++;
+		PROF_END(PROF_READ_ISR,prof);
+		return;
+	}
+	SHT_DATA_OUT(0); // release DATA-line
+	sht_as_bit = 0;
+	sht_as_byte++;
+	if (sht_as_byte==3)
+	{
+		sht_as_finish();
+		__bic_SR_register_on_exit(LPM3_bits); // wake up main loop
+	}
+	PROF_END(PROF_READ_ISR,prof);
+}
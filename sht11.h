@@ -19,6 +19,49 @@ enum {TEMP,HUMI};
 #define MEASURE_HUMI 0x05   //000   0010    1
 #define RESET        0x1e   //000   1111    0
 
+// status register bits
+#define STATUS_LOWRES 0x01  // 12bit T, 8bit RH
+#define STATUS_NORELOAD 0x02 // no reload from OTP
+#define STATUS_HEATER 0x04  // heater on
+
+// resolution modes
+#define SHT_RES_HIGH 0      // 14bit T, 12bit RH (320/80 ms)
+#define SHT_RES_LOW 1       // 12bit T, 8bit RH (80/20 ms)
+
+// raw value difference in high resolution units (low resolution T scaled by 4, RH by 16)
+#define SHT_T_SHIFT(res) (((res)==SHT_RES_LOW)?2:0)
+#define SHT_H_SHIFT(res) (((res)==SHT_RES_LOW)?4:0)
+static inline unsigned int sht_raw_delta(unsigned int a, unsigned int b, unsigned char shift)
+{
+	unsigned int d = (a>b) ? a-b : b-a;
+	return d<<shift;
+}
+
+// measurement timeouts (100us wait loops), aprox. 1.5x datasheet conversion time
+#define SHT_TIMEOUT_14BIT 4800      // 320ms
+#define SHT_TIMEOUT_12BIT 1200      // 80ms
+#define SHT_TIMEOUT_8BIT 300        // 20ms
+
+// measurement errors (0 ok), returned by sht_measure_check(), sht_measure_async_result()
+#define SHT_ERR_ACK 1       // command not acknowledged (no sensor, bus out of sync)
+#define SHT_ERR_TIMEOUT 2   // conversion not finished in time (sensor hung)
+#define SHT_ERR_CRC 3       // checksum mismatch (noise on the bus)
+#define SHT_ERR_BUSY 4      // asynchronous measurement not done
+
+// error recovery: retries per measurement, retry budget (one token per retry,
+// one token back per good measurement)
+#ifndef SHT_RETRY_MAX
+#define SHT_RETRY_MAX 2
+#endif
+#ifndef SHT_RETRY_BUDGET
+#define SHT_RETRY_BUDGET 8
+#endif
+
+// resolution set by sht11_init()
+#ifndef SHT_RESOLUTION
+#define SHT_RESOLUTION SHT_RES_HIGH
+#endif
+
 // function prototypes
 
 /*// sensibus basics .. not interfacing
@@ -28,8 +71,11 @@ void sht_transstart(void);
 void sht_connectionreset(void);
 char sht_softreset(void);*/
 
-// initialization
+// initialization (ports and resolution)
 void sht11_init(void);
+// set/get resolution (SHT_RES_HIGH, SHT_RES_LOW)
+char sht_set_resolution(unsigned char res);
+unsigned char sht_get_resolution(void);
 // start measurement
 char sht_measure_start(unsigned char mode);
 // test if measurement done (for waiting loops)
@@ -43,7 +89,45 @@ char sht_write_statusreg(unsigned char *p_value);
 char sht_read_statusreg(unsigned char *p_value, unsigned char *p_checksum);
 // calculate checksum
 unsigned char sht_crc(unsigned char* data, unsigned char dlen);
-// read measurement and check crc
+unsigned char sht_crc_status(unsigned char status, unsigned char* data, unsigned char dlen);
+// streaming crc (context is crc in sensor bit order, one table lookup per byte)
+// update takes data byte, update_rev takes data byte already bit reversed (LSB first)
+typedef unsigned char sht_crc_t;
+void sht_crc_init(sht_crc_t *ctx, unsigned char status);
+void sht_crc_update(sht_crc_t *ctx, unsigned char data);
+void sht_crc_update_rev(sht_crc_t *ctx, unsigned char rdata);
+unsigned char sht_crc_final(const sht_crc_t *ctx);
+// read measurement and check crc (returns SHT_ERR_x, 0 if value ok)
 unsigned char sht_measure_check(unsigned int* value, unsigned char mode);
 
+// error recovery (bus reset, sensor reset with status register restore, bounded retries)
+// measure function is sht_measure_check or an asynchronous wrapper (acq.c acq_measure)
+typedef unsigned char (*sht_measure_fn_t)(unsigned int *value, unsigned char mode);
+typedef struct {
+	unsigned int noack, timeout, crc;	// failed attempts by error class
+	unsigned int connresets, softresets; // recovery actions
+	unsigned int recovered;				// measurements good after retry
+	unsigned int failed;				// measurements failed (retries or budget spent)
+} sht_err_stats_t;
+// measure with recovery and retries (returns SHT_ERR_x of the last attempt, 0 if value ok)
+unsigned char sht_measure_retry(unsigned int *value, unsigned char mode, sht_measure_fn_t measure);
+// recovery action for failed attempt (connection reset, then soft reset on failures in a row)
+void sht_recover(unsigned char error);
+// error counters
+void sht_get_err_stats(sht_err_stats_t *stats);
+void sht_clear_err_stats(void);
+
+// asynchronous measurement (conversion done signalled by DATA interrupt, readout
+// clocked by Timer1_A from ACLK, so the core can stay in LPM3 all the time)
+// callback is called from interrupt when done (error SHT_ERR_x, 0 if value ok), it can be NULL
+typedef void (*sht_callback_t)(unsigned char error, unsigned int value);
+// start asynchronous measurement (returns 0 if started)
+char sht_measure_async(unsigned char mode, sht_callback_t callback);
+// test if asynchronous measurement done (1 done, 0 not)
+char sht_measure_async_done(void);
+// get asynchronous measurement result (returns SHT_ERR_x, 0 if value ok)
+unsigned char sht_measure_async_result(unsigned int* value);
+// sleep (LPM3) until asynchronous measurement done, get result (returns SHT_ERR_x, 0 if value ok)
+unsigned char sht_measure_async_wait(unsigned int* value);
+
 #endif /* SHT11_H_ */
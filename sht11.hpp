@@ -0,0 +1,360 @@
+/*
+ * sht11.hpp
+ *
+ *  Created on: 17.10.2026
+ *      Author: agent
+ *
+ *  Description: header-only C++ SHT11 driver configured at compile time
+ *
+ *  	Sht11<Port, DataPin, SckPin, ClockHz, Resolution>
+ *
+ *  	Port .. port type (sht::Port1, sht::Port2, sht::Port3 if present, sht::SimPort in SHT_HOST)
+ *  	DataPin, SckPin .. pin numbers (0..7) on Port
+ *  	ClockHz .. MCLK frequency, delays are __delay_cycles(us * MHz) with MHz rounded up,
+ *  		so they are never shorter than at 1MHz (default 1000000)
+ *  	Resolution .. SHT_RES_HIGH (default) or SHT_RES_LOW, status register written by init()
+ *
+ *  Every port access is a constant mask on a fixed register (one bis/bic/bit instruction),
+ *  the command checksums are computed by the compiler and the driver keeps no state in RAM.
+ *  Wrong pins or resolution stop compilation (negative array size).
+ *
+ *  Functions (all static, error SHT_ERR_x, 0 if ok):
+ *  	init() .. port settings, resolution (power-up wait when status is written)
+ *  	measure<TEMP/HUMI>(value), measure(value, mode) .. measure with waiting, crc checked
+ *  	start(mode), done(), read(value, mode) .. the same without waiting
+ *  	read_status(value) .. status register (crc checked)
+ *  	reset() .. soft reset, status register restored
+ *  	connection_reset() .. bus reset
+ *
+ *  Values are raw registers (conversion by sht11con), constants come from sht11.h, so the
+ *  template and the C driver (sht11.c, P2.0/P2.1) can be used in one program, each on own pins.
+ *
+ *  Example (8MHz board, sensor on P1.4/P1.5, low resolution):
+ *
+ *  	typedef Sht11<sht::Port1,4,5,8000000UL,SHT_RES_LOW> Sensor;
+ *  	Sensor::init();
+ *  	if (Sensor::measure<TEMP>(t)==0) ...
+ *
+ */
+
+#ifndef __SHT11_HPP__
+#define __SHT11_HPP__
+
+extern "C" {
+// register names (target), simulator interface (SHT_HOST)
+#include "sht11hal.h"
+// commands, status bits, resolutions, timeouts, error codes
+#include "sht11.h"
+}
+
+namespace sht {
+
+/** port types */
+
+#ifndef SHT_HOST
+
+// digital I/O port n (mask is compile time constant)
+#define SHT_PORT_TYPE(name,n) \
+	struct name { \
+		static void dir_set(unsigned char m) {P##n##DIR|=m;} \
+		static void dir_clr(unsigned char m) {P##n##DIR&=~m;} \
+		static void out_set(unsigned char m) {P##n##OUT|=m;} \
+		static void out_clr(unsigned char m) {P##n##OUT&=~m;} \
+		static unsigned char in(void) {return P##n##IN;} \
+	};
+
+SHT_PORT_TYPE(Port1,1)
+SHT_PORT_TYPE(Port2,2)
+#ifdef __MSP430_HAS_PORT3_R__
+SHT_PORT_TYPE(Port3,3)
+#endif
+
+#undef SHT_PORT_TYPE
+
+// busy wait (cycles)
+template<unsigned long Cycles> inline void delay_cycles(void)
+{
+	__delay_cycles(Cycles);
+}
+
+#else // SHT_HOST
+
+// simulated port (test/shtsim): DATA is pin 0, SCK pin 1 (the same as P2 of the C driver)
+struct SimPort {
+	static void dir_set(unsigned char m) {if (m&0x01) shtsim_data_out(1);}
+	static void dir_clr(unsigned char m) {if (m&0x01) shtsim_data_out(0);}
+	static void out_set(unsigned char m) {if (m&0x02) shtsim_sck(1);}
+	static void out_clr(unsigned char m) {if (m&0x02) shtsim_sck(0);}
+	static unsigned char in(void) {return shtsim_data_in()?0x01:0;}
+};
+
+#endif // SHT_HOST
+
+/** compile time checksum */
+
+// crc of Data bits Bit..0 (MSB first) in reversed domain starting with Crc (the same as sht11.c)
+template<unsigned char Crc, unsigned char Data, int Bit = 7> struct crc_byte {
+	enum {value = crc_byte<(((Crc^(Data>>Bit))&1)?((Crc>>1)^0x8C):(Crc>>1)),Data,Bit-1>::value};
+};
+
+template<unsigned char Crc, unsigned char Data> struct crc_byte<Crc,Data,-1> {
+	enum {value = Crc};
+};
+
+} // namespace sht
+
+/** driver */
+
+template<class Port, unsigned char DataPin, unsigned char SckPin,
+	unsigned long ClockHz = 1000000UL, unsigned char Resolution = SHT_RES_HIGH>
+class Sht11
+{
+	// configuration checks
+	typedef char check_pins[((DataPin<8)&&(SckPin<8)&&(DataPin!=SckPin))?1:-1];
+	typedef char check_resolution[((Resolution==SHT_RES_HIGH)||(Resolution==SHT_RES_LOW))?1:-1];
+	typedef char check_clock[(ClockHz>0)?1:-1];
+
+public:
+	// pin masks
+	static const unsigned char DATA = 1<<DataPin;
+	static const unsigned char SCK = 1<<SckPin;
+	// cycles per us (rounded up)
+	static const unsigned long MHZ = (ClockHz+999999UL)/1000000UL;
+	// timing (us): SCK pulse, bus step, wait loop, soft reset time
+	static const unsigned long PULSE_US = 5;
+	static const unsigned long STEP_US = 1;
+	static const unsigned long POLL_US = 100;
+	static const unsigned long RESET_US = 11000;
+	// status register (resolution)
+	static const unsigned char STATUS = (Resolution==SHT_RES_LOW)?STATUS_LOWRES:0;
+	// measurement timeouts (wait loops)
+	static const unsigned int TIMEOUT_TEMP = (Resolution==SHT_RES_LOW)?SHT_TIMEOUT_12BIT:SHT_TIMEOUT_14BIT;
+	static const unsigned int TIMEOUT_HUMI = (Resolution==SHT_RES_LOW)?SHT_TIMEOUT_8BIT:SHT_TIMEOUT_12BIT;
+	// running crc after measurement commands
+	static const unsigned char CRC_TEMP = sht::crc_byte<(STATUS&0x0F),MEASURE_TEMP>::value;
+	static const unsigned char CRC_HUMI = sht::crc_byte<(STATUS&0x0F),MEASURE_HUMI>::value;
+	static const unsigned char CRC_STATUS = sht::crc_byte<(STATUS&0x0F),STATUS_REG_R>::value;
+
+	//----------------------------------------------------------------------------------
+	// port settings (SCK output low, DATA released), resolution
+	//----------------------------------------------------------------------------------
+	static unsigned char init(void)
+	{
+		Port::out_clr(DATA|SCK);
+		Port::dir_clr(DATA);
+		Port::dir_set(SCK);
+		if (STATUS==0) return 0;
+		delay<RESET_US>(); // sensor power-up
+		return write_status();
+	}
+
+	//----------------------------------------------------------------------------------
+	// measure with waiting (timeout by resolution), crc checked
+	//----------------------------------------------------------------------------------
+	template<unsigned char Mode> static unsigned char measure(unsigned int &value)
+	{
+		unsigned int i;
+		if (start(Mode)!=0) return SHT_ERR_ACK;
+		for (i=(Mode==TEMP)?TIMEOUT_TEMP:TIMEOUT_HUMI;!done();i--)
+		{
+			if (i==0) return SHT_ERR_TIMEOUT;
+			delay<POLL_US>();
+		}
+		return read(value,Mode);
+	}
+
+	static unsigned char measure(unsigned int &value, unsigned char mode)
+	{
+		if (mode==TEMP) return measure<TEMP>(value);
+		return measure<HUMI>(value);
+	}
+
+	//----------------------------------------------------------------------------------
+	// start measurement (TEMP, HUMI)
+	//----------------------------------------------------------------------------------
+	static unsigned char start(unsigned char mode)
+	{
+		unsigned char crc = 0;
+		transstart();
+		return write_byte((mode==TEMP)?MEASURE_TEMP:MEASURE_HUMI,crc)?SHT_ERR_ACK:0;
+	}
+
+	//----------------------------------------------------------------------------------
+	// measurement done (sensor pulls DATA down)
+	//----------------------------------------------------------------------------------
+	static unsigned char done(void)
+	{
+		return (Port::in()&DATA)==0;
+	}
+
+	//----------------------------------------------------------------------------------
+	// read measurement started by start(mode), crc checked
+	//----------------------------------------------------------------------------------
+	static unsigned char read(unsigned int &value, unsigned char mode)
+	{
+		unsigned char crc = (mode==TEMP)?CRC_TEMP:CRC_HUMI;
+		unsigned int val = (unsigned int)read_byte(1,crc)<<8;
+		val |= read_byte(1,crc);
+		if (read_byte(0,crc)!=crc) return SHT_ERR_CRC;
+		value = val;
+		return 0;
+	}
+
+	//----------------------------------------------------------------------------------
+	// read status register, crc checked
+	//----------------------------------------------------------------------------------
+	static unsigned char read_status(unsigned char &value)
+	{
+		unsigned char crc = 0, val;
+		transstart();
+		if (write_byte(STATUS_REG_R,crc)) return SHT_ERR_ACK;
+		crc = CRC_STATUS;
+		val = read_byte(1,crc);
+		if (read_byte(0,crc)!=crc) return SHT_ERR_CRC;
+		value = val;
+		return 0;
+	}
+
+	//----------------------------------------------------------------------------------
+	// soft reset, wait reset time, restore status register
+	//----------------------------------------------------------------------------------
+	static unsigned char reset(void)
+	{
+		unsigned char crc = 0;
+		connection_reset();
+		if (write_byte(RESET,crc)) return SHT_ERR_ACK;
+		delay<RESET_US>();
+		if (STATUS==0) return 0;
+		return write_status();
+	}
+
+	//----------------------------------------------------------------------------------
+	// connection reset: DATA released, 9 SCK cycles, transmission start
+	//----------------------------------------------------------------------------------
+	static void connection_reset(void)
+	{
+		unsigned char i;
+		Port::dir_clr(DATA);
+		Port::out_clr(SCK);
+		for (i=9;i!=0;i--)
+		{
+			Port::out_set(SCK);
+			delay<STEP_US>();
+			Port::out_clr(SCK);
+			delay<STEP_US>();
+		}
+		transstart();
+	}
+
+private:
+	//----------------------------------------------------------------------------------
+	// busy wait (us at ClockHz)
+	//----------------------------------------------------------------------------------
+	template<unsigned long Us> static void delay(void)
+	{
+#ifndef SHT_HOST
+		sht::delay_cycles<Us*MHZ>();
+#else
+		shtsim_delay(Us); // simulator counts 1MHz cycles, the same time for every clock
+#endif
+	}
+
+	//----------------------------------------------------------------------------------
+	// running crc, one bit (reversed domain, bits MSB first)
+	//----------------------------------------------------------------------------------
+	static void crc_bit(unsigned char &crc, unsigned char bit)
+	{
+		if ((crc^(bit?1:0))&1) crc = (crc>>1)^0x8C;
+		else crc >>= 1;
+	}
+
+	//----------------------------------------------------------------------------------
+	// generates a transmission start
+	//       _____         ________
+	// DATA:      |_______|
+	//           ___     ___
+	// SCK : ___|   |___|   |______
+	//----------------------------------------------------------------------------------
+	static void transstart(void)
+	{
+		Port::dir_clr(DATA);
+		Port::out_clr(SCK);
+		delay<STEP_US>();
+		Port::out_set(SCK);
+		delay<STEP_US>();
+		Port::dir_set(DATA);
+		delay<STEP_US>();
+		Port::out_clr(SCK);
+		delay<PULSE_US>();
+		Port::out_set(SCK);
+		delay<STEP_US>();
+		Port::dir_clr(DATA);
+		delay<STEP_US>();
+		Port::out_clr(SCK);
+	}
+
+	//----------------------------------------------------------------------------------
+	// write byte (MSB first), running crc, 1 if not acknowledged
+	//----------------------------------------------------------------------------------
+	static unsigned char write_byte(unsigned char value, unsigned char &crc)
+	{
+		unsigned char i, error;
+		for (i=0x80;i!=0;i>>=1)
+		{
+			if (value&i) Port::dir_clr(DATA);
+			else Port::dir_set(DATA);
+			crc_bit(crc,value&i);
+			Port::out_set(SCK);
+			delay<PULSE_US>();
+			Port::out_clr(SCK);
+		}
+		Port::dir_clr(DATA);
+		Port::out_set(SCK); // clk #9 for ack
+		delay<STEP_US>();
+		error = (Port::in()&DATA)?1:0;
+		Port::out_clr(SCK);
+		return error;
+	}
+
+	//----------------------------------------------------------------------------------
+	// read byte (MSB first), acknowledged bytes are data (added to running crc),
+	// the last one (no ack) is checksum
+	//----------------------------------------------------------------------------------
+	static unsigned char read_byte(unsigned char ack, unsigned char &crc)
+	{
+		unsigned char i, val = 0;
+		Port::dir_clr(DATA);
+		for (i=0x80;i!=0;i>>=1)
+		{
+			Port::out_set(SCK);
+			delay<STEP_US>();
+			if (Port::in()&DATA) val |= i;
+			Port::out_clr(SCK);
+			delay<STEP_US>();
+		}
+		if (ack)
+		{
+			for (i=0x80;i!=0;i>>=1) crc_bit(crc,val&i);
+			Port::dir_set(DATA);
+		}
+		Port::out_set(SCK); // clk #9 for ack
+		delay<PULSE_US>();
+		Port::out_clr(SCK);
+		Port::dir_clr(DATA);
+		return val;
+	}
+
+	//----------------------------------------------------------------------------------
+	// write status register (STATUS)
+	//----------------------------------------------------------------------------------
+	static unsigned char write_status(void)
+	{
+		unsigned char crc = 0;
+		transstart();
+		if (write_byte(STATUS_REG_W,crc)) return SHT_ERR_ACK;
+		if (write_byte(STATUS,crc)) return SHT_ERR_ACK;
+		return 0;
+	}
+};
+
+#endif
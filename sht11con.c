@@ -9,26 +9,86 @@
  *  interface functions:
  *
  *      sht2int(regT,regH,*T,*H) .. converting register values into sensful inteters
+ *          (T or H NULL .. that part not computed, T can be converted before RH is measured)
+ *      sht2int_float(regT,regH,*T,*H) .. float engine (SHT_CONV_FLOAT)
+ *      sht2int_fixed(regT,regH,*T,*H) .. fixed-point engine (SHT_CONV_FIXED)
+ *      sht2int_table(regT,regH,*T,*H) .. lookup table engine (SHT_CONV_TABLE, more flash, not faster)
+ *      sht2int_lowres(regT,regH,*T,*H) .. the same for low resolution (12bit T, 8bit RH)
+ *      sht2int_batch(*regT,*regH,*T,*H,n) .. arrays, fixed-point engine (log processing on host)
  *      int2bcd(w) .. converting int to bcd value (with sign) - easier displaying
+ *      sht2bcd(regT,regH,*T,*H) .. registers directly to bcd values (fixed-point engine, SHT_BCD)
+ *      sht_dewpoint(T,H) .. dew point *10 from sht2int results (integer, no log/exp)
+ *      sht_abshum(T,H) .. absolute humidity *10 g/m^3 from sht2int results
  *
  */
 
 #include "sht11con.h" // self
+#include "prof.h" // cycle profiling (SHT_PROF)
+#include "sht11dew.h" // dew point tables (generated by test/tabgen)
 
-/** interface section */
+#if defined(SHT_CONV_ALL) || (SHT_CONV==SHT_CONV_FLOAT)
+#define SHT_CONV_USE_FLOAT
+#endif
+#if defined(SHT_CONV_ALL) || (SHT_CONV==SHT_CONV_FIXED)
+#define SHT_CONV_USE_FIXED
+#endif
+#if defined(SHT_CONV_ALL) || (SHT_CONV==SHT_CONV_TABLE)
+#define SHT_CONV_USE_TABLE
+#include "sht11tab.h" // tables (generated by test/tabgen)
+#endif
 
-/// sht registers to int conversion
-void sht2int(uint16_t tR, uint16_t hR, int16_t *T, int16_t *H)
+/** fixed-point coefficients (computed from datasheet constants by compiler) */
+
+/// round constant expression to nearest integer
+#define FX_ROUND(x) ((int32_t)(((x)<0)?((x)-0.5):((x)+0.5)))
+
+/// fixed-point coefficient set
+///   T*10 = (tR*tmul + tofs) / 10
+///   RH*10 = n / scale, n = c1 + c2*hR - c3q*hR^2 (Q14) + (tR*cmt + cofs)*(cmul - tR*cmn)
+/// cmt and cmn make the temp. compensation factors integer, scale makes their product exact
+typedef struct {
+    int16_t tmul, tofs;
+    int32_t scale;
+    int32_t c1, c2, c3q;
+    int16_t cmt, cofs, cmul, cmn;
+} fx_coef_t;
+
+/// RH scale for given constants
+#define FX_SCALE(d2,t2,cmt,cmn) FX_ROUND((cmt)*(cmn)/(10.0*(d2)*(t2)))
+/// coefficient set initializer
+#define FX_COEF(c1,c2,c3,d1,d2,t1,t2,cmt,cmn) { \
+    FX_ROUND((d2)*100.0), FX_ROUND((d1)*100.0), \
+    FX_SCALE(d2,t2,cmt,cmn), \
+    FX_ROUND((c1)*10.0*FX_SCALE(d2,t2,cmt,cmn)), \
+    FX_ROUND((c2)*10.0*FX_SCALE(d2,t2,cmt,cmn)), \
+    FX_ROUND(-(c3)*10.0*FX_SCALE(d2,t2,cmt,cmn)*16384.0), \
+    (cmt), FX_ROUND((cmt)*((d1)-25.0)/(d2)), FX_ROUND((cmn)*(t1)/(t2)), (cmn) }
+
+/// float coefficient set (double constants, same as datasheet macros)
+typedef struct {
+    double c1, c2, c3, d1, d2, t1, t2;
+} fl_coef_t;
+
+/** engines (common code for both resolutions) */
+
+#ifdef SHT_CONV_USE_FLOAT
+/// 14bit T, 12bit RH
+static const fl_coef_t fl_high = {C1,C2,C3,D1,D2,T1,T2};
+/// 12bit T, 8bit RH
+static const fl_coef_t fl_low = {C1L,C2L,C3L,D1L,D2L,T1L,T2L};
+
+/// float engine
+static void float_conv(uint16_t tR, uint16_t hR, int16_t *T, int16_t *H, const fl_coef_t *c)
 {
     float tRd = (float) tR;
     float hRd = (float) hR;
 
     // linear RH
-    float dRH = C1 + C2*hRd + C3*hRd*hRd;
+    float dRH = c->c1 + c->c2*hRd + c->c3*hRd*hRd;
     // temperature
-    float dT = D1 + D2*tRd;
+    float dT = c->d1 + c->d2*tRd;
     // temp. compensated RH
-    float dRHc = (dT - 25.0) * (T1 - T2*tRd) + dRH;
+    float dRHc = (dT - 25.0) * (c->t1 - c->t2*tRd) + dRH;
     if (dRHc>100.0) dRHc=100.0;
     if (dRHc<0) dRHc=0;
 
@@ -37,8 +97,278 @@ void sht2int(uint16_t tR, uint16_t hR, int16_t *T, int16_t *H)
     int16_t iT = (int16_t)((float)(dT*10.0));
 
     // return values
-    *T = iT;
-    *H = iRH;
+    if (T) *T = iT;
+    if (H) *H = iRH;
+}
+#endif
+
+#ifdef SHT_CONV_USE_FIXED
+/// 14bit T, 12bit RH (factors (tR-6470)*(125-tR), scale 125000)
+static const fx_coef_t fx_high = FX_COEF(C1,C2,C3,D1,D2,T1,T2,1,1);
+#endif
+#if defined(SHT_CONV_USE_FIXED) || defined(SHT_CONV_USE_TABLE)
+/// 12bit T, 8bit RH (factors (2*tR-3235)*(125-16*tR), scale 62500)
+static const fx_coef_t fx_low = FX_COEF(C1L,C2L,C3L,D1L,D2L,T1L,T2L,2,16);
+
+/// fixed-point RH (0 .. 1000)
+/// all terms of RH are scaled, so the only rounding is in quadratic term
+static int16_t fixed_rh(uint16_t tR, uint16_t hR, const fx_coef_t *c)
+{
+    // linear RH (h^2 term split to stay inside 32bits)
+    int32_t n = c->c1 + c->c2*(int32_t)hR;
+    n -= (((uint32_t)hR*c->c3q)>>8)*hR>>6;
+    // temp. compensated RH
+    n += (int32_t)((int16_t)tR*c->cmt + c->cofs) * (c->cmul - (int32_t)tR*c->cmn);
+    if (n>1000L*c->scale) n=1000L*c->scale;
+    if (n<0) n=0;
+    return (int16_t)(n/c->scale);
+}
+
+/// fixed-point engine (no float library needed)
+static void fixed_conv(uint16_t tR, uint16_t hR, int16_t *T, int16_t *H, const fx_coef_t *c)
+{
+    // temperature (division truncates toward zero the same way float->int cast does)
+    if (T) *T = ((int16_t)tR*c->tmul + c->tofs) / 10;
+    if (H) *H = fixed_rh(tR,hR,c);
+}
+#endif
+
+#ifdef SHT_CONV_USE_FIXED
+#ifndef __MSP430__
+/// conversions per block of batch (fixed count, so the compiler replaces whole loop by vector code)
+#define SHT_BATCH_BLOCK 16
+
+/// fixed-point engine for n register pairs (the same arithmetic as fixed_conv, no branches)
+static inline void fixed_batch(const uint16_t *__restrict tR, const uint16_t *__restrict hR,
+                               int16_t *__restrict T, int16_t *__restrict H, size_t n)
+{
+    const int32_t max = 1000L*fx_high.scale;
+    size_t i;
+    for (i=0;i<n;i++)
+    {
+        int32_t ts = (int16_t)tR[i];
+        int32_t tu = tR[i];
+        uint32_t h = hR[i];
+
+        T[i] = (int16_t)((ts*fx_high.tmul + fx_high.tofs) / 10);
+        int32_t r = fx_high.c1 + fx_high.c2*(int32_t)h;
+        r -= (int32_t)((((h*(uint32_t)fx_high.c3q)>>8)*h)>>6);
+        r += (ts*fx_high.cmt + fx_high.cofs) * (fx_high.cmul - tu*fx_high.cmn);
+        r = (r>max) ? max : r;
+        r = (r<0) ? 0 : r;
+        H[i] = (int16_t)(r/fx_high.scale);
+    }
+}
+
+/// blocks of SHT_BATCH_BLOCK conversions and the rest
+static inline void fixed_blocks(const uint16_t *tR, const uint16_t *hR, int16_t *T, int16_t *H, size_t n)
+{
+    for (;n>=SHT_BATCH_BLOCK;n-=SHT_BATCH_BLOCK)
+    {
+        fixed_batch(tR,hR,T,H,SHT_BATCH_BLOCK);
+        tR += SHT_BATCH_BLOCK; hR += SHT_BATCH_BLOCK;
+        T += SHT_BATCH_BLOCK; H += SHT_BATCH_BLOCK;
+    }
+    fixed_batch(tR,hR,T,H,n); // rest
+}
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && !defined(SHT_BATCH_NO_AVX2)
+/// the same compiled for AVX2 (8 lanes, 32bit vector multiply), picked at runtime on CPUs
+/// that have it (default x86 build is SSE2 only, about 3.5x slower)
+#define SHT_BATCH_AVX2
+__attribute__((target("avx2")))
+static void fixed_blocks_avx2(const uint16_t *tR, const uint16_t *hR, int16_t *T, int16_t *H, size_t n)
+{
+    fixed_blocks(tR,hR,T,H,n);
+}
+#endif
+#endif
+#endif
+
+/** interface section */
+
+/// sht registers to int conversion
+void sht2int(uint16_t tR, uint16_t hR, int16_t *T, int16_t *H)
+{
+    PROF_START(prof);
+#if (SHT_CONV==SHT_CONV_FLOAT)
+    sht2int_float(tR,hR,T,H);
+#elif (SHT_CONV==SHT_CONV_TABLE)
+    sht2int_table(tR,hR,T,H);
+#else
+    sht2int_fixed(tR,hR,T,H);
+#endif
+    PROF_END(PROF_SHT2INT,prof);
+}
+
+/// sht registers to int conversion (low resolution, table engine uses fixed-point)
+void sht2int_lowres(uint16_t tR, uint16_t hR, int16_t *T, int16_t *H)
+{
+    PROF_START(prof);
+#if (SHT_CONV==SHT_CONV_FLOAT)
+    sht2int_float_lowres(tR,hR,T,H);
+#else
+    sht2int_fixed_lowres(tR,hR,T,H);
+#endif
+    PROF_END(PROF_SHT2INT,prof);
+}
+
+#ifdef SHT_CONV_USE_FLOAT
+/// sht registers to int conversion (float engine)
+void sht2int_float(uint16_t tR, uint16_t hR, int16_t *T, int16_t *H)
+{
+    float_conv(tR,hR,T,H,&fl_high);
+}
+
+void sht2int_float_lowres(uint16_t tR, uint16_t hR, int16_t *T, int16_t *H)
+{
+    float_conv(tR,hR,T,H,&fl_low);
+}
+#endif
+
+#ifdef SHT_CONV_USE_FIXED
+/// sht registers to int conversion (fixed-point engine)
+void sht2int_fixed(uint16_t tR, uint16_t hR, int16_t *T, int16_t *H)
+{
+    fixed_conv(tR,hR,T,H,&fx_high);
+}
+#endif
+
+#ifdef SHT_CONV_USE_FIXED
+/// sht registers to int conversion of arrays (results equal to sht2int_fixed)
+/// host: blocks of SHT_BATCH_BLOCK, auto-vectorized at -O2 (x86: AVX2 copy if CPU has it)
+/// MSP430: scalar loop (no vector unit, no code duplication in flash)
+void sht2int_batch(const uint16_t *tR, const uint16_t *hR, int16_t *T, int16_t *H, size_t n)
+{
+#ifdef __MSP430__
+    while (n--) fixed_conv(*tR++,*hR++,T++,H++,&fx_high);
+#elif defined(SHT_BATCH_AVX2)
+    if (__builtin_cpu_supports("avx2")) fixed_blocks_avx2(tR,hR,T,H,n);
+    else fixed_blocks(tR,hR,T,H,n);
+#else
+    fixed_blocks(tR,hR,T,H,n);
+#endif
+}
+#endif
+
+#if defined(SHT_CONV_USE_FIXED) || defined(SHT_CONV_USE_TABLE)
+void sht2int_fixed_lowres(uint16_t tR, uint16_t hR, int16_t *T, int16_t *H)
+{
+    fixed_conv(tR,hR,T,H,&fx_low);
+}
+#endif
+
+#ifdef SHT_CONV_USE_TABLE
+/// linear interpolation between table points (Q4 result)
+static int16_t tab_interp(const int16_t *tab, uint16_t reg)
+{
+    const int16_t *p = &tab[reg>>SHT_TAB_SHIFT];
+    uint8_t frac = reg & ((1<<SHT_TAB_SHIFT)-1);
+    return p[0] + (((int16_t)(p[1]-p[0])*frac)>>SHT_TAB_SHIFT);
+}
+
+/// sht registers to int conversion (lookup table engine)
+/// registers are masked to 14bit (T) and 12bit (RH) to stay inside tables
+void sht2int_table(uint16_t tR, uint16_t hR, int16_t *T, int16_t *H)
+{
+    tR &= 0x3FFF;
+    hR &= 0x0FFF;
+
+    // temperature (Q4, truncate toward zero)
+    int16_t q = tab_interp(sht_ttab,tR);
+    if (T) *T = (q<0) ? -((-q)>>4) : (q>>4);
+    if (H==0) return;
+
+    // temp. compensated RH (Q4)
+    q = tab_interp(sht_rtab,hR) + tab_interp(sht_ctab,tR);
+    if (q>(1000<<4)) q=(1000<<4);
+    if (q<0) q=0;
+    *H = q>>4;
+}
+#endif
+
+/** dew point and absolute humidity (log2 domain, Q11, only table lookups and shifts) */
+
+/// interpolation in increasing table (x>>shift index, lower bits fraction)
+/// table steps are chosen so that step*fraction stays inside 16 bits unsigned
+static int16_t dew_interp(const int16_t *tab, uint16_t x, uint8_t shift)
+{
+    const int16_t *p = &tab[x>>shift];
+    uint16_t frac = x & ((1<<shift)-1);
+    return p[0] + (int16_t)(((uint16_t)(p[1]-p[0])*frac)>>shift);
+}
+
+/// log2(RH/100) (Q11) from RH*10 (0.1 .. 100 %, 0 is taken as 0.1 %)
+static int16_t dew_log2rh(int16_t H)
+{
+    uint16_t m;
+    int16_t e = 15;
+    if (H<1) H = 1;
+    if (H>1000) H = 1000;
+    m = H;
+    while ((m&0x8000)==0) // normalize, log2(H) = e + log2(m/2^15)
+    {
+        m <<= 1;
+        e--;
+    }
+    return (e<<11) + dew_interp(sht_dew_log2,(m>>2)&0x1FFF,8) - 20411; // log2(1000)
+}
+
+/// T*10 to temperature table position (clamped to table range)
+static uint16_t dew_tpos(int16_t T)
+{
+    if (T<SHT_DEW_T0) T = SHT_DEW_T0;
+    if (T>SHT_DEW_TMAX) T = SHT_DEW_TMAX;
+    return T - SHT_DEW_T0;
+}
+
+/// dew point *10 (C), Magnus formula: gamma = ln(RH/100) + b*T/(c+T), Td = c*gamma/(b-gamma)
+/// max. error 0.1 C against double formula (test/convtest)
+int16_t sht_dewpoint(int16_t T, int16_t H)
+{
+    int16_t g, q;
+    PROF_START(prof);
+    g = dew_log2rh(H) + dew_interp(sht_dew_gtab,dew_tpos(T),SHT_DEW_TSHIFT); // gamma/ln2
+    if (g<SHT_DEW_G0) g = SHT_DEW_G0;
+    if (g>SHT_DEW_GMAX) g = SHT_DEW_GMAX;
+    q = dew_interp(sht_dew_tdtab,(uint16_t)(g-SHT_DEW_G0)>>1,SHT_DEW_GSHIFT-1); // Q2
+    PROF_END(PROF_DEWPOINT,prof);
+    return (q<0) ? -((-q+2)>>2) : ((q+2)>>2);
+}
+
+/// absolute humidity *10 (g/m^3) = RH/100 * saturated vapour density (Magnus, ideal gas)
+/// computed as 2^(log2(RH/100) + log2(density)), max. error 0.2 g/m^3 up to 60 C,
+/// approx. 0.3 % of value above (test/convtest)
+int16_t sht_abshum(int16_t T, int16_t H)
+{
+    int16_t y, n;
+    uint16_t m;
+    if (H<=0) return 0;
+    y = dew_log2rh(H) + dew_interp(sht_dew_atab,dew_tpos(T),SHT_DEW_TSHIFT); // log2(AH*10)
+    if (y<-(2<<11)) return 0; // below 0.025 g/m^3
+    n = ((uint16_t)(y+(2<<11))>>11) - 2; // integer part (floor)
+    m = dew_interp(sht_dew_pow2,y&0x7FF,6); // 2^fraction (Q12)
+    if (n>=12) return m<<(n-12);
+    return (m + (1<<(11-n))) >> (12-n);
+}
+
+/** bcd section (no division, MCU has no divider) */
+
+/// binary (0 .. 7999) to packed bcd, double dabble: before every shift
+/// digits >= 5 get +3 (all four nibbles at once, no carry between them)
+static uint16_t dabble(uint16_t bin)
+{
+    uint16_t bcd = 0;
+    uint8_t i;
+    bin <<= 3; // 13 bits to top
+    for (i=0;i<13;i++)
+    {
+        uint16_t c = (bcd + 0x3333) & 0x8888; // bit 3 set in nibbles >= 5
+        bcd += (c>>2) | (c>>3);
+        bcd = (bcd<<1) | (bin>>15);
+        bin <<= 1;
+    }
+    return bcd;
 }
 
 /// function converting int (-7999 .. 7999) to bcd with sign (msb)
@@ -46,23 +376,42 @@ void sht2int(uint16_t tR, uint16_t hR, int16_t *T, int16_t *H)
 uint16_t int2bcd(int16_t w)
 {
     uint16_t buf;
+    PROF_START(prof);
     // test for limits
-    if (w>7999) return 0x7999;
-    if (w<-7999) return 0xF999; // (0x7999|0x8000)
-    // test for <0 values
-    if ((w&0x8000)!=0) buf=-w; else buf=w;
-    // convert
-    uint16_t bcd = buf%10;
-    uint16_t mul = 1;
-    buf /= 10;
-    while (buf!=0)
+    if (w>7999) buf = 0x7999;
+    else if (w<-7999) buf = 0xF999; // (0x7999|0x8000)
+    else
     {
-        mul <<= 4;
-        bcd |= buf%10*mul;
-        buf /= 10;
+        // test for <0 values
+        if ((w&0x8000)!=0) buf=-w; else buf=w;
+        // convert, add sign
+        buf = dabble(buf) | (w&0x8000);
     }
-    // add sign
-    bcd|=(w&0x8000);
+    PROF_END(PROF_INT2BCD,prof);
     // return value
-    return bcd;
+    return buf;
+}
+
+#if defined(SHT_CONV_USE_FIXED) && (defined(SHT_BCD) || defined(SHT_CONV_ALL))
+/// unsigned division by 10 by shifts and adds (exact for 0 .. 65535)
+static uint16_t divu10(uint16_t n)
+{
+    uint16_t q = (n>>1) + (n>>2);
+    q += q>>4;
+    q += q>>8;
+    q >>= 3;
+    n -= (q<<3) + (q<<1); // remainder (0 .. 19)
+    return q + (n>9);
+}
+
+/// sht registers directly to bcd (the same as int2bcd of sht2int_fixed results)
+/// temperature goes register -> magnitude -> bcd without int value and division
+void sht2bcd(uint16_t tR, uint16_t hR, uint16_t *T, uint16_t *H)
+{
+    int v = (int16_t)tR*fx_high.tmul + fx_high.tofs; // T*100 (the same expression as fixed_conv)
+    uint16_t m = divu10((v<0) ? -v : v); // |T*10| truncated toward zero, always < 7999
+    *T = dabble(m);
+    if ((v<0)&&(m!=0)) *T |= 0x8000; // no sign for -0
+    *H = dabble(fixed_rh(tR,hR,&fx_high));
 }
+#endif
@@ -9,6 +9,7 @@
 #define __SHT11CON_H__
 
 #include <inttypes.h>
+#include <stddef.h>
 
 /** conversion constants (see sht11 datasheet) */
 
@@ -25,9 +26,61 @@
 #define T1 0.01
 #define T2 0.00008
 
-/// sht registers to int conversion
+/// RH 8bit (low resolution)
+#define C1L -2.0468
+#define C2L 0.5872
+#define C3L -4.0845e-4
+
+/// T 12bit 3.5V (low resolution)
+#define D1L -39.7
+#define D2L 0.04
+
+/// RH temp. compensation (RH 8bit)
+#define T1L 0.01
+#define T2L 0.00128
+
+/// dew point, Magnus formula over water (valid -45 .. 60 C)
+#define DP_B 17.62
+#define DP_C 243.12
+/// saturation vapour pressure at 0 C (hPa)
+#define DP_E0 6.112
+/// absolute humidity (g/m^3) = AH_K * vapour pressure (hPa) / (273.15+T)
+#define AH_K 216.7
+
+/** conversion engine selection */
+
+/// float engine (datasheet formulas, pulls soft-float library in)
+#define SHT_CONV_FLOAT 0
+/// fixed-point engine (integer only)
+#define SHT_CONV_FIXED 1
+/// lookup table engine (sht11tab.h generated by test/tabgen, ~1.2kB flash), not a speed
+/// option: slower than fixed-point on host, MSP430 cycles not measured (SHT_PROF 'p' SHT2INT)
+#define SHT_CONV_TABLE 2
+
+/// engine used by sht2int() (define SHT_CONV_ALL to build every engine - host tests)
+#ifndef SHT_CONV
+#define SHT_CONV SHT_CONV_FIXED
+#endif
+
+/// sht registers to int conversion (T or H may be NULL, that part is not computed)
 void sht2int(uint16_t tR, uint16_t hR, int16_t *T, int16_t *H);
+/// sht registers to int conversion (low resolution - 12bit T, 8bit RH)
+void sht2int_lowres(uint16_t tR, uint16_t hR, int16_t *T, int16_t *H);
+/// conversion engines (sht2int calls the selected one)
+void sht2int_float(uint16_t tR, uint16_t hR, int16_t *T, int16_t *H);
+void sht2int_float_lowres(uint16_t tR, uint16_t hR, int16_t *T, int16_t *H);
+void sht2int_fixed(uint16_t tR, uint16_t hR, int16_t *T, int16_t *H);
+void sht2int_fixed_lowres(uint16_t tR, uint16_t hR, int16_t *T, int16_t *H);
+void sht2int_table(uint16_t tR, uint16_t hR, int16_t *T, int16_t *H);
+/// sht registers to int conversion of arrays (fixed-point engine, vectorized on host)
+void sht2int_batch(const uint16_t *tR, const uint16_t *hR, int16_t *T, int16_t *H, size_t n);
+/// dew point *10 (C) from T*10 and RH*10 (integer, tables sht11dew.h generated by test/tabgen)
+int16_t sht_dewpoint(int16_t T, int16_t H);
+/// absolute humidity *10 (g/m^3) from T*10 and RH*10 (integer, the same tables)
+int16_t sht_abshum(int16_t T, int16_t H);
 /// function converting int (-7999 .. 7999) to bcd with sign (msb)
 uint16_t int2bcd(int16_t w);
+/// sht registers to bcd values (= int2bcd of sht2int_fixed, no division), build with SHT_BCD
+void sht2bcd(uint16_t tR, uint16_t hR, uint16_t *T, uint16_t *H);
 
 #endif
@@ -0,0 +1,74 @@
+/*
+ * sht11dew.h
+ *
+ *  Generated by test/tabgen from sht11con.h constants - do not edit
+ *
+ *  Dew point and absolute humidity tables (sht_dewpoint, sht_abshum), log2 domain Q11
+ */
+
+#ifndef __SHT11DEW_H__
+#define __SHT11DEW_H__
+
+#include <inttypes.h>
+
+/// table ranges (T*10 from -400 step 32, log2 gamma Q11 from -15 step 1/4)
+#define SHT_DEW_T0 (-400)
+#define SHT_DEW_TMAX 1250
+#define SHT_DEW_TSHIFT 5
+#define SHT_DEW_G0 (-15*2048)
+#define SHT_DEW_GMAX (9*2048-1)
+#define SHT_DEW_GSHIFT 9
+
+/// log2(1+i/32) (Q11)
+static const int16_t sht_dew_log2[33] = {
+         0,     91,    179,    265,    348,    429,    508,    585,
+       659,    732,    803,    873,    941,   1007,   1072,   1136,
+      1198,   1259,   1319,   1377,   1435,   1491,   1546,   1600,
+      1653,   1706,   1757,   1808,   1857,   1906,   1954,   2001,
+      2048};
+
+/// 2^(i/32) (Q12)
+static const int16_t sht_dew_pow2[33] = {
+      4096,   4186,   4277,   4371,   4467,   4565,   4664,   4767,
+      4871,   4978,   5087,   5198,   5312,   5428,   5547,   5668,
+      5793,   5919,   6049,   6182,   6317,   6455,   6597,   6741,
+      6889,   7039,   7194,   7351,   7512,   7677,   7845,   8016,
+      8192};
+
+/// Magnus b*T/(c+T)/ln2 (Q11) at T*10 = -400+32*i
+static const int16_t sht_dew_gtab[53] = {
+    -10252,  -9286,  -8349,  -7440,  -6558,  -5702,  -4871,  -4063,
+     -3278,  -2514,  -1771,  -1049,   -345,    340,   1008,   1659,
+      2293,   2911,   3514,   4103,   4678,   5238,   5786,   6321,
+      6844,   7355,   7855,   8344,   8821,   9289,   9747,  10194,
+     10633,  11062,  11483,  11895,  12299,  12695,  13083,  13463,
+     13836,  14202,  14561,  14913,  15259,  15598,  15931,  16258,
+     16579,  16895,  17204,  17509,  17808};
+
+/// log2 saturated vapour density*10 g/m^3 (Q11) at T*10 = -400+32*i
+static const int16_t sht_dew_atab[53] = {
+      1684,   2610,   3507,   4377,   5220,   6037,   6831,   7602,
+      8350,   9077,   9784,  10472,  11140,  11791,  12424,  13041,
+     13642,  14227,  14798,  15354,  15897,  16426,  16942,  17447,
+     17939,  18419,  18889,  19348,  19796,  20235,  20664,  21083,
+     21493,  21894,  22287,  22672,  23048,  23417,  23778,  24132,
+     24479,  24819,  25152,  25478,  25798,  26113,  26421,  26723,
+     27020,  27311,  27596,  27877,  28152};
+
+/// dew point*10 (Q2) at log2 gamma = -15+i/4
+static const int16_t sht_dew_tdtab[97] = {
+     -3609,  -3571,  -3532,  -3493,  -3454,  -3414,  -3373,  -3332,
+     -3291,  -3248,  -3206,  -3162,  -3119,  -3074,  -3029,  -2983,
+     -2937,  -2890,  -2843,  -2794,  -2746,  -2696,  -2646,  -2595,
+     -2543,  -2490,  -2437,  -2383,  -2328,  -2272,  -2216,  -2158,
+     -2100,  -2040,  -1980,  -1919,  -1857,  -1794,  -1730,  -1665,
+     -1598,  -1531,  -1463,  -1393,  -1322,  -1250,  -1177,  -1102,
+     -1027,   -949,   -871,   -791,   -709,   -626,   -542,   -456,
+      -368,   -279,   -188,    -95,      0,     97,    195,    296,
+       398,    503,    610,    719,    830,    944,   1061,   1180,
+      1301,   1426,   1553,   1683,   1816,   1952,   2092,   2235,
+      2381,   2531,   2685,   2843,   3005,   3171,   3341,   3516,
+      3696,   3880,   4070,   4265,   4466,   4673,   4885,   5104,
+      5330};
+
+#endif
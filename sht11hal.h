@@ -0,0 +1,179 @@
+/*
+ * sht11hal.h
+ *
+ *  Created on: 17.10.2026
+ *      Author: agent
+ *
+ *  SHT11 hardware abstraction (pins, delays, interrupts, timer)
+ *
+ *  default .. MSP430G2553 (DATA P2.0, SCK P2.1, Timer1_A from ACLK)
+ *  SHT_HOST .. host build, pins and time are simulated by test/shtsim
+ *
+ *  pin interface:
+ *
+ *      SHT_PORT_INIT() .. port initialization
+ *      SHT_DATA_OUT(x) .. x!=0 pull DATA down, x==0 release DATA (pullup)
+ *      SHT_DATA_IN .. DATA line state (0/1)
+ *      SHT_SCK(x) .. SCK line state
+ *      delay_us(x) .. busy wait (x us, UART_SMCLK/1000000 cycles per us)
+ *
+ *  asynchronous measurement interface:
+ *
+ *      SHT_DATA_IRQ_ON() .. enable DATA falling edge interrupt
+ *      SHT_DATA_IRQ_OFF() .. disable DATA interrupt (and clear flag)
+ *      SHT_DATA_IRQ_FORCE() .. set DATA interrupt flag
+ *      SHT_TIMER_START(period) .. start timer (ACLK, up mode)
+ *      SHT_TIMER_STOP() .. stop timer
+ *      SHT_IRQ_DISABLE(), SHT_IRQ_ENABLE() .. global interrupt disable/enable
+ *      SHT_SLEEP() .. sleep (LPM3, LPM0 in SHT_PROF build) until interrupt, interrupts disabled again after wake up
+ *          (0 when there is nothing to wait for - host simulator only)
+ *
+ *  USCI_B0 byte transport (SHT_SPI build, 8 data bits of a byte, start and ACK clock stay on pins):
+ *
+ *      SHT_SPI_INIT() .. USCI_B0 3-pin SPI master, SMCLK/SHT_SPI_BR, MSB first, capture on SCK rise
+ *      SHT_SPI_ON(out) .. SCK handed to USCI (and DATA driven by SIMO if out), DATA pin released
+ *          (SCK low, kept driven low during the handover)
+ *      SHT_SPI_OFF() .. SCK and DATA back to pins (SCK kept driven low)
+ *      SHT_SPI_TX(x) .. start transfer of byte x (8 clocks)
+ *      SHT_SPI_DONE .. transfer done (byte received)
+ *      SHT_SPI_RX .. received byte (clears done)
+ *
+ *  multi-sensor bus interface (sht11m.c, DATA lines of one port, shared SCK):
+ *
+ *      SHTM_PORT_INIT(mask) .. port initialization (DATA lines in mask released)
+ *      SHTM_DATA_OUT(mask,low) .. DATA lines in mask: pull down those in low, release others
+ *      SHTM_DATA_IN .. all DATA lines (one port read)
+ *      SHTM_SCK(x) .. shared SCK line state
+ *
+ */
+
+#ifndef __SHT11HAL_H__
+#define __SHT11HAL_H__
+
+// SMCLK frequency (the same define as uart.h, set for the whole build, e.g. -DUART_SMCLK=8000000)
+#ifndef UART_SMCLK
+#define UART_SMCLK 1000000
+#endif
+
+// USCI_B0 transport clock divider, SCK max. 500kHz (SCK low 1us covers sensor DATA valid
+// time 600ns max, 3V supply allows up to 1MHz SCK): 2 at 1MHz, 16 at 8MHz, 32 at 16MHz
+#ifndef SHT_SPI_BR
+#define SHT_SPI_BR ((UART_SMCLK+499999)/500000)
+#endif
+#if (SHT_SPI_BR<1)||(SHT_SPI_BR>255)||(UART_SMCLK/SHT_SPI_BR>500000)
+#error "sht11hal: SHT_SPI_BR gives SCK over 500kHz for UART_SMCLK (or out of UCB0BR0 range)"
+#endif
+
+#ifndef SHT_HOST
+
+// register names
+#include <msp430g2553.h>
+
+// delay (MCLK = SMCLK, whole MHz)
+#define delay_us(x) __delay_cycles((unsigned long)(x)*(UART_SMCLK/1000000))
+// port (DATA P2.0, SCK P2.1)
+#define SHT_PORT_INIT() {P2DIR|=0x03;P2OUT&=~0x03;}
+#define SHT_DATA_OUT(x) {if (x!=0) P2DIR|=0x01; else P2DIR&=~0x01;}
+#define SHT_DATA_IN (((P2IN&0x01)!=0)?1:0)
+#define SHT_SCK(x) {if (x!=0) P2OUT|=0x02; else P2OUT&=~0x02;}
+// DATA falling edge interrupt (conversion done)
+#define SHT_DATA_IRQ_ON() {P2IES|=0x01;P2IFG&=~0x01;P2IE|=0x01;}
+#define SHT_DATA_IRQ_OFF() {P2IE&=~0x01;P2IFG&=~0x01;}
+#define SHT_DATA_IRQ_FORCE() {P2IFG|=0x01;}
+// async timer (Timer1_A, ACLK, up mode)
+#define SHT_TIMER_START(period) {TA1CCR0=(period);TA1CCTL0=CCIE;TA1CTL=TASSEL_1+MC_1+TACLR;}
+#define SHT_TIMER_STOP() {TA1CTL=0;TA1CCTL0=0;}
+// waiting for asynchronous measurement
+#define SHT_IRQ_DISABLE() __disable_interrupt()
+#define SHT_IRQ_ENABLE() __enable_interrupt()
+// SHT_PROF build keeps SMCLK on (Timer0_A counts SMCLK/8 for scheduler and timestamps, timer.c)
+#ifdef SHT_PROF
+#define SHT_SLEEP() (__bis_SR_register(LPM0_bits + GIE),__disable_interrupt(),1)
+#else
+#define SHT_SLEEP() (__bis_SR_register(LPM3_bits + GIE),__disable_interrupt(),1)
+#endif
+
+// USCI_B0 transport (SHT_SPI): SCK also wired to P1.5 (UCB0CLK), DATA also to P1.6 (UCB0SOMI)
+// and through 1k to P1.7 (UCB0SIMO, push-pull, the resistor limits ACK overlap at the 8th clock)
+// P1.6 is launchpad green LED (jumper J5 removed, main.c doesn't use it in SHT_SPI build)
+#define SHT_SPI_INIT() {P1DIR&=~0xE0;P1SEL&=~0xE0;P1SEL2&=~0xE0;UCB0CTL1=UCSWRST; \
+	UCB0CTL0=UCCKPH+UCMSB+UCMST+UCSYNC;UCB0CTL1=UCSSEL_2+UCSWRST;UCB0BR0=SHT_SPI_BR;UCB0BR1=0; \
+	UCB0CTL1&=~UCSWRST;}
+// SCK (pullup) is driven low through the whole handover: P1.5 joins P2.1 as output low, the
+// USCI pins are selected (P1SEL2 first, never P1SEL=1/P1SEL2=0), and only then P2.1/P2.0
+// are released; back the same way round (P1.5 ends as input again)
+#define SHT_SPI_ON(out) {P1OUT&=~0x20;P1DIR|=0x20; \
+	if (out) {P1SEL2|=0xA0;P1SEL|=0xA0;} else {P1SEL2|=0x60;P1SEL|=0x60;} P2DIR&=~0x03;}
+#define SHT_SPI_OFF() {P2OUT&=~0x02;P2DIR|=0x02;P1SEL&=~0xE0;P1SEL2&=~0xE0;P1DIR&=~0x20;}
+#define SHT_SPI_TX(x) {UCB0TXBUF=(x);}
+#define SHT_SPI_DONE (IFG2&UCB0RXIFG)
+#define SHT_SPI_RX (UCB0RXBUF)
+
+// multi-sensor bus (DATA lines P2.x, shared SCK P1.4)
+// P2.6, P2.7 can be used only when no crystal is connected (XIN, XOUT)
+#define SHTM_PORT_INIT(mask) {P2SEL&=~(mask);P2SEL2&=~(mask);P2OUT&=~(mask);P2DIR&=~(mask);P1OUT&=~0x10;P1DIR|=0x10;}
+#define SHTM_DATA_OUT(mask,low) {P2DIR=(P2DIR&~(mask))|(low);}
+#define SHTM_DATA_IN (P2IN)
+#define SHTM_SCK(x) {if (x!=0) P1OUT|=0x10; else P1OUT&=~0x10;}
+
+#else // SHT_HOST
+
+// host simulator interface (test/shtsim/shtsim.c)
+void shtsim_port_init(void);
+void shtsim_data_out(unsigned char x);
+unsigned char shtsim_data_in(void);
+void shtsim_sck(unsigned char x);
+void shtsim_delay(unsigned long cycles);
+void shtsim_irq(unsigned char on);
+void shtsim_irq_force(void);
+void shtsim_timer(unsigned int period);
+void shtsim_mport_init(unsigned char mask);
+void shtsim_mdata_out(unsigned char mask, unsigned char low);
+unsigned char shtsim_mdata_in(void);
+unsigned char shtsim_sleep(void);
+void shtsim_spi_init(unsigned char br);
+void shtsim_spi_on(unsigned char out);
+void shtsim_spi_off(void);
+void shtsim_spi_tx(unsigned char x);
+unsigned char shtsim_spi_done(void);
+unsigned char shtsim_spi_rx(void);
+
+// delay
+#define delay_us(x) shtsim_delay(x)
+// port
+#define SHT_PORT_INIT() {shtsim_port_init();}
+#define SHT_DATA_OUT(x) {shtsim_data_out(x);}
+#define SHT_DATA_IN shtsim_data_in()
+#define SHT_SCK(x) {shtsim_sck(x);}
+// DATA falling edge interrupt
+#define SHT_DATA_IRQ_ON() {shtsim_irq(1);}
+#define SHT_DATA_IRQ_OFF() {shtsim_irq(0);}
+#define SHT_DATA_IRQ_FORCE() {shtsim_irq_force();}
+// async timer (period 0 .. stop)
+#define SHT_TIMER_START(period) {shtsim_timer((period)+1);}
+#define SHT_TIMER_STOP() {shtsim_timer(0);}
+// waiting (simulator runs interrupt routines while sleeping)
+#define SHT_IRQ_DISABLE()
+#define SHT_IRQ_ENABLE()
+#define SHT_SLEEP() shtsim_sleep()
+// USCI_B0 transport (simulated on single sensor lines)
+#define SHT_SPI_INIT() {shtsim_spi_init(SHT_SPI_BR);}
+#define SHT_SPI_ON(out) {shtsim_spi_on(out);}
+#define SHT_SPI_OFF() {shtsim_spi_off();}
+#define SHT_SPI_TX(x) {shtsim_spi_tx(x);}
+#define SHT_SPI_DONE shtsim_spi_done()
+#define SHT_SPI_RX shtsim_spi_rx()
+// multi-sensor bus (simulated sensors share SCK with single sensor)
+#define SHTM_PORT_INIT(mask) {shtsim_mport_init(mask);}
+#define SHTM_DATA_OUT(mask,low) {shtsim_mdata_out(mask,low);}
+#define SHTM_DATA_IN shtsim_mdata_in()
+#define SHTM_SCK(x) {shtsim_sck(x);}
+
+// interrupt routines are plain functions called by simulator
+#define __interrupt
+#define __bic_SR_register_on_exit(x)
+#define LPM3_bits 0
+
+#endif // SHT_HOST
+
+#endif
@@ -0,0 +1,228 @@
+/*
+ * sht11m.c
+ *
+ *  Created on: 17.10.2026
+ *      Author: agent
+ *
+ *  SHT11 multi-sensor bus module for MSP430
+ *
+ *  sensors share one SCK line, each has its own DATA line (same port)
+ *  every clock edge drives/samples all DATA lines with one port access,
+ *  so N sensors are read for the cost of one
+ *
+ *  interface functions:
+ *
+ *		shtm_init(*bus, mask) .. bus initialization (mask of DATA lines)
+ *		shtm_measure_start(*bus, mode) .. send start measure command to all sensors
+ *		shtm_measure_check(*bus, mode) .. measure all sensors, check crc
+ *		shtm_write_statusreg(*bus, value) .. write status register of all sensors
+ *		shtm_softreset(*bus) .. soft reset of all sensors
+ *
+ *  bus state (status register, per sensor ACK, errors, values) is kept in sht_bus_t handle
+ *
+ */
+
+/** include section */
+
+// hardware abstraction (pins, delays)
+#include "sht11hal.h"
+// sht commands, crc
+#include "sht11.h"
+// self
+#include "sht11m.h"
+
+/** Sensibus basics section */
+
+//----------------------------------------------------------------------------------
+// writes a byte to all sensors, returns mask of sensors which acknowledged
+//----------------------------------------------------------------------------------
+unsigned char shtm_write_byte(sht_bus_t *bus, unsigned char value)
+{
+	unsigned char i,ack;
+	for (i=0x80;i>0;i>>=1)
+	{
+		SHTM_DATA_OUT(bus->mask,(i&value)?0:bus->mask);
+		SHTM_SCK(1);
+		delay_us(5);
+		SHTM_SCK(0);
+	}
+	SHTM_DATA_OUT(bus->mask,0);				//release DATA-lines
+	SHTM_SCK(1);							//clk #9 for ack
+	ack=(~SHTM_DATA_IN)&bus->mask;			//sensors pulling DATA down
+	SHTM_SCK(0);
+	return ack;
+}
+
+//----------------------------------------------------------------------------------
+// reads a byte from all sensors (raw port samples, MSB first), gives acknowledge to sensors in ack mask
+//----------------------------------------------------------------------------------
+void shtm_read_byte(sht_bus_t *bus, unsigned char ack, unsigned char *samples)
+{
+	unsigned char i;
+	SHTM_DATA_OUT(bus->mask,0);				//release DATA-lines
+	for (i=0;i<8;i++)
+	{
+		SHTM_SCK(1);
+		samples[i]=SHTM_DATA_IN;			//all sensors at once
+		SHTM_SCK(0);
+	}
+	SHTM_DATA_OUT(bus->mask,ack);			//pull down DATA of acknowledged sensors
+	SHTM_SCK(1);							//clk #9 for ack
+	delay_us(5);
+	SHTM_SCK(0);
+	SHTM_DATA_OUT(bus->mask,0);				//release DATA-lines
+}
+
+//----------------------------------------------------------------------------------
+// get one sensor byte from raw port samples
+//----------------------------------------------------------------------------------
+unsigned char shtm_byte(unsigned char *samples, unsigned char line)
+{
+	unsigned char i,val=0;
+	for (i=0;i<8;i++)
+	{
+		val<<=1;
+		if (samples[i]&line) val|=1;
+	}
+	return val;
+}
+
+//----------------------------------------------------------------------------------
+// generates a transmission start on all DATA lines
+//----------------------------------------------------------------------------------
+void shtm_transstart(sht_bus_t *bus)
+{
+	SHTM_DATA_OUT(bus->mask,0);
+	SHTM_SCK(0);							//Initial state
+	delay_us(1);
+	SHTM_SCK(1);
+	delay_us(1);
+	SHTM_DATA_OUT(bus->mask,bus->mask);
+	delay_us(1);
+	SHTM_SCK(0);
+	delay_us(5);
+	SHTM_SCK(1);
+	delay_us(1);
+	SHTM_DATA_OUT(bus->mask,0);
+	delay_us(1);
+	SHTM_SCK(0);
+}
+
+//----------------------------------------------------------------------------------
+// communication reset: DATA-lines=1 and at least 9 SCK cycles followed by transstart
+//----------------------------------------------------------------------------------
+void shtm_connectionreset(sht_bus_t *bus)
+{
+	unsigned char i;
+	SHTM_DATA_OUT(bus->mask,0); SHTM_SCK(0);	//Initial state
+	for(i=9;i!=0;i--)						//9 SCK cycles
+	{
+		SHTM_SCK(1);
+		delay_us(1);
+		SHTM_SCK(0);
+	}
+	shtm_transstart(bus);					//transmission start
+}
+
+/** interface functions section */
+
+//----------------------------------------------------------------------------------
+// bus initialization (ports)
+//----------------------------------------------------------------------------------
+void shtm_init(sht_bus_t *bus, unsigned char mask)
+{
+	unsigned char i;
+	bus->mask = mask;
+	bus->status = 0;
+	bus->ack = 0;
+	bus->error = 0;
+	for (i=0;i<SHTM_MAX;i++) bus->value[i]=0;
+	SHTM_PORT_INIT(mask);
+}
+
+//----------------------------------------------------------------------------------
+// start measurement (humidity/temperature) on all sensors, returns ack mask
+//----------------------------------------------------------------------------------
+unsigned char shtm_measure_start(sht_bus_t *bus, unsigned char mode)
+{
+	shtm_transstart(bus);
+	switch(mode)
+	{
+		case TEMP: bus->ack=shtm_write_byte(bus,MEASURE_TEMP); break;
+		case HUMI: bus->ack=shtm_write_byte(bus,MEASURE_HUMI); break;
+		default: bus->ack=0; break;
+	}
+	return bus->ack;
+}
+
+//----------------------------------------------------------------------------------
+// measure all sensors (with waiting), check crc, returns mask of failed sensors
+//----------------------------------------------------------------------------------
+unsigned char shtm_measure_check(sht_bus_t *bus, unsigned char mode)
+{
+	unsigned char s[3][8];
+	unsigned char data[3];
+	unsigned char act,ok=0,line,ch;
+	unsigned int i=0,timeout;
+
+	if (bus->status&STATUS_LOWRES) timeout=(mode==TEMP)?SHT_TIMEOUT_12BIT:SHT_TIMEOUT_8BIT;
+	else timeout=(mode==TEMP)?SHT_TIMEOUT_14BIT:SHT_TIMEOUT_12BIT;
+
+	act = shtm_measure_start(bus,mode);		//sensors which acknowledged
+
+	while (i<timeout)						//wait for all of them
+	{
+		if ((SHTM_DATA_IN&act)==0) break;
+		delay_us(100);
+		i++;
+	}
+	act &= ~SHTM_DATA_IN;					//sensors which are done
+
+	if (act!=0)
+	{
+		// read value and checksum of all sensors at once
+		shtm_read_byte(bus,act,s[0]);
+		shtm_read_byte(bus,act,s[1]);
+		shtm_read_byte(bus,0,s[2]);
+
+		// split and check
+		data[0]=(mode==TEMP)?MEASURE_TEMP:MEASURE_HUMI;
+		for (ch=0,line=0x01;ch<SHTM_MAX;ch++,line<<=1)
+		{
+			if ((act&line)==0) continue;
+			data[1]=shtm_byte(s[0],line);
+			data[2]=shtm_byte(s[1],line);
+			if (shtm_byte(s[2],line)!=sht_crc_status(bus->status,data,3)) continue;
+			bus->value[ch]=((unsigned int)data[1]<<8)|data[2];
+			ok|=line;
+		}
+	}
+
+	bus->error = bus->mask&~ok;
+	return bus->error;
+}
+
+//----------------------------------------------------------------------------------
+// writes the status register of all sensors, returns mask of sensors without ack
+//----------------------------------------------------------------------------------
+unsigned char shtm_write_statusreg(sht_bus_t *bus, unsigned char value)
+{
+	unsigned char ack;
+	shtm_transstart(bus);
+	ack=shtm_write_byte(bus,STATUS_REG_W);
+	ack&=shtm_write_byte(bus,value);
+	bus->ack=ack;
+	if (ack==bus->mask) bus->status=value;
+	return bus->mask&~ack;
+}
+
+//----------------------------------------------------------------------------------
+// soft reset of all sensors (sensors need 11ms before next command)
+//----------------------------------------------------------------------------------
+unsigned char shtm_softreset(sht_bus_t *bus)
+{
+	shtm_connectionreset(bus);
+	bus->ack=shtm_write_byte(bus,RESET);
+	bus->status=0;
+	return bus->mask&~bus->ack;
+}
@@ -0,0 +1,38 @@
+/*
+ * sht11m.h
+ *
+ *  Created on: 17.10.2026
+ *      Author: agent
+ *
+ *  SHT11 multi-sensor bus (shared SCK, up to 8 DATA lines of one port)
+ */
+
+#ifndef SHT11M_H_
+#define SHT11M_H_
+
+// max. sensors on one bus
+#define SHTM_MAX 8
+
+// multi-sensor bus handle (bit n of masks .. sensor on DATA line n)
+typedef struct {
+	unsigned char mask;				// connected sensors
+	unsigned char status;			// status register (the same for all sensors)
+	unsigned char ack;				// sensors which acknowledged last command
+	unsigned char error;			// sensors which failed last measurement (ack, timeout, crc)
+	unsigned int value[SHTM_MAX];	// last measured values
+} sht_bus_t;
+
+// function prototypes
+
+// initialization (ports)
+void shtm_init(sht_bus_t *bus, unsigned char mask);
+// start measurement on all sensors (returns mask of sensors which acknowledged)
+unsigned char shtm_measure_start(sht_bus_t *bus, unsigned char mode);
+// measure all sensors and check crc (returns mask of failed sensors)
+unsigned char shtm_measure_check(sht_bus_t *bus, unsigned char mode);
+// write status register of all sensors (returns mask of sensors without acknowledge)
+unsigned char shtm_write_statusreg(sht_bus_t *bus, unsigned char value);
+// soft reset of all sensors (returns mask of sensors without acknowledge)
+unsigned char shtm_softreset(sht_bus_t *bus);
+
+#endif /* SHT11M_H_ */
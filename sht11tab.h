@@ -0,0 +1,101 @@
+/*
+ * sht11tab.h
+ *
+ *  Generated by test/tabgen from sht11con.h constants - do not edit
+ *
+ *  SHT11 conversion tables for sht2int table engine (SHT_CONV_TABLE)
+ */
+
+#ifndef __SHT11TAB_H__
+#define __SHT11TAB_H__
+
+#include <inttypes.h>
+
+/// register value step between table points (1<<SHT_TAB_SHIFT)
+#define SHT_TAB_SHIFT 6
+
+/// T*10 (Q4) at tR = i*64
+static const int16_t sht_ttab[257] = {
+     -6352,  -6250,  -6147,  -6045,  -5942,  -5840,  -5738,  -5635,
+     -5533,  -5430,  -5328,  -5226,  -5123,  -5021,  -4918,  -4816,
+     -4714,  -4611,  -4509,  -4406,  -4304,  -4202,  -4099,  -3997,
+     -3894,  -3792,  -3690,  -3587,  -3485,  -3382,  -3280,  -3178,
+     -3075,  -2973,  -2870,  -2768,  -2666,  -2563,  -2461,  -2358,
+     -2256,  -2154,  -2051,  -1949,  -1846,  -1744,  -1642,  -1539,
+     -1437,  -1334,  -1232,  -1130,  -1027,   -925,   -822,   -720,
+      -618,   -515,   -413,   -310,   -208,   -106,     -3,     99,
+       202,    304,    406,    509,    611,    714,    816,    918,
+      1021,   1123,   1226,   1328,   1430,   1533,   1635,   1738,
+      1840,   1942,   2045,   2147,   2250,   2352,   2454,   2557,
+      2659,   2762,   2864,   2966,   3069,   3171,   3274,   3376,
+      3478,   3581,   3683,   3786,   3888,   3990,   4093,   4195,
+      4298,   4400,   4502,   4605,   4707,   4810,   4912,   5014,
+      5117,   5219,   5322,   5424,   5526,   5629,   5731,   5834,
+      5936,   6038,   6141,   6243,   6346,   6448,   6550,   6653,
+      6755,   6858,   6960,   7062,   7165,   7267,   7370,   7472,
+      7574,   7677,   7779,   7882,   7984,   8086,   8189,   8291,
+      8394,   8496,   8598,   8701,   8803,   8906,   9008,   9110,
+      9213,   9315,   9418,   9520,   9622,   9725,   9827,   9930,
+     10032,  10134,  10237,  10339,  10442,  10544,  10646,  10749,
+     10851,  10954,  11056,  11158,  11261,  11363,  11466,  11568,
+     11670,  11773,  11875,  11978,  12080,  12182,  12285,  12387,
+     12490,  12592,  12694,  12797,  12899,  13002,  13104,  13206,
+     13309,  13411,  13514,  13616,  13718,  13821,  13923,  14026,
+     14128,  14230,  14333,  14435,  14538,  14640,  14742,  14845,
+     14947,  15050,  15152,  15254,  15357,  15459,  15562,  15664,
+     15766,  15869,  15971,  16074,  16176,  16278,  16381,  16483,
+     16586,  16688,  16790,  16893,  16995,  17098,  17200,  17302,
+     17405,  17507,  17610,  17712,  17814,  17917,  18019,  18122,
+     18224,  18326,  18429,  18531,  18634,  18736,  18838,  18941,
+     19043,  19146,  19248,  19350,  19453,  19555,  19658,  19760,
+     19862};
+
+/// linear RH*10 (Q4) at hR = i*64
+static const int16_t sht_rtab[65] = {
+      -327,     47,    420,    791,   1159,   1525,   1890,   2252,
+      2612,   2970,   3326,   3680,   4032,   4381,   4729,   5074,
+      5418,   5759,   6098,   6435,   6770,   7103,   7434,   7763,
+      8090,   8414,   8737,   9057,   9375,   9692,  10006,  10318,
+     10628,  10935,  11241,  11545,  11846,  12146,  12443,  12739,
+     13032,  13323,  13612,  13899,  14184,  14466,  14747,  15026,
+     15302,  15577,  15849,  16119,  16387,  16653,  16917,  17179,
+     17439,  17696,  17952,  18205,  18457,  18706,  18953,  19198,
+     19441};
+
+/// RH temp. compensation *10 (Q4) at tR = i*64
+static const int16_t sht_ctab[257] = {
+      -104,    -50,      2,     54,    104,    154,    202,    249,
+       295,    340,    384,    427,    469,    510,    550,    589,
+       627,    663,    699,    734,    767,    800,    831,    862,
+       891,    919,    947,    973,    998,   1022,   1045,   1067,
+      1088,   1108,   1127,   1145,   1162,   1178,   1192,   1206,
+      1219,   1230,   1241,   1250,   1259,   1266,   1272,   1278,
+      1282,   1285,   1287,   1288,   1288,   1287,   1285,   1282,
+      1278,   1273,   1266,   1259,   1251,   1241,   1231,   1219,
+      1207,   1193,   1178,   1163,   1146,   1128,   1109,   1089,
+      1068,   1046,   1023,    999,    974,    948,    921,    892,
+       863,    833,    801,    769,    735,    701,    665,    628,
+       591,    552,    512,    471,    429,    386,    342,    297,
+       251,    204,    156,    107,     56,      5,    -48,   -101,
+      -155,   -211,   -268,   -325,   -384,   -444,   -505,   -566,
+      -629,   -693,   -758,   -824,   -891,   -959,  -1029,  -1099,
+     -1170,  -1242,  -1316,  -1390,  -1466,  -1542,  -1620,  -1698,
+     -1778,  -1859,  -1941,  -2023,  -2107,  -2192,  -2278,  -2365,
+     -2453,  -2542,  -2632,  -2724,  -2816,  -2909,  -3004,  -3099,
+     -3195,  -3293,  -3391,  -3491,  -3592,  -3693,  -3796,  -3900,
+     -4005,  -4111,  -4217,  -4325,  -4434,  -4545,  -4656,  -4768,
+     -4881,  -4995,  -5111,  -5227,  -5344,  -5463,  -5582,  -5703,
+     -5825,  -5947,  -6071,  -6196,  -6322,  -6448,  -6576,  -6705,
+     -6835,  -6966,  -7098,  -7232,  -7366,  -7501,  -7637,  -7775,
+     -7913,  -8052,  -8193,  -8334,  -8477,  -8621,  -8765,  -8911,
+     -9058,  -9206,  -9355,  -9504,  -9655,  -9807,  -9961, -10115,
+    -10270, -10426, -10583, -10742, -10901, -11061, -11223, -11385,
+    -11549, -11713, -11879, -12046, -12214, -12382, -12552, -12723,
+    -12895, -13068, -13242, -13417, -13593, -13770, -13949, -14128,
+    -14308, -14490, -14672, -14856, -15040, -15226, -15412, -15600,
+    -15789, -15978, -16169, -16361, -16554, -16748, -16943, -17139,
+    -17336, -17534, -17734, -17934, -18135, -18337, -18541, -18745,
+    -18951, -19157, -19365, -19574, -19783, -19994, -20206, -20419,
+    -20633};
+
+#endif
@@ -0,0 +1,228 @@
+/*
+ * acq.c test - stage order and values, RH skip, errors, and wall time of sequential
+ * and pipelined acquisition cycles under CPU load (host build, SHT_HOST)
+ */
+
+#include <stdio.h>
+#include <inttypes.h>
+
+#include "../../acq.h"
+#include "../../sht11.h"
+#include "../../sht11hal.h"
+#include "../shtsim/shtsim.h"
+
+/// test counters
+int tests = 0, failed = 0;
+
+#define CHECK(cond) check((cond),#cond,__LINE__)
+
+void check(int ok, const char *what, int line)
+{
+    tests++;
+    if (ok) return;
+    failed++;
+    printf("FAILED (line %d): %s\n",line,what);
+}
+
+/// stage log (T stage 'T', sample stage 'S')
+char log_buf[64];
+int log_len = 0;
+unsigned int last_t, last_h, samples;
+
+/// CPU load of stages (cycles, busy wait in the simulator)
+unsigned long load_t = 0, load_s = 0;
+
+/// RH decision (rh_every 0 .. always, n .. every n-th sample)
+unsigned int rh_every = 0, rh_count = 0;
+
+unsigned char need_rh(unsigned int t, unsigned char res)
+{
+    (void)t; (void)res;
+    return (rh_every==0) || ((rh_count++%rh_every)==0);
+}
+
+void stage_temp(unsigned int t, unsigned char res)
+{
+    (void)res;
+    if (log_len<63) log_buf[log_len++] = 'T';
+    last_t = t;
+    shtsim_delay(load_t);
+}
+
+void stage_sample(unsigned int t, unsigned int h, unsigned char res)
+{
+    (void)res;
+    if (log_len<63) log_buf[log_len++] = 'S';
+    CHECK(t==last_t);
+    last_h = h;
+    samples++;
+    shtsim_delay(load_s);
+}
+
+const acq_cfg_t cfg = {need_rh,stage_temp,stage_sample};
+
+void restart(void)
+{
+    shtsim_reset();
+    sht11_init();
+    acq_init(&cfg);
+    log_len = 0;
+    log_buf[0] = 0;
+    samples = 0;
+    load_t = load_s = 0;
+    rh_every = rh_count = 0;
+}
+
+/// stage order, values, RH skip, errors
+void stages(void)
+{
+    restart();
+    shtsim_set_values(0x1234,0x0567);
+    CHECK(acq_run(1)==1);
+    CHECK((last_t==0x1234)&&(last_h==0x0567));
+    CHECK((log_len==2)&&(log_buf[0]=='T')&&(log_buf[1]=='S'));
+
+    // back to back .. the same order (sample stage runs during next T conversion)
+    log_len = 0;
+    CHECK(acq_run(3)==3);
+    log_buf[log_len] = 0;
+    CHECK((log_len==6)&&(log_buf[0]=='T')&&(log_buf[1]=='S')&&(log_buf[4]=='T')&&(log_buf[5]=='S'));
+
+    // RH skipped .. last RH reused, one conversion less
+    rh_every = 2;
+    shtsim_set_values(0x1000,0x0400);
+    uint32_t ts = shtsim_transstarts();
+    CHECK(acq_run(4)==4);
+    CHECK(shtsim_transstarts()-ts==6); // 4 T, 2 RH
+    CHECK(last_h==0x0400);
+
+    // checksum error and hung sensor .. recovered inside
+    rh_every = 0;
+    shtsim_crc_fault(1);
+    CHECK(acq_run(2)==2);
+    shtsim_hang(1);
+    CHECK(acq_run(1)==1);
+    CHECK(last_t==0x1000);
+
+    // no sensor .. no sample
+    shtsim_connect(0);
+    CHECK(acq_run(3)==0);
+    shtsim_connect(1);
+    CHECK(acq_run(1)==1);
+}
+
+/// sequential cycle (the same stages after both conversions)
+unsigned int run_sequential(unsigned int n)
+{
+    unsigned int t, h = 0, done = 0;
+    unsigned char res = sht_get_resolution();
+    while (n--)
+    {
+        if ((sht_measure_async(TEMP,0)!=0)||(sht_measure_async_wait(&t)!=0)) continue;
+        if ((sht_measure_async(HUMI,0)!=0)||(sht_measure_async_wait(&h)!=0)) continue;
+        stage_temp(t,res);
+        stage_sample(t,h,res);
+        done++;
+    }
+    return done;
+}
+
+/// wall time per cycle (ms), sequential and pipelined
+#define CYCLES 20
+
+void timing(unsigned char res)
+{
+    // stage loads (ms): T stage, sample stage
+    const unsigned int loads[][2] = {{1,5},{20,100},{80,320},{40,600},{200,1000}};
+    unsigned int i;
+    double conv = 0;
+
+    printf("%s resolution, %d back to back cycles, ms per cycle\n",res?"low":"high",CYCLES);
+    printf("%8s %8s %10s %10s %10s %6s\n","T stage","sample","sequential","pipelined","bound","gain");
+    for (i=0;i<sizeof(loads)/sizeof(loads[0]);i++)
+    {
+        uint64_t t0;
+        double seq, pipe, bound;
+
+        restart();
+        sht_set_resolution(res);
+        if (i==0) // conversion with readout, no load
+        {
+            t0 = shtsim_time();
+            acq_run(CYCLES);
+            conv = (shtsim_time()-t0)/1000.0/CYCLES;
+            printf("conversion and readout %.1f ms\n",conv);
+        }
+        load_t = loads[i][0]*1000UL;
+        load_s = loads[i][1]*1000UL;
+
+        t0 = shtsim_time();
+        CHECK(run_sequential(CYCLES)==CYCLES);
+        seq = (shtsim_time()-t0)/1000.0/CYCLES;
+
+        t0 = shtsim_time();
+        CHECK(acq_run(CYCLES)==CYCLES);
+        pipe = (shtsim_time()-t0)/1000.0/CYCLES;
+
+        // max(T conversion, sample stage) + max(RH conversion, T stage) + readouts
+        double tconv = (res?SHTSIM_CONV12:SHTSIM_CONV14)/1000.0;
+        double hconv = (res?SHTSIM_CONV8:SHTSIM_CONV12)/1000.0;
+        double readout = conv-tconv-hconv;
+        bound = (tconv>loads[i][1]?tconv:loads[i][1]) + (hconv>loads[i][0]?hconv:loads[i][0]) + readout;
+        printf("%8u %8u %10.1f %10.1f %10.1f %5.2fx\n",loads[i][0],loads[i][1],seq,pipe,bound,seq/pipe);
+
+        CHECK(seq>=conv+loads[i][0]+loads[i][1]-1); // sum of all
+        CHECK(pipe<=bound*1.01+(double)(loads[i][0]+loads[i][1])/CYCLES); // last sample stage not overlapped
+        CHECK(pipe<seq);
+    }
+}
+
+/// measure task as the firmware runs it (one sample per task, main.c TASK_MEASURE_SAMPLES):
+/// only T stage work overlaps (RH conversion), so T-only work (T conversion, its debug value)
+/// moved from sample stage to T stage is hidden, the sample stage needs RH and runs after it
+void task_timing(void)
+{
+    // T-only work, the rest of sample stage (ms)
+    const unsigned int loads[][2] = {{1,5},{2,10},{5,20},{20,40},{100,40}};
+    const double hconv = SHTSIM_CONV12/1000.0;
+    unsigned int i;
+
+    printf("measure task, 1 sample, high resolution, ms per task\n");
+    printf("%8s %8s %12s %12s %8s %6s\n","T work","rest","in sample","in T stage","saved","gain");
+    for (i=0;i<sizeof(loads)/sizeof(loads[0]);i++)
+    {
+        uint64_t t0;
+        double all, split;
+
+        restart();
+        sht_set_resolution(SHT_RES_HIGH);
+        load_t = 0; // T work in sample stage
+        load_s = (loads[i][0]+loads[i][1])*1000UL;
+        t0 = shtsim_time();
+        CHECK(acq_run(1)==1);
+        all = (shtsim_time()-t0)/1000.0;
+
+        restart();
+        sht_set_resolution(SHT_RES_HIGH);
+        load_t = loads[i][0]*1000UL; // T work in T stage
+        load_s = loads[i][1]*1000UL;
+        t0 = shtsim_time();
+        CHECK(acq_run(1)==1);
+        split = (shtsim_time()-t0)/1000.0;
+
+        printf("%8u %8u %12.1f %12.1f %8.1f %5.2fx\n",loads[i][0],loads[i][1],all,split,all-split,all/split);
+        // saved min(T work, RH conversion)
+        double hidden = (loads[i][0]<hconv) ? loads[i][0] : hconv;
+        CHECK((all-split>hidden-0.5)&&(all-split<hidden+0.5));
+    }
+}
+
+int main(void)
+{
+    stages();
+    timing(SHT_RES_HIGH);
+    timing(SHT_RES_LOW);
+    task_timing();
+    printf("%d tests, %d failed\n",tests,failed);
+    return (failed!=0);
+}
@@ -0,0 +1,247 @@
+/*
+ * adapt.c test - interval rules, and benchmark of fixed and adaptive sampling on
+ * day long traces (samples, average current, reconstruction error) (host build, SHT_HOST)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <inttypes.h>
+
+#include "../../adapt.h"
+#include "../../sht11.h"
+#include "../../sht11con.h"
+#include "../shtsim/shtsim.h"
+
+/// test counters
+int tests = 0, failed = 0;
+
+#define CHECK(cond) check((cond),#cond,__LINE__)
+
+void check(int ok, const char *what, int line)
+{
+    tests++;
+    if (ok) return;
+    failed++;
+    printf("FAILED (line %d): %s\n",line,what);
+}
+
+/// default configuration, interval in seconds
+const adapt_cfg_t cfg_default = {ADAPT_T_QUIET,ADAPT_T_CHANGE,ADAPT_H_QUIET,ADAPT_H_CHANGE,
+                                 ADAPT_GROW,ADAPT_RH_SKIP,5,80};
+
+/// one sample (RH measured if needed), returns interval
+unsigned long sample(unsigned int t, unsigned int h, unsigned char res)
+{
+    adapt_need_rh(t,res);
+    return adapt_update(t,h,res);
+}
+
+/// interval rules
+void rules(void)
+{
+    int i;
+    unsigned long iv;
+
+    adapt_init(&cfg_default);
+    CHECK(adapt_need_rh(6000,0)==1); // no reference
+    CHECK(adapt_update(6000,1500,0)==5);
+
+    // quiet .. doubles after 3 samples, up to slow
+    for (i=0;i<3;i++) iv = sample(6000+(i&1),1500,0);
+    CHECK(iv==10);
+    for (i=0;i<20;i++) iv = sample(6000+(i&1),1500-(i&1),0);
+    CHECK(iv==80);
+
+    // hysteresis band (between quiet and change) keeps interval
+    for (i=0;i<10;i++) iv = sample(6000+(i&1)*6,1500,0);
+    CHECK(iv==80);
+
+    // T change .. fast
+    CHECK(sample(6020,1500,0)==5);
+    // RH change .. fast (T steady, RH measured because T moved on the way)
+    for (i=0;i<6;i++) sample(6020,1500,0);
+    CHECK(adapt_need_rh(6025,0)==1);
+    CHECK(adapt_update(6025,1530,0)==5);
+
+    // RH skipped while T is quiet, at most ADAPT_RH_SKIP times in a row
+    int skipped = 0;
+    for (i=0;i<2*(ADAPT_RH_SKIP+1);i++)
+    {
+        if (adapt_need_rh(6025,0)==0) skipped++;
+        adapt_update(6025,9999,0); // value ignored when skipped
+    }
+    CHECK(skipped==2*ADAPT_RH_SKIP);
+
+    // low resolution deltas scaled (1 LSB 12bit T = 4 LSB 14bit)
+    adapt_init(&cfg_default);
+    sample(1500,100,1);
+    for (i=0;i<3;i++) iv = sample(1500,100,1);
+    CHECK(iv==10);
+    CHECK(sample(1501,100,1)==10); // 4 .. band
+    CHECK(sample(1504,100,1)==5); // 12 .. change
+}
+
+/** benchmark */
+
+#define DAY 86400
+/// true values per second (T C, RH %)
+double tr_t[DAY], tr_h[DAY];
+
+/// humidity register for RH % (inverse of 12bit formula, no T compensation)
+double rh2reg(double rh)
+{
+    return (-C2+sqrt(C2*C2-4*C3*(C1-rh)))/(2*C3);
+}
+
+double reg2rh(double h) { return C1+C2*h+C3*h*h; }
+double reg2t(double t) { return D1+D2*t; }
+
+/// event (step with exponential approach, held for len s, then exponential decay)
+double event(int s, int start, int len, double amp, double tau_up, double tau_down)
+{
+    if (s<start) return 0;
+    if (s<start+len) return amp*(1-exp(-(s-start)/tau_up));
+    double top = amp*(1-exp(-len/tau_up));
+    return top*exp(-(s-start-len)/tau_down);
+}
+
+/// traces (office with window airing, bathroom with showers, storage room)
+const char *trace_name[] = {"office","bathroom","storage"};
+
+void trace(int n)
+{
+    int s;
+    for (s=0;s<DAY;s++)
+    {
+        double d = sin(2*M_PI*(s-8*3600)/DAY);
+        switch (n)
+        {
+            case 0:
+                tr_t[s] = 22+1.5*d;
+                tr_h[s] = 45-5*d;
+                tr_t[s] -= event(s,8*3600,600,4,120,1200)+event(s,12*3600+1800,900,4,120,1200)
+                          +event(s,17*3600,600,4,120,1200);
+                tr_h[s] += event(s,8*3600,600,8,120,1200)+event(s,12*3600+1800,900,8,120,1200)
+                          +event(s,17*3600,600,8,120,1200);
+                break;
+            case 1:
+                tr_t[s] = 21+0.5*d+event(s,7*3600,900,2,300,1800)+event(s,20*3600,900,2,300,1800);
+                tr_h[s] = 50+event(s,7*3600,900,40,180,1200)+event(s,20*3600,900,40,180,1200);
+                break;
+            default:
+                tr_t[s] = 15+0.2*d;
+                tr_h[s] = 60+1.0*d;
+                break;
+        }
+    }
+}
+
+/// energy model (MSP430G2553 and SHT11 datasheet typical values, see test/schedtest)
+#define I_ACTIVE 230.0
+#define I_LPM3 0.5
+#define I_SHT_MEAS 550.0
+#define I_SHT_SLEEP 0.3
+#define PROC_S 300e-6 // conversion, history, stream per sample
+
+/// measurement cost (charge above sleep currents, uC) of T and RH (simulated driver)
+double cost_t, cost_h;
+
+double measure_cost(unsigned char mode)
+{
+    unsigned int v;
+    uint64_t t, a;
+    shtsim_reset();
+    sht11_init();
+    t = shtsim_time(); a = shtsim_active();
+    sht_measure_async(mode,0);
+    while (!sht_measure_async_done()) if (!shtsim_sleep()) break;
+    sht_measure_async_result(&v);
+    return (I_ACTIVE-I_LPM3)*(shtsim_active()-a)*1e-6+(I_SHT_MEAS-I_SHT_SLEEP)*(shtsim_time()-t)*1e-6;
+}
+
+/// result of one run
+typedef struct {
+    long nt, nh;
+    double ua;
+    double t_rms, t_max, h_rms, h_max;
+} result_t;
+
+/// run strategy on current trace (cfg 0 .. fixed period)
+void run(const adapt_cfg_t *cfg, unsigned long fixed, result_t *r)
+{
+    int s = 0, next = 0;
+    double rt = 0, rh = 0, q = 0, et2 = 0, eh2 = 0;
+    unsigned int hreg = 0;
+
+    srand(1);
+    r->nt = r->nh = 0;
+    r->t_max = r->h_max = 0;
+    if (cfg) adapt_init(cfg);
+    for (s=0;s<DAY;s++)
+    {
+        if (s==next)
+        {
+            unsigned int treg = (unsigned int)lround((tr_t[s]-D1)/D2)+(rand()%3)-1;
+            r->nt++;
+            q += cost_t+(I_ACTIVE-I_LPM3)*PROC_S;
+            if ((cfg==0)||adapt_need_rh(treg,0))
+            {
+                hreg = (unsigned int)lround(rh2reg(tr_h[s]))+(rand()%5)-2;
+                r->nh++;
+                q += cost_h;
+            }
+            rt = reg2t(treg);
+            rh = reg2rh(hreg);
+            next += cfg ? adapt_update(treg,hreg,0) : fixed;
+        }
+        double et = fabs(rt-tr_t[s]), eh = fabs(rh-tr_h[s]);
+        et2 += et*et; eh2 += eh*eh;
+        if (et>r->t_max) r->t_max = et;
+        if (eh>r->h_max) r->h_max = eh;
+    }
+    r->ua = I_LPM3+I_SHT_SLEEP+q/DAY;
+    r->t_rms = sqrt(et2/DAY);
+    r->h_rms = sqrt(eh2/DAY);
+}
+
+/// result table row
+#define ROW(name) printf("%-9s %-16s %6ld %6ld %7.2f %6.3f/%5.2f %6.3f/%5.2f\n",trace_name[n],name, \
+                         r.nt,r.nh,r.ua,r.t_rms,r.t_max,r.h_rms,r.h_max)
+
+void benchmark(void)
+{
+    const adapt_cfg_t cfg_noskip = {ADAPT_T_QUIET,ADAPT_T_CHANGE,ADAPT_H_QUIET,ADAPT_H_CHANGE,
+                                    ADAPT_GROW,0,5,80};
+    const adapt_cfg_t cfg_coarse = {10,25,25,60,ADAPT_GROW,ADAPT_RH_SKIP,5,320};
+    result_t r, base, slow;
+    int n;
+
+    cost_t = measure_cost(TEMP);
+    cost_h = measure_cost(HUMI);
+    printf("measurement charge: T %.1f uC, RH %.1f uC\n",cost_t,cost_h);
+    printf("%-9s %-16s %6s %6s %7s %13s %13s\n","trace","strategy","T","RH","uA","T rms/max C","RH rms/max %");
+    for (n=0;n<3;n++)
+    {
+        trace(n);
+        run(0,5,&base);
+        r = base; ROW("fixed 5s");
+        run(0,80,&slow); r = slow; ROW("fixed 80s");
+        run(&cfg_default,0,&r); ROW("adaptive 5..80s");
+        // energy near fixed 80s, error not worse than it (onset of a change is seen one interval late)
+        CHECK(r.ua<base.ua/10);
+        CHECK(r.ua<slow.ua*1.25);
+        CHECK(r.t_rms<slow.t_rms+0.005);
+        CHECK(r.h_rms<slow.h_rms+0.005);
+        run(&cfg_noskip,0,&r); ROW("adaptive no skip");
+        run(&cfg_coarse,0,&r); ROW("adaptive coarse");
+    }
+}
+
+int main(void)
+{
+    rules();
+    benchmark();
+    printf("%d tests, %d failed\n",tests,failed);
+    return (failed!=0);
+}
@@ -0,0 +1,397 @@
+/*
+ * aggd.cpp
+ *
+ *  Created on: 17.10.2026
+ *      Author: agent
+ *
+ *  Description: multi-node aggregator (see aggd.h)
+ *
+ *  Functions:
+ *  	aggregator_t .. reader (epoll), converter, consumers
+ *  	spsc_t, notify_t .. queues and consumer wake up
+ *  	agg_crc8(), agg_frame() .. protocol frames (the same as proto.c)
+ *  	open_serial() .. serial port setup
+ *
+ */
+
+#include <cstring>
+#include <cerrno>
+#include <ctime>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+
+extern "C" {
+#include "../../sht11con.h"
+}
+
+#include "aggd.h"
+
+/** helpers */
+
+int64_t agg_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC,&ts);
+    return (int64_t)ts.tv_sec*1000000000+ts.tv_nsec;
+}
+
+/// CPU time of calling thread (ns)
+static int64_t thread_cpu_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID,&ts);
+    return (int64_t)ts.tv_sec*1000000000+ts.tv_nsec;
+}
+
+uint8_t agg_crc8(const uint8_t *data, size_t len)
+{
+    uint8_t c = 0, r = 0;
+    while (len--)
+    {
+        c ^= *data++;
+        for (int i=0;i<8;i++) c = (c&0x80)?((c<<1)^0x31):(c<<1);
+    }
+    for (int i=0;i<8;i++) { r = (r<<1)|(c&1); c >>= 1; }
+    return r;
+}
+
+size_t agg_frame(uint8_t *buf, uint8_t type, uint8_t seq, const uint8_t *payload, uint8_t len)
+{
+    buf[0] = AGG_SYNC;
+    buf[1] = type;
+    buf[2] = seq;
+    buf[3] = len;
+    if (len) memcpy(buf+4,payload,len);
+    buf[4+len] = agg_crc8(buf+1,3+len);
+    return 5+len;
+}
+
+/** consumer wake up */
+
+notify_t::notify_t()
+{
+    fd = eventfd(0,EFD_NONBLOCK|EFD_CLOEXEC);
+}
+
+notify_t::~notify_t()
+{
+    if (fd>=0) close(fd);
+}
+
+void notify_t::signal(void)
+{
+    std::atomic_thread_fence(std::memory_order_seq_cst); // queue position before flag
+    if (!waiting.exchange(false)) return;
+    uint64_t one = 1;
+    if (write(fd,&one,sizeof(one))<0) {}
+}
+
+void notify_t::wait(int timeout_ms)
+{
+    struct pollfd p = {fd,POLLIN,0};
+    uint64_t v;
+    if (poll(&p,1,timeout_ms)>0)
+        if (read(fd,&v,sizeof(v))<0) {}
+    waiting.store(false);
+}
+
+/** aggregator */
+
+struct aggregator_t::node_t {
+    int fd;
+    int num;
+    std::string name;
+    uint8_t buf[4*(AGG_PAYLOAD_MAX+5)];
+    size_t len = 0;
+    int last_seq = -1;
+    uint8_t cmd_seq = 0;
+    int64_t last_rx_ns = 0;
+    bool open = true;
+    std::atomic<uint64_t> frames{0}, samples{0}, lost{0}, crc_errors{0}, bytes{0}, resubscribes{0};
+};
+
+struct aggregator_t::consumer_t {
+    agg_consumer_fn fn;
+    spsc_t<agg_result_t,AGG_QUEUE> queue;
+    notify_t notify;
+    std::thread thread;
+    std::atomic<uint64_t> drops{0};
+    std::atomic<int64_t> cpu{0};
+};
+
+aggregator_t::aggregator_t()
+{
+    epfd = epoll_create1(EPOLL_CLOEXEC);
+    stopfd = eventfd(0,EFD_NONBLOCK|EFD_CLOEXEC);
+}
+
+aggregator_t::~aggregator_t()
+{
+    stop();
+    for (auto &n : node_list) if (n->fd>=0) close(n->fd);
+    if (epfd>=0) close(epfd);
+    if (stopfd>=0) close(stopfd);
+}
+
+int aggregator_t::add_node(int fd, const std::string &name)
+{
+    std::unique_ptr<node_t> n(new node_t);
+    n->fd = fd;
+    n->num = node_list.size();
+    n->name = name;
+    node_list.push_back(std::move(n));
+    return node_list.size()-1;
+}
+
+void aggregator_t::add_consumer(agg_consumer_fn fn)
+{
+    std::unique_ptr<consumer_t> c(new consumer_t);
+    c->fn = fn;
+    consumer_list.push_back(std::move(c));
+}
+
+bool aggregator_t::start(void)
+{
+    if (running || (epfd<0) || (stopfd<0)) return false;
+    struct epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.ptr = nullptr; // stop
+    if (epoll_ctl(epfd,EPOLL_CTL_ADD,stopfd,&ev)!=0) return false;
+    for (auto &n : node_list)
+    {
+        ev.events = EPOLLIN;
+        ev.data.ptr = n.get();
+        if (epoll_ctl(epfd,EPOLL_CTL_ADD,n->fd,&ev)!=0) return false;
+    }
+    running = true;
+    for (auto &c : consumer_list) c->thread = std::thread(&aggregator_t::consumer_run,this,c.get());
+    converter = std::thread(&aggregator_t::converter_run,this);
+    reader = std::thread(&aggregator_t::reader_run,this);
+    return true;
+}
+
+void aggregator_t::stop(void)
+{
+    if (!running.exchange(false)) return;
+    uint64_t one = 1;
+    if (write(stopfd,&one,sizeof(one))<0) {}
+    reader.join();
+    converter.join();
+    for (auto &c : consumer_list) c->thread.join();
+}
+
+const std::string &aggregator_t::node_name(int n) const
+{
+    return node_list[n]->name;
+}
+
+agg_node_stats_t aggregator_t::node_stats(int n) const
+{
+    const node_t *p = node_list[n].get();
+    agg_node_stats_t s = {p->frames,p->samples,p->lost,p->crc_errors,p->bytes,p->resubscribes};
+    return s;
+}
+
+agg_stage_stats_t aggregator_t::stage_stats(void) const
+{
+    agg_stage_stats_t s;
+    s.reader_cpu_ns = reader_cpu;
+    s.converter_cpu_ns = converter_cpu;
+    s.converted = converted;
+    s.queue_full = queue_full;
+    for (auto &c : consumer_list)
+    {
+        s.consumer_cpu_ns.push_back(c->cpu);
+        s.consumer_drops.push_back(c->drops);
+    }
+    return s;
+}
+
+/// stream subscription and poll (the same as test/dfetch.pyw)
+void aggregator_t::subscribe(node_t *n)
+{
+    uint8_t cmd[16];
+    size_t len = agg_frame(cmd,AGG_CMD_STREAM,n->cmd_seq,&stream_samples,1);
+    len += agg_frame(cmd+len,AGG_CMD_POLL,n->cmd_seq+1,nullptr,0);
+    n->cmd_seq += 2;
+    if (write(n->fd,cmd,len)<0) {} // short command, port buffer is empty or node is gone
+    n->last_rx_ns = agg_now_ns();
+}
+
+/// complete frame
+void aggregator_t::node_frame(node_t *n, uint8_t type, uint8_t seq, const uint8_t *p, uint8_t len)
+{
+    n->frames.fetch_add(1,std::memory_order_relaxed);
+    if (n->last_seq>=0) n->lost.fetch_add((uint8_t)(seq-n->last_seq-1),std::memory_order_relaxed);
+    n->last_seq = seq;
+    if ((type!=AGG_DATA)||(len<2)) return;
+    uint8_t cnt = p[0], ch = p[1];
+    if ((ch<2)||(2+cnt*ch*2>len)) return;
+    agg_sample_t s;
+    s.node = n->num;
+    s.seq = seq;
+    s.rx_ns = n->last_rx_ns;
+    for (uint8_t i=0;i<cnt;i++)
+    {
+        const uint8_t *v = p+2+i*ch*2;
+        s.t = (int16_t)(v[0]|(v[1]<<8));
+        s.h = (int16_t)(v[2]|(v[3]<<8));
+        if (conv_queue.push(s)) n->samples.fetch_add(1,std::memory_order_relaxed);
+        else queue_full.fetch_add(1,std::memory_order_relaxed);
+    }
+}
+
+/// read everything available, parse frames (bad frame .. resync on next sync byte)
+void aggregator_t::node_read(node_t *n)
+{
+    for (;;)
+    {
+        ssize_t r = read(n->fd,n->buf+n->len,sizeof(n->buf)-n->len);
+        if (r<=0)
+        {
+            if ((r==0)||((errno!=EAGAIN)&&(errno!=EINTR))) // port gone
+            {
+                epoll_ctl(epfd,EPOLL_CTL_DEL,n->fd,nullptr);
+                n->open = false;
+            }
+            break;
+        }
+        n->bytes.fetch_add(r,std::memory_order_relaxed);
+        n->len += r;
+        n->last_rx_ns = agg_now_ns();
+
+        size_t pos = 0;
+        while (pos<n->len)
+        {
+            const uint8_t *f = (const uint8_t*)memchr(n->buf+pos,AGG_SYNC,n->len-pos);
+            if (!f) { pos = n->len; break; }
+            pos = f-n->buf;
+            if (n->len-pos<5) break;
+            uint8_t plen = f[3];
+            if (n->len-pos<(size_t)plen+5) break;
+            if (agg_crc8(f+1,3+plen)!=f[4+plen])
+            {
+                n->crc_errors.fetch_add(1,std::memory_order_relaxed);
+                pos++; // resync
+                continue;
+            }
+            node_frame(n,f[1],f[2],f+4,plen);
+            pos += plen+5;
+        }
+        memmove(n->buf,n->buf+pos,n->len-pos);
+        n->len -= pos;
+        if (r<(ssize_t)(sizeof(n->buf)-n->len)) break; // drained (saves one EAGAIN read)
+    }
+}
+
+void aggregator_t::reader_run(void)
+{
+    struct epoll_event ev[64];
+    int64_t next_check = agg_now_ns()+1000000000LL;
+    bool stop = false;
+
+    for (auto &n : node_list) subscribe(n.get());
+    while (!stop)
+    {
+        int k = epoll_wait(epfd,ev,64,1000);
+        for (int i=0;i<k;i++)
+        {
+            if (ev[i].data.ptr==nullptr) { stop = true; continue; }
+            node_read((node_t*)ev[i].data.ptr);
+        }
+        if (k>0) conv_notify.signal(); // one wake up per batch
+        int64_t now = agg_now_ns();
+        if (now>=next_check) // silent nodes
+        {
+            for (auto &n : node_list)
+                if (n->open && (now-n->last_rx_ns>AGG_STREAM_TIMEOUT_MS*1000000LL))
+                {
+                    n->resubscribes.fetch_add(1,std::memory_order_relaxed);
+                    subscribe(n.get());
+                }
+            next_check = now+1000000000LL;
+        }
+    }
+    reader_cpu = thread_cpu_ns();
+    reader_done = true;
+    conv_notify.signal();
+}
+
+void aggregator_t::converter_run(void)
+{
+    agg_sample_t s;
+    bool pending = false;
+    auto convert = [&](const agg_sample_t &s)
+    {
+        agg_result_t r;
+        r.node = s.node;
+        r.seq = s.seq;
+        r.t = s.t;
+        r.h = s.h;
+        r.dew = sht_dewpoint(s.t,s.h);
+        r.abshum = sht_abshum(s.t,s.h);
+        r.rx_ns = s.rx_ns;
+        for (auto &c : consumer_list)
+            if (!c->queue.push(r)) c->drops.fetch_add(1,std::memory_order_relaxed);
+        converted.fetch_add(1,std::memory_order_relaxed);
+        pending = true;
+    };
+
+    for (;;)
+    {
+        if (conv_queue.pop(s)) { convert(s); continue; }
+        if (pending) // one wake up per batch
+        {
+            for (auto &c : consumer_list) c->notify.signal();
+            pending = false;
+        }
+        bool done = reader_done;
+        conv_notify.prepare();
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (conv_queue.pop(s)) { conv_notify.cancel(); convert(s); continue; } // recheck after flag
+        if (done) { conv_notify.cancel(); break; }
+        conv_notify.wait(100);
+    }
+    converter_cpu = thread_cpu_ns();
+    converter_done = true;
+    for (auto &c : consumer_list) c->notify.signal();
+}
+
+void aggregator_t::consumer_run(consumer_t *c)
+{
+    agg_result_t r;
+    for (;;)
+    {
+        if (c->queue.pop(r)) { c->fn(r); continue; }
+        bool done = converter_done;
+        c->notify.prepare();
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (c->queue.pop(r)) { c->notify.cancel(); c->fn(r); continue; }
+        if (done) { c->notify.cancel(); break; }
+        c->notify.wait(100);
+    }
+    c->cpu = thread_cpu_ns();
+}
+
+/** serial port */
+
+int open_serial(const char *path, unsigned long baud)
+{
+    static const struct { unsigned long baud; speed_t speed; } speeds[] = {
+        {9600,B9600},{19200,B19200},{38400,B38400},{57600,B57600},{115200,B115200}};
+    int fd = open(path,O_RDWR|O_NOCTTY|O_NONBLOCK|O_CLOEXEC);
+    if (fd<0) return -1;
+    struct termios tio;
+    if (tcgetattr(fd,&tio)==0)
+    {
+        cfmakeraw(&tio);
+        tio.c_cflag |= CLOCAL|CREAD;
+        for (auto &s : speeds) if (s.baud==baud) cfsetspeed(&tio,s.speed);
+        tcsetattr(fd,TCSANOW,&tio);
+    }
+    return fd;
+}
@@ -0,0 +1,190 @@
+/*
+ * aggd.h
+ *
+ *  Created on: 17.10.2026
+ *      Author: agent
+ *
+ *  Description: multi-node aggregator of msp430 sht11 nodes (binary protocol, proto.h)
+ *
+ *  Threads and queues:
+ *  	reader .. epoll over all node ports, non-blocking reads, incremental frame parsers,
+ *  		stream subscription (and resubscription after silence), samples to converter queue
+ *  	converter .. dew point and absolute humidity (sht11con math), results to every consumer
+ *  	consumers .. one thread and one queue per consumer function
+ *
+ *  Queues are single producer single consumer rings (lock-free). An idle consumer
+ *  sleeps on eventfd, the producer signals it only when it sleeps. Full consumer queue
+ *  drops results of that consumer only.
+ *
+ *  Functions:
+ *  	add_node(fd,name) .. node port (serial port or pty, opened by caller)
+ *  	add_consumer(fn) .. result consumer (called from its own thread)
+ *  	start(), stop() .. run/stop threads
+ *  	node_stats(n), stage_stats() .. counters, thread CPU time
+ *  	open_serial(path,baud) .. serial port in raw non-blocking mode
+ */
+
+#ifndef __AGGD_H__
+#define __AGGD_H__
+
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <string>
+#include <functional>
+#include <memory>
+
+/// protocol (see proto.h)
+#define AGG_SYNC 0xA5
+#define AGG_CMD_POLL 0x01
+#define AGG_CMD_STREAM 0x02
+#define AGG_DATA 0x81
+#define AGG_ACK 0x82
+/// max. frame payload (len byte)
+#define AGG_PAYLOAD_MAX 255
+
+/// resubscribe after silence (device streams a sample every 5s)
+#define AGG_STREAM_TIMEOUT_MS 12000
+
+/// monotonic time (ns)
+int64_t agg_now_ns(void);
+
+/// sensor crc-8 of protocol frames (start 0, result bit reversed)
+uint8_t agg_crc8(const uint8_t *data, size_t len);
+
+/// build frame to buf (returns length)
+size_t agg_frame(uint8_t *buf, uint8_t type, uint8_t seq, const uint8_t *payload, uint8_t len);
+
+/// single producer single consumer ring (N power of 2), index caches avoid
+/// touching the other side's cache line on every call
+template<class T, size_t N> class spsc_t {
+    static_assert((N&(N-1))==0,"N must be power of 2");
+    alignas(64) std::atomic<size_t> head{0};    // consumer position
+    size_t tail_cache = 0;
+    alignas(64) std::atomic<size_t> tail{0};    // producer position
+    size_t head_cache = 0;
+    alignas(64) T buf[N];
+public:
+    bool push(const T &v)
+    {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (t-head_cache==N)
+        {
+            head_cache = head.load(std::memory_order_acquire);
+            if (t-head_cache==N) return false;
+        }
+        buf[t&(N-1)] = v;
+        tail.store(t+1,std::memory_order_release);
+        return true;
+    }
+    bool pop(T &v)
+    {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h==tail_cache)
+        {
+            tail_cache = tail.load(std::memory_order_acquire);
+            if (h==tail_cache) return false;
+        }
+        v = buf[h&(N-1)];
+        head.store(h+1,std::memory_order_release);
+        return true;
+    }
+};
+
+/// consumer wake up (eventfd), signalled by producer only when consumer waits
+class notify_t {
+    int fd;
+    std::atomic<bool> waiting{false};
+public:
+    notify_t();
+    ~notify_t();
+    /// producer: after push
+    void signal(void);
+    /// consumer: wait for signal (call prepare, recheck queue, then wait or cancel)
+    void prepare(void) { waiting.store(true); }
+    void cancel(void) { waiting.store(false); }
+    void wait(int timeout_ms);
+};
+
+/// sample from node (T, RH * 10 as sent by node)
+struct agg_sample_t {
+    uint16_t node;
+    uint8_t seq;
+    int16_t t, h;
+    int64_t rx_ns;      // frame complete in reader
+};
+
+/// converted sample
+struct agg_result_t {
+    uint16_t node;
+    uint8_t seq;
+    int16_t t, h;       // C, % * 10
+    int16_t dew;        // dew point C * 10
+    int16_t abshum;     // absolute humidity g/m3 * 10
+    int64_t rx_ns;
+};
+
+/// per node counters
+struct agg_node_stats_t {
+    uint64_t frames, samples, lost, crc_errors, bytes, resubscribes;
+};
+
+/// thread CPU time (ns) and items processed
+struct agg_stage_stats_t {
+    int64_t reader_cpu_ns, converter_cpu_ns;
+    std::vector<int64_t> consumer_cpu_ns;
+    uint64_t converted, queue_full;     // converter queue full (reader dropped)
+    std::vector<uint64_t> consumer_drops;
+};
+
+typedef std::function<void(const agg_result_t &)> agg_consumer_fn;
+
+/// queue sizes
+#define AGG_QUEUE 4096
+
+class aggregator_t {
+public:
+    aggregator_t();
+    ~aggregator_t();
+    /// add node port before start (fd is closed by aggregator), returns node number
+    int add_node(int fd, const std::string &name);
+    /// add consumer before start
+    void add_consumer(agg_consumer_fn fn);
+    /// stream samples per frame asked from nodes (1 .. 4)
+    void set_stream_samples(uint8_t n) { stream_samples = n; }
+    bool start(void);
+    /// stop threads (everything received so far is delivered to consumers)
+    void stop(void);
+    size_t nodes(void) const { return node_list.size(); }
+    const std::string &node_name(int n) const;
+    agg_node_stats_t node_stats(int n) const;
+    agg_stage_stats_t stage_stats(void) const;
+
+private:
+    struct node_t;
+    struct consumer_t;
+    std::vector<std::unique_ptr<node_t>> node_list;
+    std::vector<std::unique_ptr<consumer_t>> consumer_list;
+    spsc_t<agg_sample_t,AGG_QUEUE> conv_queue;
+    notify_t conv_notify;
+    std::thread reader, converter;
+    std::atomic<bool> running{false}, reader_done{false}, converter_done{false};
+    int epfd = -1, stopfd = -1;
+    uint8_t stream_samples = 1;
+    std::atomic<int64_t> reader_cpu{0}, converter_cpu{0};
+    std::atomic<uint64_t> converted{0}, queue_full{0};
+
+    void reader_run(void);
+    void converter_run(void);
+    void consumer_run(consumer_t *c);
+    void subscribe(node_t *n);
+    void node_read(node_t *n);
+    void node_frame(node_t *n, uint8_t type, uint8_t seq, const uint8_t *p, uint8_t len);
+};
+
+/// open serial port raw, non-blocking (-1 on error)
+int open_serial(const char *path, unsigned long baud);
+
+#endif
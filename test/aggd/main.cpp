@@ -0,0 +1,86 @@
+/*
+ * aggd - multi-node aggregator daemon, samples of all nodes (binary protocol) as csv
+ * lines to stdout, node counters and thread CPU time to stderr on exit
+ *
+ * usage:
+ *   aggd [-b baud] [-n samples per frame] port ...
+ *   (ctrl-c to stop)
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <csignal>
+#include <cinttypes>
+#include <pthread.h>
+
+#include "aggd.h"
+
+/// value * 10 as text with one decimal
+static const char *fix1(char *buf, int v)
+{
+    sprintf(buf,"%s%d.%d",(v<0)?"-":"",abs(v)/10,abs(v)%10);
+    return buf;
+}
+
+static void usage(void)
+{
+    fprintf(stderr,"usage: aggd [-b baud] [-n samples per frame] port ...\n");
+    exit(2);
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned long baud = 9600;
+    int samples = 1, i;
+    aggregator_t agg;
+
+    for (i=1;(i<argc)&&(argv[i][0]=='-');i++)
+    {
+        if (i+1>=argc) usage();
+        if (!strcmp(argv[i],"-b")) baud = strtoul(argv[++i],nullptr,10);
+        else if (!strcmp(argv[i],"-n")) samples = atoi(argv[++i]);
+        else usage();
+    }
+    if ((i>=argc)||(samples<1)||(samples>4)) usage();
+    for (;i<argc;i++)
+    {
+        int fd = open_serial(argv[i],baud);
+        if (fd<0) { perror(argv[i]); return 1; }
+        agg.add_node(fd,argv[i]);
+    }
+    agg.set_stream_samples(samples);
+
+    int64_t t0 = agg_now_ns();
+    agg.add_consumer([&](const agg_result_t &r)
+    {
+        char t[8], h[8], d[8], a[8];
+        printf("%.3f,%s,%s,%s,%s,%s\n",(r.rx_ns-t0)/1e9,agg.node_name(r.node).c_str(),
+               fix1(t,r.t),fix1(h,r.h),fix1(d,r.dew),fix1(a,r.abshum));
+        fflush(stdout);
+    });
+
+    // signals blocked in all threads (inherited), main waits for them
+    sigset_t sigs;
+    int sig;
+    sigemptyset(&sigs);
+    sigaddset(&sigs,SIGINT);
+    sigaddset(&sigs,SIGTERM);
+    pthread_sigmask(SIG_BLOCK,&sigs,nullptr);
+    printf("time,node,T,RH,dew,abs\n");
+    if (!agg.start()) { fprintf(stderr,"start failed\n"); return 1; }
+    sigwait(&sigs,&sig);
+    agg.stop();
+
+    fprintf(stderr,"%-24s %8s %8s %6s %6s %10s %6s\n","node","frames","samples","lost","crc","bytes","resub");
+    for (size_t n=0;n<agg.nodes();n++)
+    {
+        agg_node_stats_t s = agg.node_stats(n);
+        fprintf(stderr,"%-24s %8" PRIu64 " %8" PRIu64 " %6" PRIu64 " %6" PRIu64 " %10" PRIu64 " %6" PRIu64 "\n",
+                agg.node_name(n).c_str(),s.frames,s.samples,s.lost,s.crc_errors,s.bytes,s.resubscribes);
+    }
+    agg_stage_stats_t st = agg.stage_stats();
+    fprintf(stderr,"CPU ms: reader %.1f, converter %.1f, consumer %.1f\n",
+            st.reader_cpu_ns/1e6,st.converter_cpu_ns/1e6,st.consumer_cpu_ns[0]/1e6);
+    return 0;
+}
@@ -0,0 +1,271 @@
+/*
+ * aggd load test - 100+ simulated nodes on pseudo terminals (binary protocol, streaming),
+ * aggregator with two consumers; per-node latency (node write to consumer), lost
+ * samples, value check, CPU cost of reader, converter and consumer threads
+ *
+ * usage:
+ *   aggload [nodes (128)] [samples/s per node (50)] [seconds (5)] [samples per frame (1)]
+ *   exit code 1 on lost, dropped or wrong samples
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cinttypes>
+#include <vector>
+#include <array>
+#include <atomic>
+#include <thread>
+#include <algorithm>
+#include <ctime>
+#include <unistd.h>
+#include <fcntl.h>
+#include <termios.h>
+#include <sys/epoll.h>
+
+extern "C" {
+#include "../../sht11con.h"
+}
+
+#include "../aggd/aggd.h"
+
+/// simulated node (device side of pty)
+struct sim_node_t {
+    int master;
+    uint8_t seq = 0;            // device frame counter
+    uint8_t stream = 0;         // samples per stream frame (0 .. not streaming)
+    uint8_t collected = 0;
+    uint8_t rx[64];
+    size_t rx_len = 0;
+    uint8_t payload[2+4*4];
+    std::array<std::atomic<int64_t>,256> send_ns;   // write time of data frame by seq
+};
+
+static std::vector<sim_node_t*> sim;
+static std::atomic<bool> sim_stop{false};
+static std::atomic<uint64_t> sim_sent{0}, sim_blocked{0};
+static int64_t sim_cpu = 0;
+
+/// node values (T, RH * 10), different for every node
+static int16_t node_t(int n) { return -200+(n*37)%800; }
+static int16_t node_h(int n) { return 50+(n*53)%900; }
+
+/// open pty pair, returns slave (aggregator side), master to *master
+static int open_pty(int *master)
+{
+    int m = posix_openpt(O_RDWR|O_NOCTTY|O_NONBLOCK|O_CLOEXEC);
+    if ((m<0)||(grantpt(m)!=0)||(unlockpt(m)!=0)) return -1;
+    int s = open(ptsname(m),O_RDWR|O_NOCTTY|O_NONBLOCK|O_CLOEXEC);
+    if (s<0) return -1;
+    struct termios tio;
+    tcgetattr(s,&tio);
+    cfmakeraw(&tio);
+    tcsetattr(s,TCSANOW,&tio);
+    *master = m;
+    return s;
+}
+
+static void sim_write(sim_node_t *n, const uint8_t *f, size_t len, bool data)
+{
+    if (data) n->send_ns[n->seq] = agg_now_ns();
+    if (write(n->master,f,len)!=(ssize_t)len) { sim_blocked++; return; } // slave buffer full
+    n->seq++;
+}
+
+/// one sample to stream frame (or poll answer)
+static void sim_sample(sim_node_t *n, int num, bool poll)
+{
+    uint8_t *v = n->payload+2+n->collected*4;
+    int16_t t = node_t(num), h = node_h(num);
+    v[0] = t&0xff; v[1] = (t>>8)&0xff;
+    v[2] = h&0xff; v[3] = (h>>8)&0xff;
+    n->collected++;
+    if (!poll && (n->collected<n->stream)) return;
+    uint8_t f[5+sizeof(n->payload)];
+    n->payload[0] = n->collected;
+    n->payload[1] = 2;
+    size_t len = agg_frame(f,AGG_DATA,n->seq,n->payload,2+n->collected*4);
+    sim_write(n,f,len,true);
+    sim_sent += n->collected;
+    n->collected = 0;
+}
+
+/// commands from aggregator
+static void sim_rx(sim_node_t *n, int num)
+{
+    ssize_t r;
+    while ((r = read(n->master,n->rx+n->rx_len,sizeof(n->rx)-n->rx_len))>0)
+    {
+        n->rx_len += r;
+        while (n->rx_len>=5)
+        {
+            uint8_t *f = n->rx, plen = f[3];
+            if ((f[0]!=AGG_SYNC)||(plen>4)) { memmove(f,f+1,--n->rx_len); continue; }
+            if (n->rx_len<(size_t)plen+5) break;
+            if (agg_crc8(f+1,3+plen)==f[4+plen])
+            {
+                if (f[1]==AGG_CMD_STREAM)
+                {
+                    uint8_t ack[2] = {f[2],0}, a[8];
+                    n->stream = plen?f[4]:0;
+                    n->collected = 0;
+                    sim_write(n,a,agg_frame(a,AGG_ACK,n->seq,ack,2),false);
+                }
+                else if (f[1]==AGG_CMD_POLL)
+                {
+                    n->collected = 0;
+                    sim_sample(n,num,true);
+                }
+            }
+            memmove(f,f+plen+5,n->rx_len-plen-5);
+            n->rx_len -= plen+5;
+        }
+    }
+}
+
+/// all nodes in one thread, node k streams at phase k/nodes of sample period
+static void sim_run(double rate)
+{
+    int ep = epoll_create1(0);
+    struct epoll_event ev[64];
+    for (size_t i=0;i<sim.size();i++)
+    {
+        ev[0].events = EPOLLIN;
+        ev[0].data.u32 = i;
+        epoll_ctl(ep,EPOLL_CTL_ADD,sim[i]->master,&ev[0]);
+    }
+    int64_t step = (int64_t)(1e9/rate/sim.size()), next = agg_now_ns();
+    size_t k = 0;
+    while (!sim_stop)
+    {
+        int64_t now = agg_now_ns();
+        while (now>=next)
+        {
+            if (sim[k]->stream) sim_sample(sim[k],k,false);
+            k = (k+1)%sim.size();
+            next += step;
+        }
+        int wait = (int)((next-now+999999)/1000000); // ms timer, nodes due in the same ms written together
+        int c = epoll_wait(ep,ev,64,wait);
+        for (int i=0;i<c;i++) sim_rx(sim[ev[i].data.u32],ev[i].data.u32);
+    }
+    close(ep);
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID,&ts);
+    sim_cpu = (int64_t)ts.tv_sec*1000000000+ts.tv_nsec;
+}
+
+/// check consumer (latency and values), one per test
+struct check_t {
+    std::vector<std::vector<int32_t>> lat;  // us per node
+    uint64_t received = 0, wrong = 0;
+};
+
+static double pct(std::vector<int32_t> &v, double p)
+{
+    if (v.empty()) return 0;
+    size_t i = (size_t)(p*(v.size()-1));
+    std::nth_element(v.begin(),v.begin()+i,v.end());
+    return v[i];
+}
+
+int main(int argc, char *argv[])
+{
+    int nodes = (argc>1)?atoi(argv[1]):128;
+    double rate = (argc>2)?atof(argv[2]):50;
+    double seconds = (argc>3)?atof(argv[3]):5;
+    int per_frame = (argc>4)?atoi(argv[4]):1;
+    if ((nodes<1)||(rate<=0)||(seconds<=0)||(per_frame<1)||(per_frame>4))
+    {
+        fprintf(stderr,"usage: aggload [nodes] [samples/s per node] [seconds] [samples per frame 1..4]\n");
+        return 2;
+    }
+
+    aggregator_t agg;
+    for (int i=0;i<nodes;i++)
+    {
+        sim_node_t *n = new sim_node_t;
+        int s = open_pty(&n->master);
+        if (s<0) { perror("pty"); return 1; }
+        sim.push_back(n);
+        agg.add_node(s,"pty"+std::to_string(i));
+    }
+    agg.set_stream_samples(per_frame);
+
+    // consumer 1 .. latency and value check
+    check_t chk;
+    chk.lat.resize(nodes);
+    agg.add_consumer([&](const agg_result_t &r)
+    {
+        int64_t sent = sim[r.node]->send_ns[r.seq];
+        chk.lat[r.node].push_back((int32_t)((agg_now_ns()-sent)/1000));
+        chk.received++;
+        if ((r.t!=node_t(r.node))||(r.h!=node_h(r.node))||
+            (r.dew!=sht_dewpoint(r.t,r.h))||(r.abshum!=sht_abshum(r.t,r.h))) chk.wrong++;
+    });
+    // consumer 2 .. csv formatting (the same line as aggd), slow consumer doesn't stall the first one
+    uint64_t formatted = 0, chars = 0;
+    agg.add_consumer([&](const agg_result_t &r)
+    {
+        char line[80];
+        chars += snprintf(line,sizeof(line),"%.3f,pty%u,%d,%d,%d,%d\n",r.rx_ns/1e9,r.node,r.t,r.h,r.dew,r.abshum);
+        formatted++;
+    });
+
+    printf("%d nodes, %.0f samples/s per node (%.0f total), %d per frame, %.1f s\n",
+           nodes,rate,rate*nodes,per_frame,seconds);
+    int64_t t0 = agg_now_ns();
+    if (!agg.start()) { fprintf(stderr,"start failed\n"); return 1; }
+    std::thread simt(sim_run,rate);
+    usleep((useconds_t)(seconds*1e6));
+    sim_stop = true;
+    simt.join();
+    usleep(200000); // last frames through pty and queues
+    agg.stop();
+    double wall = (agg_now_ns()-t0)/1e9;
+
+    // per node latency
+    std::vector<int32_t> all;
+    uint64_t lost = 0, crc = 0, resub = 0, frames = 0;
+    double worst_p99 = 0, worst_max = 0;
+    int worst = 0;
+    for (int i=0;i<nodes;i++)
+    {
+        agg_node_stats_t s = agg.node_stats(i);
+        lost += s.lost;
+        crc += s.crc_errors;
+        resub += s.resubscribes;
+        frames += s.frames;
+        all.insert(all.end(),chk.lat[i].begin(),chk.lat[i].end());
+        double p99 = pct(chk.lat[i],0.99), mx = chk.lat[i].empty()?0:*std::max_element(chk.lat[i].begin(),chk.lat[i].end());
+        if (p99>worst_p99) { worst_p99 = p99; worst = i; }
+        if (mx>worst_max) worst_max = mx;
+    }
+    uint64_t sent = sim_sent;
+    printf("samples sent %" PRIu64 ", received %" PRIu64 " / %" PRIu64 " (consumers), wrong %" PRIu64 "\n",
+           sent,chk.received,formatted,chk.wrong);
+    printf("frames %" PRIu64 ", lost %" PRIu64 ", crc errors %" PRIu64 ", node tx blocked %" PRIu64 ", resubscribes %" PRIu64 "\n",
+           frames,lost,crc,(uint64_t)sim_blocked,resub);
+    printf("latency us (node write to consumer): p50 %.0f, p99 %.0f, max %.0f; worst node %s p99 %.0f\n",
+           pct(all,0.5),pct(all,0.99),worst_max,agg.node_name(worst).c_str(),worst_p99);
+
+    agg_stage_stats_t st = agg.stage_stats();
+    double n = chk.received?chk.received:1;
+    printf("%-12s %12s %12s %10s\n","thread","CPU ms","us/sample","% of core");
+    auto cpu = [&](const char *name, int64_t ns)
+    {
+        printf("%-12s %12.1f %12.2f %10.1f\n",name,ns/1e6,ns/1e3/n,ns/1e7/wall);
+    };
+    cpu("reader",st.reader_cpu_ns);
+    cpu("converter",st.converter_cpu_ns);
+    cpu("check",st.consumer_cpu_ns[0]);
+    cpu("csv",st.consumer_cpu_ns[1]);
+    cpu("(nodes)",sim_cpu);
+    printf("converter queue full %" PRIu64 ", consumer drops %" PRIu64 " / %" PRIu64 " (csv chars %" PRIu64 ")\n",
+           st.queue_full,st.consumer_drops[0],st.consumer_drops[1],chars);
+
+    bool ok = sent && (chk.received==sent) && (formatted==sent) && !chk.wrong && !lost && !crc && !sim_blocked;
+    printf("%s\n",ok?"OK":"FAILED");
+    for (auto s : sim) { close(s->master); delete s; }
+    return !ok;
+}
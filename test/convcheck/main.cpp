@@ -0,0 +1,264 @@
+/*
+ * sht11con.c full-space verification - compares conversion backends over all
+ * register pairs on all cores (std::thread), error histograms, worst cases, timing
+ *
+ * usage:
+ *   convcheck .. regression gate (every engine against its reference, exit code 1 on failure)
+ *   convcheck ref engine [threads] .. compare two backends (names listed on wrong name)
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <cinttypes>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+
+extern "C" {
+#include "../../sht11con.h"
+}
+
+/// double based conversion - used as muster value (the same as test/convtest)
+static void conv_double(uint16_t tR, uint16_t hR, int16_t *T, int16_t *H,
+                        double c1, double c2, double c3, double d1, double d2, double t1, double t2)
+{
+    double dRH = c1 + c2*hR + c3*(double)hR*hR;
+    double dT = d1 + d2*tR;
+    double dRHc = (dT - 25.0) * (t1 - t2*tR) + dRH;
+    if (dRHc>100.0) dRHc=100.0;
+    if (dRHc<0) dRHc=0;
+    *T = (int16_t)(dT*10.0);
+    *H = (int16_t)(dRHc*10.0);
+}
+
+static void sht2int_double(uint16_t tR, uint16_t hR, int16_t *T, int16_t *H)
+{
+    conv_double(tR,hR,T,H,C1,C2,C3,D1,D2,T1,T2);
+}
+
+static void sht2int_double_lowres(uint16_t tR, uint16_t hR, int16_t *T, int16_t *H)
+{
+    conv_double(tR,hR,T,H,C1L,C2L,C3L,D1L,D2L,T1L,T2L);
+}
+
+/// conversion backend (single pair or batch function, register ranges)
+typedef void (*conv_fn)(uint16_t tR, uint16_t hR, int16_t *T, int16_t *H);
+typedef void (*batch_fn)(const uint16_t *tR, const uint16_t *hR, int16_t *T, int16_t *H, size_t n);
+
+struct backend_t {
+    const char *name;
+    conv_fn conv;
+    batch_fn batch;
+    uint16_t tmax, hmax;
+};
+
+static const backend_t backends[] = {
+    {"double",        sht2int_double,        0, 16384, 4096},
+    {"float",         sht2int_float,         0, 16384, 4096},
+    {"fixed",         sht2int_fixed,         0, 16384, 4096},
+    {"table",         sht2int_table,         0, 16384, 4096},
+    {"batch",         0,         sht2int_batch, 16384, 4096},
+    {"double_lowres", sht2int_double_lowres, 0, 4096, 256},
+    {"float_lowres",  sht2int_float_lowres,  0, 4096, 256},
+    {"fixed_lowres",  sht2int_fixed_lowres,  0, 4096, 256},
+};
+
+static const backend_t *find_backend(const char *name)
+{
+    for (const backend_t &b : backends) if (strcmp(b.name,name)==0) return &b;
+    return 0;
+}
+
+/// one row (fixed tR, all hR) converted by backend
+static void convert_row(const backend_t *b, uint16_t tR, const uint16_t *hR, uint16_t *tRow,
+                        int16_t *T, int16_t *H)
+{
+    if (b->batch)
+    {
+        std::fill(tRow,tRow+b->hmax,tR);
+        b->batch(tRow,hR,T,H,b->hmax);
+    }
+    else for (unsigned h=0;h<b->hmax;h++) b->conv(tR,h,&T[h],&H[h]);
+}
+
+/// histogram bins (|error| 0 .. HIST_BINS-2, last bin is everything above)
+#define HIST_BINS 6
+/// worst cases kept
+#define WORST 8
+
+/// worst case input
+struct worst_t {
+    int err;
+    uint16_t tR, hR;
+    int16_t rT, rH, eT, eH;
+    bool operator<(const worst_t &o) const { return err>o.err || (err==o.err && (tR<o.tR || (tR==o.tR && hR<o.hR))); }
+};
+
+/// comparison result (per thread, merged)
+struct result_t {
+    uint64_t histT[HIST_BINS] = {0}, histH[HIST_BINS] = {0};
+    uint64_t sumT = 0, sumH = 0, count = 0;
+    int maxT = 0, maxH = 0;
+    std::vector<worst_t> worst;
+
+    void add_worst(const worst_t &w)
+    {
+        if (worst.size()==WORST && !(w<worst.back())) return;
+        worst.insert(std::upper_bound(worst.begin(),worst.end(),w),w);
+        if (worst.size()>WORST) worst.pop_back();
+    }
+
+    void merge(const result_t &o)
+    {
+        for (int i=0;i<HIST_BINS;i++) { histT[i] += o.histT[i]; histH[i] += o.histH[i]; }
+        sumT += o.sumT; sumH += o.sumH; count += o.count;
+        maxT = std::max(maxT,o.maxT); maxH = std::max(maxH,o.maxH);
+        for (const worst_t &w : o.worst) add_worst(w);
+    }
+};
+
+/// rows taken by threads in chunks (balances fast and slow regions)
+#define ROW_CHUNK 64
+
+/// compare engine to reference over full register space
+static result_t compare(const backend_t *ref, const backend_t *eng, unsigned threads)
+{
+    std::vector<result_t> part(threads);
+    std::vector<std::thread> pool;
+    std::atomic<unsigned> next(0);
+    unsigned tmax = std::min(ref->tmax,eng->tmax), hmax = std::min(ref->hmax,eng->hmax);
+
+    for (unsigned n=0;n<threads;n++) pool.emplace_back([&,n]()
+    {
+        std::vector<uint16_t> hR(hmax), tRow(hmax);
+        std::vector<int16_t> rT(hmax), rH(hmax), eT(hmax), eH(hmax);
+        result_t &r = part[n];
+        for (unsigned h=0;h<hmax;h++) hR[h] = h;
+        unsigned t0;
+        while ((t0 = next.fetch_add(ROW_CHUNK))<tmax)
+            for (unsigned t=t0;(t<t0+ROW_CHUNK)&&(t<tmax);t++)
+            {
+                convert_row(ref,t,hR.data(),tRow.data(),rT.data(),rH.data());
+                convert_row(eng,t,hR.data(),tRow.data(),eT.data(),eH.data());
+                for (unsigned h=0;h<hmax;h++)
+                {
+                    int dT = std::abs(eT[h]-rT[h]), dH = std::abs(eH[h]-rH[h]);
+                    r.histT[std::min(dT,HIST_BINS-1)]++;
+                    r.histH[std::min(dH,HIST_BINS-1)]++;
+                    r.sumT += dT; r.sumH += dH;
+                    r.maxT = std::max(r.maxT,dT); r.maxH = std::max(r.maxH,dH);
+                    if (dT|dH) r.add_worst({std::max(dT,dH),(uint16_t)t,(uint16_t)h,rT[h],rH[h],eT[h],eH[h]});
+                }
+                r.count += hmax;
+            }
+    });
+    for (std::thread &th : pool) th.join();
+    result_t all;
+    for (const result_t &r : part) all.merge(r);
+    return all;
+}
+
+/// time backend alone over full register space (ns per conversion, wall clock)
+static double timing(const backend_t *b, unsigned threads)
+{
+    std::vector<std::thread> pool;
+    std::atomic<unsigned> next(0);
+    std::atomic<int> sink(0);
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned n=0;n<threads;n++) pool.emplace_back([&]()
+    {
+        std::vector<uint16_t> hR(b->hmax), tRow(b->hmax);
+        std::vector<int16_t> T(b->hmax), H(b->hmax);
+        int s = 0;
+        for (unsigned h=0;h<b->hmax;h++) hR[h] = h;
+        unsigned t0;
+        while ((t0 = next.fetch_add(ROW_CHUNK))<b->tmax)
+            for (unsigned t=t0;(t<t0+ROW_CHUNK)&&(t<b->tmax);t++)
+            {
+                convert_row(b,t,hR.data(),tRow.data(),T.data(),H.data());
+                s += T[t%b->hmax]+H[t%b->hmax];
+            }
+        sink += s;
+    });
+    for (std::thread &th : pool) th.join();
+    double sec = std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+    return sec*1e9/((double)b->tmax*b->hmax);
+}
+
+/// print comparison (histogram, worst cases)
+static void report(const backend_t *ref, const backend_t *eng, const result_t &r)
+{
+    printf("%s vs %s: %" PRIu64 " pairs, max error T %d H %d, avg T %.6f H %.6f\n",eng->name,ref->name,
+           r.count,r.maxT,r.maxH,(double)r.sumT/r.count,(double)r.sumH/r.count);
+    printf("  |error|     ");
+    for (int i=0;i<HIST_BINS-1;i++) printf("%12d",i);
+    printf("%11d+\n  T histogram ",HIST_BINS-1);
+    for (int i=0;i<HIST_BINS;i++) printf("%12" PRIu64,r.histT[i]);
+    printf("\n  H histogram ");
+    for (int i=0;i<HIST_BINS;i++) printf("%12" PRIu64,r.histH[i]);
+    printf("\n");
+    for (const worst_t &w : r.worst)
+        printf("  worst tR 0x%04X hR 0x%03X: %s T %d H %d, %s T %d H %d\n",w.tR,w.hR,
+               ref->name,w.rT,w.rH,eng->name,w.eT,w.eH);
+}
+
+/// regression gate (engine, reference, max. allowed error T and H)
+struct gate_t {
+    const char *eng, *ref;
+    int maxT, maxH;
+};
+
+static const gate_t gates[] = {
+    {"float", "double", 1, 1},
+    {"fixed", "double", 1, 1},
+    {"table", "double", 1, 1},
+    {"batch", "fixed", 0, 0},
+    {"float_lowres", "double_lowres", 1, 1},
+    {"fixed_lowres", "double_lowres", 1, 1},
+};
+
+int main(int argc, char *argv[])
+{
+    unsigned threads = std::max(1u,std::thread::hardware_concurrency());
+    auto start = std::chrono::steady_clock::now();
+
+    if (argc>=3) // compare two backends
+    {
+        const backend_t *ref = find_backend(argv[1]), *eng = find_backend(argv[2]);
+        if (argc>3) threads = std::max(1,atoi(argv[3]));
+        if (!ref || !eng)
+        {
+            printf("backends:");
+            for (const backend_t &b : backends) printf(" %s",b.name);
+            printf("\n");
+            return 2;
+        }
+        report(ref,eng,compare(ref,eng,threads));
+        printf("timing (%u threads): %s %.3f ns/conv, %s %.3f ns/conv\n",threads,
+               ref->name,timing(ref,threads),eng->name,timing(eng,threads));
+        return 0;
+    }
+
+    int failed = 0;
+    printf("regression gate, %u threads\n",threads);
+    for (const gate_t &g : gates)
+    {
+        const backend_t *ref = find_backend(g.ref), *eng = find_backend(g.eng);
+        result_t r = compare(ref,eng,threads);
+        report(ref,eng,r);
+        if ((r.maxT>g.maxT)||(r.maxH>g.maxH))
+        {
+            printf("FAILED: %s max error above T %d H %d\n",eng->name,g.maxT,g.maxH);
+            failed++;
+        }
+    }
+    printf("timing (%u threads):\n",threads);
+    for (const backend_t &b : backends) printf("  %-14s %7.3f ns/conv\n",b.name,timing(&b,threads));
+    printf("%d gates failed, %.1fs\n",failed,
+           std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count());
+    return (failed!=0);
+}
@@ -1,23 +1,34 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <math.h>
 #include <inttypes.h>
 #include <string.h>
 #include <time.h>
 
 #include "../../sht11con.h"
+#include "../../sht11tab.h"
 
-/// double based conversion function - used as muster value
-void sht2int_double(uint16_t tR, uint16_t hR, int16_t *T, int16_t *H)
+// cpu cycle counter (x86 hosts only)
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define CYCLES() __rdtsc()
+#else
+#define CYCLES() 0
+#endif
+
+/// double based conversion - used as muster value
+void conv_double(uint16_t tR, uint16_t hR, int16_t *T, int16_t *H,
+                 double c1, double c2, double c3, double d1, double d2, double t1, double t2)
 {
     double tRd = (double) tR;
     double hRd = (double) hR;
 
     // linear RH
-    double dRH = C1 + C2*hRd + C3*hRd*hRd;
+    double dRH = c1 + c2*hRd + c3*hRd*hRd;
     // temperature
-    double dT = D1 + D2*tRd;
+    double dT = d1 + d2*tRd;
     // temp. compensated RH
-    double dRHc = (dT - 25.0) * (T1 - T2*tRd) + dRH;
+    double dRHc = (dT - 25.0) * (t1 - t2*tRd) + dRH;
     if (dRHc>100.0) dRHc=100.0;
     if (dRHc<0) dRHc=0;
 
@@ -30,48 +41,58 @@ void sht2int_double(uint16_t tR, uint16_t hR, int16_t *T, int16_t *H)
     *H = iRH;
 }
 
-/// test body
-int main(int argc, char *argv[])
+/// double based conversion function (14bit T, 12bit RH)
+void sht2int_double(uint16_t tR, uint16_t hR, int16_t *T, int16_t *H)
 {
-    uint16_t tReg = 0;
-    uint16_t hReg = 0;
+    conv_double(tR,hR,T,H,C1,C2,C3,D1,D2,T1,T2);
+}
 
-    int16_t tVal = 0;
-    int16_t hVal = 0;
+/// double based conversion function (12bit T, 8bit RH)
+void sht2int_double_lowres(uint16_t tR, uint16_t hR, int16_t *T, int16_t *H)
+{
+    conv_double(tR,hR,T,H,C1L,C2L,C3L,D1L,D2L,T1L,T2L);
+}
 
-    if (argc==3) // if reg values given in args - just compute one result
-    {
-        // get values from input args
-        if (argv[2][strlen(argv[2])-1]=='h') sscanf(argv[2],"%X",(unsigned int*)&hReg);
-        else sscanf(argv[2],"%d",(unsigned int*)&hReg);
-        if (argv[1][strlen(argv[1])-1]=='h') sscanf(argv[1],"%X",(unsigned int*)&tReg);
-        else sscanf(argv[1],"%d",(unsigned int*)&tReg);
-        // show it
-        printf("temp.reg.: 0x%04X; humi.reg.: 0x%04X\n",tReg,hReg);
+/// conversion engine type
+typedef void (*conv_fn)(uint16_t tR, uint16_t hR, int16_t *T, int16_t *H);
 
-        // convert
-        sht2int_double(tReg,hReg,&tVal,&hVal);
-        // show result
-        printf("\nTemp(int): %d; Hum(int): %d\n",tVal,hVal);
-        // test int2bcd function
-        printf("Temp(bcd): %X; Hum(bcd): %X\n",int2bcd(tVal),int2bcd(hVal));
-        return 0;
-    }
+/// convert all combinations (tmax*hmax) with given engine and compare it to reference
+/// returns cycles per conversion
+double sweep_range(const char *name, conv_fn conv, conv_fn ref, uint16_t tmax, uint16_t hmax)
+{
+    uint16_t tReg = 0;
+    uint16_t hReg = 0;
 
+    int16_t tVal, hVal;
     int16_t tValF, hValF;
     uint16_t eTmax=0, eHmax=0;
     double eTavg=0, eHavg=0;
     double cnt=0.0;
 
-    printf("Converting all 2^26 combinations ... ");
+    // timing (engine only)
     clock_t start = clock();
+    uint64_t cyc = CYCLES();
+    volatile int16_t sink = 0;
+    while(1)
+    {
+        conv(tReg,hReg,&tValF,&hValF);
+        sink += tValF + hValF;
+        hReg ++;
+        if (hReg==hmax) {hReg=0;tReg++;}
+        if (tReg==tmax) break;
+    }
+    cyc = CYCLES() - cyc;
+    double t = ((double)clock() - start) / CLOCKS_PER_SEC;
+
+    // errors
+    tReg = 0;
     while(1)
     {
         cnt+=1.0;
         // convert
-        sht2int_double(tReg,hReg,&tVal,&hVal);
+        ref(tReg,hReg,&tVal,&hVal);
         // convert (other way)
-        sht2int(tReg,hReg,&tValF,&hValF);
+        conv(tReg,hReg,&tValF,&hValF);
         int e = abs(tValF-tVal);
         eTavg+=e;
         if (eTmax<e) eTmax=e;
@@ -81,14 +102,284 @@ int main(int argc, char *argv[])
 
         // values for next conversion
         hReg ++;
-        if (hReg==4096) {hReg=0;tReg++;}
-        if (tReg==16384) break;
+        if (hReg==hmax) {hReg=0;tReg++;}
+        if (tReg==tmax) break;
     }
     eTavg/=cnt;
     eHavg/=cnt;
 
-    printf ( "%.2fs\n", ( (double)clock() - start ) / CLOCKS_PER_SEC );
-    printf("Max errors T: %d, H: %d\n",eTmax,eHmax);
-    printf("Avg error (%.0f samples) T: %f, H: %f",cnt,eTavg,eHavg);
+    printf("%-6s %.2fs (%.2f ns/conv, %.1f cycles/conv)\n",name,t,t*1e9/cnt,(double)cyc/cnt);
+    printf("       Max errors T: %d, H: %d\n",eTmax,eHmax);
+    printf("       Avg error (%.0f samples) T: %f, H: %f\n",cnt,eTavg,eHavg);
+    return (double)cyc/cnt;
+}
+
+/// convert all 2^26 combinations with given engine and compare it to double
+double sweep(const char *name, conv_fn conv)
+{
+    return sweep_range(name,conv,sht2int_double,16384,4096);
+}
+
+/// T or H alone (other output NULL, as main.c T stage does) against both at once, every engine
+void split_test(void)
+{
+    const conv_fn fn[] = {sht2int,sht2int_float,sht2int_fixed,sht2int_table,
+                          sht2int_lowres,sht2int_float_lowres,sht2int_fixed_lowres};
+    unsigned long diff = 0;
+    unsigned int i, t, h;
+    int16_t tVal, hVal, tOnly, hOnly;
+
+    for (i=0;i<sizeof(fn)/sizeof(fn[0]);i++)
+        for (t=0;t<16384;t+=3)
+            for (h=0;h<4096;h+=5)
+            {
+                fn[i](t,h,&tVal,&hVal);
+                tOnly = hOnly = -1;
+                fn[i](t,h,&tOnly,NULL);
+                fn[i](t,h,NULL,&hOnly);
+                if ((tOnly!=tVal)||(hOnly!=hVal)) diff++;
+            }
+    printf("T or H alone: %lu differences to both at once\n",diff);
+}
+
+/// batch conversion of all 2^26 combinations (rows of 4096 RH values), must equal fixed engine
+/// returns ns per conversion
+double sweep_batch(void)
+{
+    static uint16_t tR[4096], hR[4096];
+    static int16_t T[4096], H[4096];
+    int16_t tVal, hVal;
+    unsigned long diff = 0;
+    int t, h;
+
+    for (h=0;h<4096;h++) hR[h] = h;
+    // timing
+    clock_t start = clock();
+    volatile int16_t sink = 0;
+    for (t=0;t<16384;t++)
+    {
+        for (h=0;h<4096;h++) tR[h] = t;
+        sht2int_batch(tR,hR,T,H,4096);
+        sink += T[t&4095] + H[t&4095];
+    }
+    double sec = ((double)clock() - start) / CLOCKS_PER_SEC;
+    // compare (odd length to check the rest after blocks)
+    for (t=0;t<16384;t++)
+    {
+        for (h=0;h<4096;h++) tR[h] = t;
+        sht2int_batch(tR,hR,T,H,4095);
+        for (h=0;h<4095;h++)
+        {
+            sht2int_fixed(t,h,&tVal,&hVal);
+            if ((T[h]!=tVal)||(H[h]!=hVal)) diff++;
+        }
+    }
+    printf("batch  %.3fs (%.2f ns/conv), differences to fixed: %lu\n",sec,sec*1e9/(16384.0*4096),diff);
+    return sec*1e9/(16384.0*4096);
+}
+
+/// batch conversion of long raw log (memory bound), returns MB/s of registers in and values out
+double batch_log(size_t n)
+{
+    uint16_t *tR = malloc(n*sizeof(uint16_t)), *hR = malloc(n*sizeof(uint16_t));
+    int16_t *T = malloc(n*sizeof(int16_t)), *H = malloc(n*sizeof(int16_t));
+    size_t i;
+    for (i=0;i<n;i++) { tR[i] = 6000+(i%1000); hR[i] = 1000+(i%2000); }
+    sht2int_batch(tR,hR,T,H,n); // pages mapped
+    clock_t start = clock();
+    sht2int_batch(tR,hR,T,H,n);
+    double sec = ((double)clock() - start) / CLOCKS_PER_SEC;
+    printf("batch log of %lu samples: %.3fs, %.0f MB/s (%.1f years of 5s samples per second)\n",
+           (unsigned long)n,sec,n*8/sec/1e6,n/sec*5/(365.0*86400));
+    free(tR); free(hR); free(T); free(H);
+    return n*8/sec/1e6;
+}
+
+/// previous int2bcd (repeated %10 and /10) - used as muster value
+uint16_t int2bcd_div(int16_t w)
+{
+    uint16_t buf;
+    if (w>7999) return 0x7999;
+    if (w<-7999) return 0xF999;
+    if ((w&0x8000)!=0) buf=-w; else buf=w;
+    uint16_t bcd = buf%10;
+    uint16_t mul = 1;
+    buf /= 10;
+    while (buf!=0)
+    {
+        mul <<= 4;
+        bcd |= buf%10*mul;
+        buf /= 10;
+    }
+    bcd|=(w&0x8000);
+    return bcd;
+}
+
+/// bcd encoders: int2bcd against division version (whole int16 range), sht2bcd against
+/// int2bcd(sht2int_fixed) (all register pairs, all 16bit T registers), cycles per call
+void bcd_test(void)
+{
+    unsigned long diff = 0;
+    int w, t, h;
+    int16_t tVal, hVal;
+    uint16_t tB, hB;
+    volatile uint16_t sink = 0;
+
+    for (w=-32768;w<=32767;w++) if (int2bcd(w)!=int2bcd_div(w)) diff++;
+    printf("int2bcd: %lu differences to division version (-32768 .. 32767)\n",diff);
+
+    uint64_t cyc = CYCLES();
+    for (w=-7999;w<=7999;w++) sink += int2bcd_div(w);
+    double cDiv = (double)(CYCLES()-cyc)/15999;
+    cyc = CYCLES();
+    for (w=-7999;w<=7999;w++) sink += int2bcd(w);
+    double cDab = (double)(CYCLES()-cyc)/15999;
+    printf("int2bcd cycles (host): division %.1f, double dabble %.1f\n",cDiv,cDab);
+    printf("  (host divides by 10 by multiplication, MSP430 calls libgcc loops - measure there by SHT_PROF 'p')\n");
+
+    diff = 0;
+    for (t=0;t<16384;t++)
+        for (h=0;h<4096;h++)
+        {
+            sht2int_fixed(t,h,&tVal,&hVal);
+            sht2bcd(t,h,&tB,&hB);
+            if ((tB!=int2bcd(tVal))||(hB!=int2bcd(hVal))) diff++;
+        }
+    for (t=16384;t<65536;t++)
+    {
+        sht2int_fixed(t,1000,&tVal,&hVal);
+        sht2bcd(t,1000,&tB,&hB);
+        if ((tB!=int2bcd(tVal))||(hB!=int2bcd(hVal))) diff++;
+    }
+    printf("sht2bcd: %lu differences to int2bcd(sht2int_fixed)\n",diff);
+
+    cyc = CYCLES();
+    for (t=0;t<16384;t++)
+    {
+        sht2int_fixed(t,t>>2,&tVal,&hVal);
+        sink += int2bcd(tVal) + int2bcd(hVal);
+    }
+    double cInt = (double)(CYCLES()-cyc)/16384;
+    cyc = CYCLES();
+    for (t=0;t<16384;t++)
+    {
+        sht2bcd(t,t>>2,&tB,&hB);
+        sink += tB + hB;
+    }
+    printf("registers to bcd cycles (host): sht2int_fixed+int2bcd %.1f, sht2bcd %.1f\n",
+           cInt,(double)(CYCLES()-cyc)/16384);
+    printf("  (sht2bcd saves the signed T/10, a libgcc loop on MSP430 - not visible on host)\n");
+}
+
+/// dew point and absolute humidity *10 by double formulas (RH below 0.1 % taken as 0.1 %)
+void dew_double(int16_t T, int16_t H, int16_t *Td, int16_t *AH)
+{
+    double t = T/10.0, rh = ((H<1)?1:H)/1000.0;
+    double g = DP_B*t/(DP_C+t);
+    double gamma = log(rh) + g;
+    *Td = (int16_t)lround(DP_C*gamma/(DP_B-gamma)*10.0);
+    *AH = (H<=0) ? 0 : (int16_t)lround(10.0*rh*AH_K*DP_E0*exp(g)/(273.15+t));
+}
+
+/// error histogram bins (|error| in 0.1 units, last bin is everything above)
+#define DEW_BINS 4
+
+/// sht_dewpoint and sht_abshum against double over all T*10 (tmin .. tmax) and RH*10 (0 .. 1000)
+void dew_range(int16_t tmin, int16_t tmax)
+{
+    unsigned long hD[DEW_BINS] = {0}, hA[DEW_BINS] = {0};
+    int eD = 0, eA = 0, wDt = 0, wDh = 0, wAt = 0, wAh = 0;
+    double rel = 0;
+    int t, h, i;
+    int16_t rD, rA;
+
+    for (t=tmin;t<=tmax;t++)
+        for (h=0;h<=1000;h++)
+        {
+            dew_double(t,h,&rD,&rA);
+            int d = abs(sht_dewpoint(t,h)-rD), a = abs(sht_abshum(t,h)-rA);
+            hD[(d<DEW_BINS)?d:DEW_BINS-1]++;
+            hA[(a<DEW_BINS)?a:DEW_BINS-1]++;
+            if (d>eD) {eD = d; wDt = t; wDh = h;}
+            if (a>eA) {eA = a; wAt = t; wAh = h;}
+            if ((rA>=500)&&((double)a/rA>rel)) rel = (double)a/rA;
+        }
+    printf("T %.1f .. %.1f C, RH 0 .. 100 %% (%lu values)\n",tmin/10.0,tmax/10.0,
+           (unsigned long)(tmax-tmin+1)*1001);
+    printf("  dew point max error %d (T %d RH %d), histogram",eD,wDt,wDh);
+    for (i=0;i<DEW_BINS;i++) printf(" %lu",hD[i]);
+    printf("\n  abs. humidity max error %d (T %d RH %d, %.2f %% above 50 g/m^3), histogram",
+           eA,wAt,wAh,rel*100);
+    for (i=0;i<DEW_BINS;i++) printf(" %lu",hA[i]);
+    printf("\n");
+}
+
+/// dew point and absolute humidity: exhaustive error report (0.1 C, 0.1 g/m^3), cycles per call
+void dew_test(void)
+{
+    int t;
+    int16_t rD, rA;
+    volatile int16_t sink = 0;
+
+    printf("Dew point / absolute humidity against double (error histogram 0,1,2,3+ LSB):\n");
+    dew_range(-400,1250); // sensor range
+    dew_range(-400,600); // Magnus formula range
+
+    uint64_t cyc = CYCLES();
+    for (t=-400;t<=1250;t++) { dew_double(t,t&511,&rD,&rA); sink += rD + rA; }
+    double cDbl = (double)(CYCLES()-cyc)/1651;
+    cyc = CYCLES();
+    for (t=-400;t<=1250;t++) sink += sht_dewpoint(t,t&511) + sht_abshum(t,t&511);
+    printf("cycles (host): double %.1f, integer %.1f (MSP430 by SHT_PROF 'p')\n",
+           cDbl,(double)(CYCLES()-cyc)/1651);
+}
+
+/// test body
+int main(int argc, char *argv[])
+{
+    uint16_t tReg = 0;
+    uint16_t hReg = 0;
+
+    int16_t tVal = 0;
+    int16_t hVal = 0;
+
+    if (argc==3) // if reg values given in args - just compute one result
+    {
+        // get values from input args
+        if (argv[2][strlen(argv[2])-1]=='h') sscanf(argv[2],"%X",(unsigned int*)&hReg);
+        else sscanf(argv[2],"%d",(unsigned int*)&hReg);
+        if (argv[1][strlen(argv[1])-1]=='h') sscanf(argv[1],"%X",(unsigned int*)&tReg);
+        else sscanf(argv[1],"%d",(unsigned int*)&tReg);
+        // show it
+        printf("temp.reg.: 0x%04X; humi.reg.: 0x%04X\n",tReg,hReg);
+
+        // convert
+        sht2int_double(tReg,hReg,&tVal,&hVal);
+        // show result
+        printf("\nTemp(int): %d; Hum(int): %d\n",tVal,hVal);
+        // test int2bcd function
+        printf("Temp(bcd): %X; Hum(bcd): %X\n",int2bcd(tVal),int2bcd(hVal));
+        return 0;
+    }
+
+    printf("Converting all 2^26 combinations ...\n");
+    sweep("double",sht2int_double);
+    double cFloat = sweep("float",sht2int_float);
+    double cFixed = sweep("fixed",sht2int_fixed);
+    double cTable = sweep("table",sht2int_table);
+    printf("table engine flash cost: %d bytes of tables\n",
+           (int)(sizeof(sht_ttab)+sizeof(sht_rtab)+sizeof(sht_ctab)));
+    printf("table engine host cycles per conversion: %+.1f vs float, %+.1f vs fixed (x86, not the target)\n",
+           cTable-cFloat,cTable-cFixed);
+    printf("  (MSP430: compare 'p' SHT2INT mean of -DSHT_PROF builds with -DSHT_CONV=2 and default)\n");
+    split_test();
+    sweep_batch();
+    bcd_test();
+    dew_test();
+    batch_log(1<<24);
+
+    printf("Converting all 2^20 low resolution combinations ...\n");
+    sweep_range("float",sht2int_float_lowres,sht2int_double_lowres,4096,256);
+    sweep_range("fixed",sht2int_fixed_lowres,sht2int_double_lowres,4096,256);
     return 0;
 }
@@ -0,0 +1,140 @@
+/*
+ * sht11.c crc test - streaming crc against datasheet bitwise crc, throughput (host build, SHT_HOST)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <inttypes.h>
+
+#include "../../sht11.h"
+
+// cpu cycle counter (x86 hosts only)
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define CYCLES() __rdtsc()
+#else
+#define CYCLES() 0
+#endif
+
+/// bit reverse
+uint8_t rev8(uint8_t b)
+{
+    uint8_t r=0, i;
+    for (i=0;i<8;i++) { r=(r<<1)|(b&1); b>>=1; }
+    return r;
+}
+
+/// datasheet crc (bitwise, init by reversed status nibble, result reversed) - used as muster value
+uint8_t crc_bitwise(uint8_t status, const uint8_t *data, uint8_t len)
+{
+    uint8_t c = rev8(status&0x0F);
+    uint8_t i;
+    while (len--)
+    {
+        c ^= *data++;
+        for (i=0;i<8;i++) c = (c&0x80)?((c<<1)^0x31):(c<<1);
+    }
+    return rev8(c);
+}
+
+/// previous implementation (normal domain lookup table, reverse loop at the end)
+uint8_t crc_lut_old[256];
+
+uint8_t crc_old(uint8_t status, const uint8_t *data, uint8_t len)
+{
+    uint8_t crc, ret = 0, i;
+    crc = ((status&0x01)<<7)|((status&0x02)<<5)|((status&0x04)<<3)|((status&0x08)<<1);
+    for (i=len;i!=0;i--)
+    {
+        crc ^= *data++;
+        crc = crc_lut_old[crc];
+    }
+    ret |= crc&0x01;
+    for (i=7;i!=0;i--)
+    {
+        ret<<=1;
+        crc>>=1;
+        ret |= crc&0x01;
+    }
+    return ret;
+}
+
+/// streaming, bytes collected bit reversed (as sht_read_byte does)
+uint8_t crc_stream_rev(uint8_t status, const uint8_t *rdata, uint8_t len)
+{
+    sht_crc_t ctx;
+    sht_crc_init(&ctx,status);
+    while (len--) sht_crc_update_rev(&ctx,*rdata++);
+    return sht_crc_final(&ctx);
+}
+
+/// streaming, plain bytes (sht_crc_status)
+uint8_t crc_stream(uint8_t status, const uint8_t *data, uint8_t len)
+{
+    return sht_crc_status(status,(unsigned char*)data,len);
+}
+
+/// run crc function over whole buffer in 3 byte frames, returns cycles per frame
+typedef uint8_t (*crc_fn_t)(uint8_t status, const uint8_t *data, uint8_t len);
+
+double bench(const char *name, crc_fn_t fn, const uint8_t *buf, uint32_t frames)
+{
+    uint32_t i;
+    volatile uint8_t sink = 0;
+    uint64_t cyc = CYCLES();
+    for (i=0;i<frames;i++) sink ^= fn(i&0x0F,&buf[i*3],3);
+    cyc = CYCLES() - cyc;
+    (void)sink;
+    double cpf = (double)cyc/frames;
+    printf("%-28s %8.2f cycles/frame\n",name,cpf);
+    return cpf;
+}
+
+#define FRAMES 1000000UL
+
+int main(void)
+{
+    uint32_t i, errors = 0;
+    uint16_t n;
+    uint8_t st, data[3], rdata[3];
+
+    // old table (normal domain)
+    for (n=0;n<256;n++)
+    {
+        uint8_t c = n;
+        for (i=0;i<8;i++) c = (c&0x80)?((c<<1)^0x31):(c<<1);
+        crc_lut_old[n] = c;
+    }
+
+    // exhaustive: every status nibble, every command and 16bit value (3 byte frames)
+    for (st=0;st<16;st++)
+    {
+        static const uint8_t cmds[] = {MEASURE_TEMP,MEASURE_HUMI,STATUS_REG_R};
+        for (i=0;i<3*0x10000UL;i++)
+        {
+            data[0] = cmds[i>>16]; data[1] = i>>8; data[2] = i;
+            rdata[0] = rev8(data[0]); rdata[1] = rev8(data[1]); rdata[2] = rev8(data[2]);
+            uint8_t ref = crc_bitwise(st,data,3);
+            if (sht_crc_status(st,data,3)!=ref) errors++;
+            if (crc_stream_rev(st,rdata,3)!=ref) errors++;
+            if (crc_old(st,data,3)!=ref) errors++;
+            // 2 byte frames (status register read)
+            if (sht_crc_status(st,data,2)!=crc_bitwise(st,data,2)) errors++;
+        }
+    }
+    printf("crc errors: %u\n",(unsigned)errors);
+
+    // throughput
+    uint8_t *buf = malloc(FRAMES*3);
+    if (!buf) return 1;
+    srand(1);
+    for (i=0;i<FRAMES*3;i++) buf[i] = rand();
+    double c_bit = bench("bitwise (datasheet)",crc_bitwise,buf,FRAMES);
+    double c_old = bench("lut + reverse loop (old)",crc_old,buf,FRAMES);
+    double c_new = bench("streaming (sht_crc_status)",crc_stream,buf,FRAMES);
+    bench("streaming, reversed bytes",crc_stream_rev,buf,FRAMES); // one call per byte
+    if (c_new>0) printf("speedup vs old %.2fx, vs bitwise %.2fx\n",c_old/c_new,c_bit/c_new);
+    free(buf);
+
+    return (errors!=0);
+}
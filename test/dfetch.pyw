@@ -5,26 +5,26 @@ from idlelib import ToolTip #hint bubbles
 from serial import Serial #serial communication
 from threading import Thread #threading
 from math import log #temperature computation
-from time import sleep #wait for recovery (when comm error)
+from time import sleep, time #wait for recovery (when comm error), stream timeout
+import shtproto #binary framed protocol
 
 #Port settings
 PortName    = 'COM6'
 PortSpeed   = 9600
 PortTimeout = 0.25
-StrQuestion = '?'
 
 MAX_RX_ERRORS = 3
+STREAM_TIMEOUT = 12 #s (device streams a sample every 5s)
 
 class thrDataFetch(Thread):
     ''' analog sensor data fetching thread '''
 
-    def __init__(self,port,speed,timeout,qstr,outf,stopf):
+    def __init__(self,port,speed,timeout,outf,stopf):
         Thread.__init__(self)
         #store input args and functions
         self.portName=port
         self.portSpeed=speed
         self.portTimeout=timeout
-        self.requestStr=qstr
         self.outFunction=outf
         #stop flag
         self.stopFlag = False
@@ -41,22 +41,33 @@ class thrDataFetch(Thread):
         try:
             with Serial(self.portName,self.portSpeed,bytesize=8, parity='N', stopbits=1, timeout=self.portTimeout, xonxoff=0, rtscts=0) as port:
                 stopreason='stopped normally'
+                parser = shtproto.Parser()
+                seq = 0
+                #subscribe (every sample pushed) and poll current values
+                port.write(shtproto.command_stream(seq,1)+shtproto.command_poll(seq+1))
+                lastRx = time()
                 while (self.stopFlag==False):
                     try:
-                        port.write(self.requestStr.encode('ascii'))
-                        answ = port.readlines()
-                        results = answ[-1].strip().decode('ascii')
-                        results = results.split(',')
-                        self.outFunction(results)
-                        #print(results)
-                        self.rxErrCount=0
+                        for f in parser.feed(port.read(port.in_waiting or 1)):
+                            results = shtproto.samples(f)
+                            if len(results)>0:
+                                self.outFunction(results[-1])
+                            lastRx = time()
+                            self.rxErrCount=0
                     except:
                         self.rxErrCount+=1
+                    #nothing received .. subscribe again
+                    if (time()-lastRx)>STREAM_TIMEOUT:
+                        self.rxErrCount+=1
+                        seq = (seq+2)&0xFF
+                        port.write(shtproto.command_stream(seq,1)+shtproto.command_poll(seq+1))
+                        lastRx = time()
                     #test comm errors
                     if self.rxErrCount>=MAX_RX_ERRORS:
                         stopreason='data receiving errors'
                         break
-                    
+
+                port.write(shtproto.command_stream(seq+2,0)) #stop stream
                 port.close()
                 self.stopFunction(stopreason)
         except:
@@ -203,7 +214,7 @@ class runapp_gui(Frame):
             self.btnConnect.config(relief=RAISED,state=DISABLED)
         else:
             #connect
-            self.snsThread = thrDataFetch(self.portName,PortSpeed,PortTimeout,StrQuestion,
+            self.snsThread = thrDataFetch(self.portName,PortSpeed,PortTimeout,
                                           self.showData,self.onStopComm)
             self.snsThread.start()
             self.boolConnected = True
@@ -212,17 +223,15 @@ class runapp_gui(Frame):
 
     def showData(self,result):
         '''this is called by serial thread when some data fetched from sensor
-        - function gets fetched data in list form '''
+        - function gets fetched data in list form (T and RH * 10) '''
 
         try:
             if len(result)>=2:
                 #show result
                 try:
-                    r0 = int(result[0],10)/10
-                    if r0>=800:
-                        r0=-(r0-800)
+                    r0 = result[0]/10
                     self.strTemp.set('{}'.format(r0))
-                    r1 = int(result[1],10)/10
+                    r1 = result[1]/10
                     self.strHumi.set('{}'.format(r1))
                 except:
                     pass
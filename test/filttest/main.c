@@ -0,0 +1,210 @@
+/*
+ * filt.c test - median, EMA and publish rules, and benchmark of samples sent and
+ * error against every noisy sample sent, on a day long trace with outliers
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <inttypes.h>
+
+#include "../../filt.h"
+
+/// test counters
+int tests = 0, failed = 0;
+
+#define CHECK(cond) check((cond),#cond,__LINE__)
+
+void check(int ok, const char *what, int line)
+{
+    tests++;
+    if (ok) return;
+    failed++;
+    printf("FAILED (line %d): %s\n",line,what);
+}
+
+/// one sample, returns publish flag (filtered values to *ft, *fh)
+unsigned char add(unsigned int t, unsigned int h, unsigned char res, unsigned int *ft, unsigned int *fh)
+{
+    *ft = t;
+    *fh = h;
+    return filt_add(ft,fh,res);
+}
+
+/// filter rules
+void rules(void)
+{
+    const filt_cfg_t off = {1,0,0,0,0}, med = {3,0,0,0,0}, ema = {1,2,0,0,0}, def = {FILT_MEDIAN,FILT_SHIFT,FILT_T_THR,FILT_H_THR,FILT_HOLD};
+    unsigned int t, h, i, n;
+
+    // everything off .. values passed, published on any change
+    filt_init(&off);
+    CHECK(add(6000,1500,0,&t,&h) && (t==6000) && (h==1500));
+    CHECK(!add(6000,1500,0,&t,&h));
+    CHECK(add(6001,1500,0,&t,&h) && (t==6001));
+    CHECK(add(6001,1499,0,&t,&h) && (h==1499));
+
+    // median of 3 .. single outlier rejected, step passes after 2 samples
+    filt_init(&med);
+    add(6000,1500,0,&t,&h);
+    add(6002,1502,0,&t,&h);
+    add(9000,100,0,&t,&h);
+    CHECK((t==6002)&&(h==1500));
+    add(6001,1501,0,&t,&h);
+    CHECK((t==6002)&&(h==1501));
+    add(6002,1501,0,&t,&h); // outlier out of window
+    add(7000,2000,0,&t,&h);
+    CHECK(t==6002);
+    add(7000,2000,0,&t,&h);
+    CHECK((t==7000)&&(h==2000));
+
+    // EMA 1/4 .. first sample taken as is, step of 400 reaches 3/4 after ~5 samples, exact
+    // in the end (rounded, no offset)
+    filt_init(&ema);
+    add(6000,1000,0,&t,&h);
+    CHECK((t==6000)&&(h==1000));
+    add(6400,1400,0,&t,&h);
+    CHECK((t==6100)&&(h==1100));
+    for (i=0;i<4;i++) add(6400,1400,0,&t,&h);
+    CHECK((t>=6300)&&(t<6400));
+    for (i=0;i<60;i++) add(6400,1400,0,&t,&h);
+    CHECK((t==6400)&&(h==1400));
+    for (i=0;i<60;i++) add(6000,1000,0,&t,&h);
+    CHECK((t==6000)&&(h==1000));
+    // max. shift, max. register values (accumulator range)
+    {
+        const filt_cfg_t big = {FILT_MEDIAN_MAX,8,0,0,0};
+        filt_init(&big);
+        for (i=0;i<6000;i++) add(0x3fff,0x0fff,0,&t,&h); // time constant 256 samples
+        CHECK((t==0x3fff)&&(h==0x0fff));
+        for (i=0;i<6000;i++) add(0,0,0,&t,&h);
+        CHECK((t==0)&&(h==0));
+    }
+
+    // thresholds (more than) and hold
+    filt_init(&def);
+    CHECK(add(6000,1500,0,&t,&h));
+    for (n=i=0;i<FILT_HOLD;i++) n += add(6000+(i&1),1500+(i&1),0,&t,&h); // noise
+    CHECK(n==0);
+    CHECK(add(6000,1500,0,&t,&h)); // hold
+    for (n=i=0;i<20;i++) n += add(6000+FILT_T_THR,1500,0,&t,&h); // at threshold
+    CHECK(n==1); // hold only
+    for (n=i=0;i<3;i++) n += add(6000+4*FILT_T_THR,1500,0,&t,&h);
+    CHECK((n==1)&&(t>6000+FILT_T_THR)&&(t<6000+4*FILT_T_THR)); // the first value over threshold
+    for (n=i=0;i<3;i++) n += add(6000+4*FILT_T_THR,1500+4*FILT_H_THR,0,&t,&h);
+    CHECK(n==1);
+
+    // jump of more than FILT_STEP thresholds (T) .. EMA restarts, step followed as soon as
+    // median passes it, jump of exactly FILT_STEP thresholds (RH) .. averaged
+    filt_init(&def);
+    for (i=0;i<20;i++) add(6000,1500,0,&t,&h);
+    add(6000+FILT_STEP*FILT_T_THR+1,1500+FILT_STEP*FILT_H_THR,0,&t,&h);
+    CHECK((t==6000)&&(h==1500));
+    add(6000+FILT_STEP*FILT_T_THR+1,1500+FILT_STEP*FILT_H_THR,0,&t,&h);
+    CHECK((t==6000+FILT_STEP*FILT_T_THR+1)&&(h==1500+((FILT_STEP*FILT_H_THR)>>FILT_SHIFT)));
+
+    // low resolution .. restart on resolution change, thresholds scaled (1 LSB T = 4 LSB)
+    CHECK(add(1500,100,1,&t,&h) && (t==1500) && (h==100));
+    for (n=i=0;i<10;i++) n += add(1501,100,1,&t,&h);
+    CHECK(n==0);
+    for (n=i=0;i<10;i++) n += add(1502,100,1,&t,&h);
+    CHECK(n==1);
+    CHECK(add(6000,1500,0,&t,&h) && (t==6000));
+}
+
+/** day trace benchmark */
+
+/// samples per day (5s)
+#define DAY 17280
+
+static double noise(void)
+{
+    return ((rand()&0xffff)+(rand()&0xffff)+(rand()&0xffff)-3*32767.5)/32768.0; // approx. gauss, sigma 1
+}
+
+/// true registers at sample i (daily cycle, window opened twice, shower)
+static void trace(int i, double *t, double *h)
+{
+    double x = (double)i/DAY, T, RH;
+    T = 21+2.5*sin(2*M_PI*(x-0.3));
+    RH = 45-8*sin(2*M_PI*(x-0.3));
+    if (((i>5000)&&(i<5120))||((i>12000)&&(i<12060))) { T -= 3; RH -= 10; } // window
+    if ((i>8000)&&(i<8200)) RH += 30*exp(-(i-8000)/60.0); // shower
+    *t = (T+39.7)/0.01;
+    *h = (RH+2.0468)/0.0367;
+}
+
+/// frame bytes per stream sample (one sample per frame, proto.h)
+#define FRAME_BYTES (5+2+4)
+
+/// one configuration (NULL .. no filter), rms errors to *rt, *rh
+static void run(const char *name, const filt_cfg_t *cfg, double *rt, double *rh)
+{
+    unsigned int t, h, pt = 0, ph = 0, sent = 0, spikes = 0;
+    double et = 0, eh = 0, mt = 0, mh = 0, pt_true = 0, ph_true = 0;
+    int quiet = 0; // samples since last jump of true values
+    int i;
+
+    srand(1);
+    if (cfg) filt_init(cfg);
+    for (i=0;i<DAY;i++)
+    {
+        double tt, th, dt, dh;
+        trace(i,&tt,&th);
+        quiet = ((fabs(tt-pt_true)>10)||(fabs(th-ph_true)>10))?0:quiet+1;
+        pt_true = tt; ph_true = th;
+        t = (unsigned int)(tt+3*noise()+0.5);
+        h = (unsigned int)(th+3*noise()+0.5);
+        if (rand()%500==0) t += 300; // outliers (disturbed readout)
+        if (rand()%500==0) h -= 200;
+        if (!cfg || filt_add(&t,&h,0)) // host holds the last sample it got
+        {
+            pt = t; ph = h;
+            sent++;
+            // outlier sent (off by more than 0.5 C / 1.8 %, not a step being followed)
+            if ((quiet>=64)&&((fabs(t-tt)>50)||(fabs(h-th)>50))) spikes++;
+        }
+        dt = fabs(pt-tt)*0.01;
+        dh = fabs(ph-th)*0.0367;
+        et += dt*dt; eh += dh*dh;
+        if (dt>mt) mt = dt;
+        if (dh>mh) mh = dh;
+    }
+    printf("%-26s %7u %6.1f%% %9u %6u %8.3f %8.2f %8.3f %8.2f\n",name,sent,100.0*sent/DAY,sent*FRAME_BYTES,
+           spikes,sqrt(et/DAY),mt,sqrt(eh/DAY),mh);
+    *rt = sqrt(et/DAY);
+    *rh = sqrt(eh/DAY);
+    if (cfg) CHECK(sent<DAY/4);
+    if (cfg && (cfg->median>1)) CHECK(spikes==0);
+}
+
+void benchmark(void)
+{
+    const filt_cfg_t med = {FILT_MEDIAN,0,FILT_T_THR,FILT_H_THR,FILT_HOLD},
+                     ema = {1,FILT_SHIFT,FILT_T_THR,FILT_H_THR,FILT_HOLD},
+                     def = {FILT_MEDIAN,FILT_SHIFT,FILT_T_THR,FILT_H_THR,FILT_HOLD},
+                     smooth = {5,3,FILT_T_THR,FILT_H_THR,FILT_HOLD},
+                     coarse = {FILT_MEDIAN,FILT_SHIFT,10,27,60};
+
+    printf("day at 5s (%d samples), noise 3 LSB, 1/500 outliers; error of last sample host got\n",DAY);
+    printf("(max. error is a step delayed by median/EMA or the hold of threshold)\n");
+    printf("%-26s %7s %7s %9s %6s %8s %8s %8s %8s\n","","samples","","bytes","spikes","T rms C","T max","RH rms %","RH max");
+    double t0, h0, t, h;
+
+    run("all samples, no filter",NULL,&t0,&h0);
+    run("median 3 only",&med,&t,&h);
+    run("EMA 1/4 only",&ema,&t,&h);
+    run("median 3 + EMA 1/4 (def.)",&def,&t,&h);
+    CHECK((t<=t0)&&(h<=h0)); // fewer samples, none of them worse than every sample sent
+    run("median 5 + EMA 1/8",&smooth,&t,&h); // median 5 lags 2 samples behind steps (RH worse)
+    run("def., thr. 0.1 C 1 %, 5min",&coarse,&t,&h);
+    CHECK((t<=t0)&&(h<=h0));
+}
+
+int main(void)
+{
+    rules();
+    benchmark();
+    printf("%d tests, %d failed\n",tests,failed);
+    return (failed!=0);
+}
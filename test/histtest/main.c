@@ -0,0 +1,183 @@
+/*
+ * history.c test - dump decoding, segment rotation, wear and capacity (host build, SHT_HOST)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include "../../history.h"
+
+/// simulated flash (history.c)
+extern unsigned char hist_flash[];
+extern unsigned int hist_erases[];
+
+/// test counters
+int tests = 0, failed = 0;
+
+#define CHECK(cond) check((cond),#cond,__LINE__)
+
+void check(int ok, const char *what, int line)
+{
+    tests++;
+    if (ok) return;
+    failed++;
+    printf("FAILED (line %d): %s\n",line,what);
+}
+
+/// samples given to hist_add (all and decimated)
+#define MAXS 100000
+uint16_t st[MAXS], sh[MAXS], dt[MAXS], dh[MAXS];
+int ns = 0, nd = 0;
+
+/// random walk sample (slowly changing T and RH register values, 14bit and 12bit)
+void add_sample(int step)
+{
+    static int t = 6470, h = 1500;
+    t += (rand()%(2*step+1))-step; if (t<0) t=0; if (t>0x3FFF) t=0x3FFF;
+    h += (rand()%(2*step+1))-step; if (h<0) h=0; if (h>0x0FFF) h=0x0FFF;
+    st[ns] = t; sh[ns] = h;
+    if ((ns%HIST_DECIM)==0) { dt[nd] = t; dh[nd] = h; nd++; }
+    ns++;
+    hist_add(t,h,0);
+}
+
+/// decoded dump
+uint16_t bt[MAXS], bh[MAXS], rt[HIST_RING_LEN], rh[HIST_RING_LEN];
+int nb, nr, blocks, dump_chars;
+
+/// hex digit
+int hex(char c)
+{
+    return (c<='9') ? (c-'0') : (c-'A'+10);
+}
+
+/// varint, zigzag decode
+int varint(const uint8_t *p, int *pos)
+{
+    uint16_t z = 0;
+    int shift = 0;
+    uint8_t b;
+    do {
+        b = p[(*pos)++];
+        z |= (uint16_t)(b&0x7F)<<shift;
+        shift += 7;
+    } while (b&0x80);
+    return (int16_t)((z>>1)^(-(z&1)));
+}
+
+/// read whole dump and decode it (returns 0 if format ok)
+int dump(void)
+{
+    static char line[2*HIST_SEG_SIZE+8];
+    uint8_t blk[HIST_SEG_SIZE];
+    int c, len = 0, i, err = 0;
+
+    nb = nr = blocks = dump_chars = 0;
+    if (hist_dump_start()!=0) return 1;
+    while ((c=hist_dump_getc())>=0)
+    {
+        dump_chars++;
+        if (c!='\n') { if (len<(int)sizeof(line)-1) line[len++] = c; continue; }
+        line[len] = 0;
+        if (line[0]=='B')
+        {
+            int n = (len-1)/2, pos = HIST_HDR_LEN;
+            for (i=0;i<n;i++) blk[i] = (hex(line[1+2*i])<<4)|hex(line[2+2*i]);
+            if (n<HIST_HDR_LEN) { err++; len = 0; continue; }
+            bt[nb] = blk[4]|(blk[5]<<8);
+            bh[nb] = blk[6]|(blk[7]<<8);
+            nb++;
+            for (i=1;i<blk[2];i++)
+            {
+                bt[nb] = bt[nb-1]+varint(blk,&pos);
+                bh[nb] = bh[nb-1]+varint(blk,&pos);
+                nb++;
+            }
+            if (pos!=n) err++;
+            blocks++;
+        }
+        else if (line[0]=='R')
+        {
+            rt[nr] = (hex(line[1])<<12)|(hex(line[2])<<8)|(hex(line[3])<<4)|hex(line[4]);
+            rh[nr] = (hex(line[5])<<12)|(hex(line[6])<<8)|(hex(line[7])<<4)|hex(line[8]);
+            nr++;
+        }
+        else if (line[0]!='E') err++;
+        len = 0;
+    }
+    return err;
+}
+
+/// dumped blocks hold the newest decimated samples, ring holds the newest samples
+void check_dump(void)
+{
+    int i, ok = 1;
+    CHECK(dump()==0);
+    CHECK(nb<=nd);
+    for (i=0;i<nb;i++) if ((bt[i]!=dt[nd-nb+i])||(bh[i]!=dh[nd-nb+i])) ok = 0;
+    CHECK(ok);
+    CHECK(nr==((ns<HIST_RING_LEN)?ns:HIST_RING_LEN));
+    for (i=0;i<nr;i++) if ((rt[i]!=st[ns-nr+i])||(rh[i]!=sh[ns-nr+i])) ok = 0;
+    CHECK(ok);
+}
+
+int main(void)
+{
+    int i;
+
+    // empty flash
+    memset(hist_flash,0xFF,HIST_SEG_COUNT*HIST_SEG_SIZE);
+    hist_init();
+    CHECK(dump()==0);
+    CHECK((nb==0)&&(nr==0)&&(blocks==0));
+
+    // few samples (open block only)
+    for (i=0;i<30;i++) add_sample(2);
+    check_dump();
+    CHECK(blocks==1);
+
+    // all segments used
+    for (i=0;i<5000;i++) add_sample(2);
+    check_dump();
+    CHECK(blocks==HIST_SEG_COUNT+1);
+
+    // dump already running
+    CHECK(hist_dump_start()==0);
+    CHECK(hist_dump_start()!=0);
+    while (hist_dump_getc()>=0);
+
+    // reboot (RAM lost, blocks in flash stay, rotation continues)
+    hist_init();
+    for (i=0;i<HIST_DECIM*60;i++) add_sample(2);
+    CHECK(dump()==0);
+    CHECK(blocks>=HIST_SEG_COUNT);
+
+    // wear (segments erased equally)
+    unsigned int emin = 0xFFFF, emax = 0;
+    for (i=0;i<HIST_SEG_COUNT;i++)
+    {
+        if (hist_erases[i]<emin) emin = hist_erases[i];
+        if (hist_erases[i]>emax) emax = hist_erases[i];
+    }
+    CHECK(emax-emin<=1);
+
+    // capacity (slow signal, step 2 and noisy signal, step 40)
+    for (i=0;i<2;i++)
+    {
+        int step = (i==0) ? 2 : 40, k;
+        memset(hist_flash,0xFF,HIST_SEG_COUNT*HIST_SEG_SIZE);
+        hist_init();
+        for (k=0;k<HIST_DECIM*1000;k++) add_sample(step);
+        dump();
+        double per_block = (double)(nb-1)/HIST_SEG_COUNT; // approx, without open block
+        printf("step %2d: %5.1f samples per %d byte block (raw %d), %.2f h history at 5s/%d\n",
+               step,per_block,HIST_SEG_SIZE,(HIST_SEG_SIZE-HIST_HDR_LEN)/4+1,
+               (double)nb*HIST_DECIM*5.0/3600.0,HIST_DECIM);
+    }
+    printf("dump: %d chars (%.2f s at 9600 baud)\n",dump_chars,dump_chars*10.0/9600.0);
+
+    printf("%d tests, %d failed\n",tests,failed);
+    return (failed!=0);
+}
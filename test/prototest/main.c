@@ -0,0 +1,241 @@
+/*
+ * proto.c test - framing, crc, commands, streaming, link efficiency (host build, SHT_HOST)
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include "../../uart.h"
+#include "../../proto.h"
+
+/// test counters
+int tests = 0, failed = 0;
+
+#define CHECK(cond) check((cond),#cond,__LINE__)
+
+void check(int ok, const char *what, int line)
+{
+    tests++;
+    if (ok) return;
+    failed++;
+    printf("FAILED (line %d): %s\n",line,what);
+}
+
+/// uart stub (tx source is drained by test, busy flag simulates other source running,
+/// 2 also other one waiting)
+uart_source_t source = 0, waiting = 0;
+int uart_busy = 0;
+
+int uart_send_source(uart_source_t src)
+{
+    if (source||uart_busy) return -1;
+    source = src;
+    return 0;
+}
+
+int uart_queue_source(uart_source_t src)
+{
+    if (uart_busy>1) return -1;
+    if (source||uart_busy)
+    {
+        if (waiting) return -1;
+        waiting = src;
+        return 0;
+    }
+    return uart_send_source(src);
+}
+
+/// other source finished (waiting one starts)
+void uart_idle(void)
+{
+    uart_busy = 0;
+    source = waiting;
+    waiting = 0;
+}
+
+/// line (bytes sent by device)
+uint8_t line[1024];
+int line_len = 0;
+
+void drain(void)
+{
+    int c;
+    line_len = 0;
+    while (source && ((c=source())>=0)) line[line_len++] = c;
+    source = 0;
+}
+
+/// datasheet crc-8 (x^8+x^5+x^4+1, MSB first, start 0, result bit reversed) - used as muster value
+uint8_t crc8(const uint8_t *data, int len)
+{
+    uint8_t c = 0, r = 0;
+    int i;
+    while (len--)
+    {
+        c ^= *data++;
+        for (i=0;i<8;i++) c = (c&0x80)?((c<<1)^0x31):(c<<1);
+    }
+    for (i=0;i<8;i++) { r=(r<<1)|(c&1); c>>=1; }
+    return r;
+}
+
+/// send command frame to device
+void command(uint8_t type, uint8_t seq, const uint8_t *payload, uint8_t len, int corrupt)
+{
+    uint8_t f[16];
+    int i;
+    f[0] = PROTO_SYNC; f[1] = type; f[2] = seq; f[3] = len;
+    memcpy(&f[4],payload,len);
+    f[4+len] = crc8(&f[1],3+len) ^ (corrupt?1:0);
+    for (i=0;i<len+5;i++) proto_rx(f[i]);
+}
+
+/// parsed frame
+typedef struct {
+    uint8_t type, seq, len;
+    uint8_t payload[64];
+} frame_t;
+
+/// parse frames from line (returns count, -1 framing/crc error)
+int parse(frame_t *fr, int max)
+{
+    int pos = 0, n = 0;
+    while ((pos<line_len)&&(n<max))
+    {
+        if (line[pos]!=PROTO_SYNC) return -1;
+        if (pos+5>line_len) return -1;
+        uint8_t len = line[pos+3];
+        if (pos+len+5>line_len) return -1;
+        if (crc8(&line[pos+1],len+3)!=line[pos+4+len]) return -1;
+        fr[n].type = line[pos+1];
+        fr[n].seq = line[pos+2];
+        fr[n].len = len;
+        memcpy(fr[n].payload,&line[pos+4],len);
+        n++;
+        pos += len+5;
+    }
+    return n;
+}
+
+int16_t value(const frame_t *f, int sample, int ch)
+{
+    const uint8_t *p = &f->payload[2+(sample*PROTO_CHANNELS+ch)*2];
+    return (int16_t)(p[0]|(p[1]<<8));
+}
+
+int main(void)
+{
+    frame_t fr[8];
+    uint8_t n;
+    int i;
+
+    // chars out of frame go to uart module ('?' ascii poll)
+    CHECK(proto_rx('?')==0);
+
+    // poll (last sample)
+    proto_sample(-158,456);
+    command(PROTO_CMD_POLL,1,0,0,0);
+    drain();
+    CHECK(parse(fr,8)==1);
+    CHECK((fr[0].type==PROTO_DATA)&&(fr[0].payload[0]==1)&&(fr[0].payload[1]==PROTO_CHANNELS));
+    CHECK((value(&fr[0],0,0)==-158)&&(value(&fr[0],0,1)==456));
+    printf("poll answer:");
+    for (i=0;i<line_len;i++) printf(" %02X",line[i]);
+    printf("\n");
+
+    // corrupted command is ignored
+    command(PROTO_CMD_POLL,2,0,0,1);
+    drain();
+    CHECK(line_len==0);
+
+    // stream, 4 samples per frame
+    n = 4;
+    command(PROTO_CMD_STREAM,3,&n,1,0);
+    drain();
+    CHECK(parse(fr,8)==1);
+    CHECK((fr[0].type==PROTO_ACK)&&(fr[0].payload[0]==3)&&(fr[0].payload[1]==0));
+    uint8_t seq = fr[0].seq;
+    for (i=0;i<8;i++)
+    {
+        proto_sample(200+i,500+i);
+        if ((i%4)!=3) { CHECK(source==0); continue; } // nothing until frame is full
+        drain();
+        CHECK(parse(fr,8)==1);
+        CHECK((fr[0].type==PROTO_DATA)&&(fr[0].payload[0]==4));
+        CHECK(fr[0].seq==(uint8_t)(seq+1+i/4)); // no gap
+        CHECK((value(&fr[0],0,0)==197+i)&&(value(&fr[0],3,1)==500+i));
+    }
+
+    // answer queued behind frame being sent
+    for (i=0;i<4;i++) proto_sample(300+i,600+i);
+    CHECK(source!=0);
+    source(); // first byte of data frame sent
+    command(PROTO_CMD_POLL,4,0,0,0);
+    line_len = 0;
+    line[line_len++] = PROTO_SYNC;
+    while ((i=source())>=0) line[line_len++] = i;
+    source = 0;
+    CHECK(parse(fr,8)==2);
+    CHECK((fr[0].payload[0]==4)&&(fr[1].payload[0]==1)&&(value(&fr[1],0,0)==303));
+
+    // partial frame flushed by transmit task, nothing to flush then
+    proto_sample(400,700);
+    proto_sample(401,701);
+    CHECK(source==0);
+    proto_flush();
+    drain();
+    CHECK((parse(fr,8)==1)&&(fr[0].payload[0]==2)&&(value(&fr[0],1,0)==401));
+    proto_flush();
+    CHECK(source==0);
+
+    // bad command
+    n = PROTO_MAX_SAMPLES+1;
+    command(PROTO_CMD_STREAM,5,&n,1,0);
+    drain();
+    CHECK((parse(fr,8)==1)&&(fr[0].type==PROTO_ACK)&&(fr[0].payload[1]==1));
+
+    // uart used by other source (history dump) .. frames wait for it
+    uart_busy = 1;
+    unsigned int drops = proto_drops();
+    for (i=0;i<4;i++) proto_sample(500+i,800);
+    command(PROTO_CMD_POLL,6,0,0,0);
+    CHECK((source==0)&&(waiting!=0));
+    uart_idle();
+    drain();
+    CHECK(parse(fr,8)==2); // poll answer goes first
+    CHECK((fr[0].type==PROTO_DATA)&&(fr[0].payload[0]==1)&&(value(&fr[0],0,0)==503));
+    CHECK((fr[1].type==PROTO_DATA)&&(fr[1].payload[0]==4)&&(value(&fr[1],3,0)==503));
+    CHECK(proto_drops()==drops);
+
+    // uart can't take frame (other source waiting) .. stream data dropped, answers kept
+    uart_busy = 2;
+    for (i=0;i<4;i++) proto_sample(0,0);
+    CHECK(proto_drops()==drops+1);
+    command(PROTO_CMD_POLL,7,0,0,0);
+    n = 1;
+    command(PROTO_CMD_STREAM,8,&n,1,0);
+    CHECK(source==0);
+    uart_busy = 0;
+    proto_flush(); // retried by transmit task
+    drain();
+    CHECK(parse(fr,8)==2);
+    CHECK((fr[0].type==PROTO_ACK)&&(fr[0].payload[0]==8)&&(fr[0].payload[1]==0));
+    CHECK((fr[1].type==PROTO_DATA)&&(fr[1].payload[0]==1)&&(value(&fr[1],0,0)==0));
+    CHECK(proto_drops()==drops+1);
+    n = 0;
+    command(PROTO_CMD_STREAM,9,&n,1,0);
+    drain();
+
+    // link efficiency (bytes per sample: ascii poll vs binary stream)
+    printf("ascii poll: %d bytes/sample (1 request + 10 answer, round trip per sample)\n",1+5*PROTO_CHANNELS);
+    for (n=1;n<=PROTO_MAX_SAMPLES;n++)
+    {
+        int bytes = PROTO_OVERHEAD+2+n*PROTO_CHANNELS*2;
+        printf("stream %d samples/frame: %.2f bytes/sample (%.1fx)\n",n,(double)bytes/n,
+               (double)(1+5*PROTO_CHANNELS)*n/bytes);
+    }
+
+    printf("%d tests, %d failed\n",tests,failed);
+    return (failed!=0);
+}
@@ -0,0 +1,239 @@
+/*
+ * timer.c test - scheduler periods, 16 bit wrap, runtime period change, overruns
+ * and average current budget per configuration (host build, SHT_HOST)
+ */
+
+#include <stdio.h>
+#include <inttypes.h>
+
+#include "../../timer.h"
+#include "../../sht11.h"
+#include "../shtsim/shtsim.h"
+
+/// scheduler internals (timer.c)
+extern volatile unsigned char sched_pending;
+void Timer_A(void);
+void Timer_A1(void);
+
+/// test counters
+int tests = 0, failed = 0;
+
+#define CHECK(cond) check((cond),#cond,__LINE__)
+
+void check(int ok, const char *what, int line)
+{
+    tests++;
+    if (ok) return;
+    failed++;
+    printf("FAILED (line %d): %s\n",line,what);
+}
+
+/// simulated Timer0_A (ticks, CCR0, interrupt flags) and interrupt counters
+uint64_t sim_t = 0;
+uint16_t sim_ccr0 = 0;
+int sim_ccifg = 0, sim_taifg = 0;
+unsigned long isr_alarm = 0, isr_ovf = 0, wakeups = 0;
+
+uint16_t timer_host_tar(void) { return (uint16_t)sim_t; }
+void timer_host_alarm(uint16_t t) { sim_ccr0 = t; }
+void timer_host_alarm_now(void) { sim_ccifg = 1; }
+unsigned char timer_host_ovf(void) { return sim_taifg; }
+unsigned int timer_host_iv(void) { if (!sim_taifg) return 0; sim_taifg = 0; return 0x0A; }
+
+/// next timer event (compare match or overflow)
+uint64_t sim_next(void)
+{
+    uint64_t ovf = (sim_t|0xFFFF)+1;
+    uint64_t match = (sim_t&~(uint64_t)0xFFFF)|sim_ccr0;
+    if (match<=sim_t) match += 0x10000;
+    return (match<ovf) ? match : ovf;
+}
+
+/// service pending interrupts (CCR0 has priority)
+void sim_isr(void)
+{
+    while (sim_ccifg||sim_taifg)
+    {
+        if (sim_ccifg) { sim_ccifg = 0; isr_alarm++; Timer_A(); }
+        else { isr_ovf++; Timer_A1(); }
+    }
+}
+
+/// advance time to t (CPU sleeps, interrupts are serviced)
+void sim_advance(uint64_t t)
+{
+    sim_isr();
+    while (sim_next()<=t)
+    {
+        sim_t = sim_next();
+        if ((sim_t&0xFFFF)==0) sim_taifg = 1;
+        if ((sim_t&0xFFFF)==sim_ccr0) sim_ccifg = 1;
+        sim_isr();
+    }
+    sim_t = t;
+}
+
+/// sleep until some task is due
+void timer_host_sleep(void)
+{
+    wakeups++;
+    while (!sched_pending)
+    {
+        uint64_t t = sim_t;
+        sim_advance(sim_next());
+        if (sim_t==t) break;
+    }
+}
+
+/// test tasks (run count, time of last run, max. lateness, overrun)
+#define NTASKS 3
+unsigned long runs[NTASKS];
+uint64_t last_run[NTASKS];
+long late_max = 0;
+unsigned long period[NTASKS];
+uint64_t busy_ticks = 0; // task 0 duration
+unsigned long backwards = 0; // timer_now() went back
+
+void task_run(int n)
+{
+    static unsigned long prev = 0;
+    unsigned long now = timer_now();
+    if ((long)(now-prev)<0) backwards++;
+    prev = now;
+    if (runs[n]!=0)
+    {
+        long late = (long)(sim_t-last_run[n])-(long)period[n];
+        if (late>late_max) late_max = late;
+    }
+    runs[n]++;
+    last_run[n] = sim_t;
+}
+
+void task0(void) { task_run(0); if (busy_ticks) sim_advance(sim_t+busy_ticks); }
+void task1(void) { task_run(1); }
+void task2(void) { task_run(2); }
+
+/// run scheduler until time t
+void run_until(uint64_t t)
+{
+    while (sim_t<t) sched_run();
+}
+
+/// scheduler tests
+void sched_tests(void)
+{
+    char id0;
+    int i;
+
+    timer_init();
+    for (i=0;i<NTASKS;i++) runs[i] = 0;
+    period[0] = TIMER_S(5);
+    period[1] = TIMER_S(7);
+    period[2] = TIMER_S(60); // beyond 16 bit range
+    id0 = sched_add(task0,period[0]);
+    CHECK(id0==0);
+    CHECK(sched_add(task1,period[1])==1);
+    CHECK(sched_add(task2,period[2])==2);
+    CHECK(sched_add(task2,period[2])==3);
+    CHECK(sched_add(task2,period[2])==-1); // table full
+    sched_set_period(3,TIMER_S(100000)); // last slot parked
+
+    // one hour, independent periods (on time, no drift)
+    run_until(TIMER_S(3600));
+    CHECK(runs[0]==720);
+    CHECK(runs[1]==514);
+    CHECK(runs[2]==60);
+    CHECK(late_max==0);
+    CHECK(backwards==0);
+    printf("1 hour: %lu/%lu/%lu runs, %lu wakeups, %lu alarm and %lu overflow interrupts\n",
+           runs[0],runs[1],runs[2],wakeups,isr_alarm,isr_ovf);
+    CHECK(wakeups<=runs[0]+runs[1]+runs[2]);
+
+    // runtime period change (next run one new period from now)
+    uint64_t t0 = sim_t;
+    unsigned long r0 = runs[0];
+    period[0] = TIMER_S(1);
+    sched_set_period(id0,period[0]);
+    run_until(t0+TIMER_S(60));
+    CHECK(runs[0]-r0==60);
+    CHECK(last_run[0]==t0+TIMER_S(60));
+    sched_set_period(-1,TIMER_S(1)); // no task, ignored
+
+    // task longer than its period (missed runs are skipped, others keep period)
+    late_max = 0;
+    t0 = sim_t;
+    r0 = runs[0];
+    unsigned long r1 = runs[1];
+    busy_ticks = TIMER_MS(2500);
+    period[0] = TIMER_S(2);
+    sched_set_period(id0,period[0]);
+    run_until(t0+TIMER_S(70));
+    CHECK(runs[0]-r0<=70/2);
+    CHECK(runs[1]-r1>=9);
+    CHECK(late_max<=2*(long)TIMER_MS(2500)); // waits for the busy task to end and its pending run
+    printf("overrun: %lu runs of 2.5s task with 2s period in 70s, max. delay %ldms\n",
+           runs[0]-r0,late_max*1000/(long)TIMER_HZ);
+    busy_ticks = 0;
+    CHECK(backwards==0);
+}
+
+/// energy model (MSP430G2553 and SHT11 datasheet typical values, 2.2V, 1MHz DCO)
+#define I_ACTIVE 230.0  // uA, active mode 1MHz
+#define I_LPM0 56.0     // uA, LPM0 (DCO, SMCLK on)
+#define I_LPM3 0.5      // uA, LPM3 VLO (0.7 uA with 32kHz crystal)
+#define I_SHT_MEAS 550.0 // uA, sensor measuring
+#define I_SHT_SLEEP 0.3 // uA, sensor sleep
+
+/// simulated measure task (T and RH asynchronous, as task_measure in main.c)
+void measure_cost(unsigned char res, double *active_s, double *conv_s)
+{
+    unsigned int v;
+    uint64_t t, a;
+    unsigned char mode;
+
+    shtsim_reset();
+    sht11_init();
+    sht_set_resolution(res);
+    t = shtsim_time(); a = shtsim_active();
+    for (mode=TEMP;;mode=HUMI)
+    {
+        sht_measure_async(mode,0);
+        while (!sht_measure_async_done()) if (!shtsim_sleep()) break;
+        sht_measure_async_result(&v);
+        if (mode==HUMI) break;
+    }
+    *active_s = (shtsim_active()-a)*1e-6;
+    *conv_s = (shtsim_time()-t)*1e-6;
+}
+
+/// average current of configuration (period s, old fixed 0.5s LPM0 timer or scheduler LPM3)
+void budget(const char *name, double period_s, unsigned char res, int old)
+{
+    double act, conv;
+    measure_cost(res,&act,&conv);
+    act += 300e-6; // conversion to int, BCD, history, stream (approx.)
+    double wakes = old ? period_s/0.5 : 1.0;
+    act += wakes*20e-6; // timer interrupt entry/exit
+    double idle = period_s-act;
+    // old timer: LPM0, LPM3 only during conversion wait (both loops)
+    double i_idle = old ? (I_LPM0*(idle-conv)+I_LPM3*conv)/idle : I_LPM3;
+    double mcu = (I_ACTIVE*act+i_idle*idle)/period_s;
+    double sht = (I_SHT_MEAS*conv+I_SHT_SLEEP*(period_s-conv))/period_s;
+    printf("%-28s %8.2f uA MCU %8.2f uA SHT %8.2f uA total, %6.0f days on 225mAh\n",
+           name,mcu,sht,mcu+sht,225000.0/(mcu+sht)/24);
+}
+
+int main(void)
+{
+    sched_tests();
+
+    printf("average current budget (estimate, simulated active time):\n");
+    budget("fixed 0.5s timer, LPM0, 5s",5,SHT_RES_HIGH,1);
+    budget("scheduler, LPM3, 5s",5,SHT_RES_HIGH,0);
+    budget("scheduler, LPM3, 5s lowres",5,SHT_RES_LOW,0);
+    budget("scheduler, LPM3, 60s",60,SHT_RES_HIGH,0);
+    budget("scheduler, LPM3, 60s lowres",60,SHT_RES_LOW,0);
+
+    printf("%d tests, %d failed\n",tests,failed);
+    return (failed!=0);
+}
@@ -0,0 +1,357 @@
+/*
+ * shtarc.c test - archive of a simulated year of 5s samples: round trip, iterator,
+ * queries against brute force conversion, cut off incomplete chunk and append;
+ * benchmark of ingest rate, scan rate and bytes per sample against a text log
+ *
+ * usage:
+ *   shtarc [days (365)] [file (shtarc_test.arc)]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../../sht11con.h"
+#include "shtarc.h"
+
+/// test counters
+int tests = 0, failed = 0;
+
+#define CHECK(cond) check((cond),#cond,__LINE__)
+
+void check(int ok, const char *what, int line)
+{
+    tests++;
+    if (ok) return;
+    failed++;
+    printf("FAILED (line %d): %s\n",line,what);
+}
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC,&ts);
+    return ts.tv_sec+ts.tv_nsec/1e9;
+}
+
+/** simulated log */
+
+#define PERIOD_MS 5000
+#define DAY_MS 86400000LL
+/// low resolution days (battery saving period)
+#define LOW_FROM 200
+#define LOW_TO 210
+
+static uint32_t hash(uint32_t x)
+{
+    x ^= x>>16; x *= 0x7feb352d;
+    x ^= x>>15; x *= 0x846ca68b;
+    return x^(x>>16);
+}
+
+/// sample i of log: daily and yearly T/RH cycles, a few LSB of noise, 10 min gap
+/// every day, sometimes 1 ms clock drift, low resolution period (same function
+/// for writer and checks, nothing is kept in memory)
+static void gen(uint32_t i, int64_t *t, uint16_t *tR, uint16_t *hR, uint8_t *res)
+{
+    int64_t base = 1767225600000LL; // 1.1.2026
+    uint32_t per_day = DAY_MS/PERIOD_MS-120, day = i/per_day, k = i%per_day, h = hash(i);
+    double x = (double)k/per_day, T, RH;
+
+    *t = base+day*DAY_MS+(int64_t)k*PERIOD_MS+((k>=6000)?120*PERIOD_MS:0)+(h%997==0);
+    T = 12+10*sin(2*M_PI*day/365)+6*sin(2*M_PI*x);
+    RH = 55-15*sin(2*M_PI*x)+10*cos(2*M_PI*day/365);
+    *tR = (uint16_t)((T+39.7)/0.01)+(h>>8)%7-3;
+    *hR = (uint16_t)((RH+2.0468)/0.0367)+(h>>12)%5-2;
+    *res = ((day>=LOW_FROM)&&(day<LOW_TO))?SHTARC_RES_LOW:SHTARC_RES_HIGH;
+    if (*res==SHTARC_RES_LOW)
+    {
+        *tR = (uint16_t)((T+39.7)/0.04);
+        *hR = (uint16_t)((RH+2.0468)/0.5872);
+    }
+}
+
+static void conv(uint8_t res, uint16_t tR, uint16_t hR, int16_t *T, int16_t *H)
+{
+    if (res==SHTARC_RES_LOW) sht2int_lowres(tR,hR,T,H);
+    else sht2int(tR,hR,T,H);
+}
+
+/** query checks */
+
+typedef struct {
+    uint64_t n, sum;
+    int64_t last_t;
+    int ordered;
+} qres_t;
+
+static void qsum(qres_t *r, int64_t t, int16_t T, int16_t H)
+{
+    r->n++;
+    r->sum += (uint64_t)t*31+(uint16_t)T*7+(uint16_t)H;
+    if (t<r->last_t) r->ordered = 0;
+    r->last_t = t;
+}
+
+static void qfn(void *ctx, const int64_t *t, const int16_t *T, const int16_t *H, size_t n)
+{
+    size_t i;
+    for (i=0;i<n;i++) qsum((qres_t*)ctx,t[i],T[i],H[i]);
+}
+
+/// brute force (every sample converted)
+static qres_t brute(uint32_t samples, const shtarc_query_t *q)
+{
+    qres_t r = {0,0,INT64_MIN,1};
+    uint32_t i;
+    for (i=0;i<samples;i++)
+    {
+        int64_t t;
+        uint16_t tR, hR;
+        uint8_t res;
+        int16_t T, H;
+        gen(i,&t,&tR,&hR,&res);
+        conv(res,tR,hR,&T,&H);
+        if ((t>=q->t_from)&&(t<q->t_to)&&(T>=q->T_min)&&(T<=q->T_max)&&(H>=q->H_min)&&(H<=q->H_max))
+            qsum(&r,t,T,H);
+    }
+    return r;
+}
+
+static void query_check(const shtarc_t *a, uint32_t samples, const char *name, const shtarc_query_t *q)
+{
+    qres_t r = {0,0,INT64_MIN,1}, b = brute(samples,q);
+    shtarc_qstat_t st;
+    double t0 = now_s(), dt;
+
+    CHECK(shtarc_query(a,q,qfn,&r,&st)==0);
+    dt = now_s()-t0;
+    CHECK((r.n==b.n)&&(r.sum==b.sum)&&r.ordered);
+    CHECK(st.matched==r.n);
+    printf("%-28s %9" PRIu64 " %7" PRIu64 " %7" PRIu64 " %10" PRIu64 " %9.2f\n",
+           name,r.n,st.chunks,st.skipped,st.converted,dt*1e3);
+}
+
+/** text log (the same registers, one line per sample) */
+
+static double text_write(const char *path, uint32_t samples, long *size)
+{
+    FILE *f = fopen(path,"w");
+    double t0 = now_s();
+    uint32_t i;
+    for (i=0;i<samples;i++)
+    {
+        int64_t t;
+        uint16_t tR, hR;
+        uint8_t res;
+        gen(i,&t,&tR,&hR,&res);
+        fprintf(f,"%" PRId64 ",%u,%u,%u\n",t,tR,hR,res);
+    }
+    *size = ftell(f);
+    fclose(f);
+    return now_s()-t0;
+}
+
+static double text_scan(const char *path, uint64_t *n, int64_t *sum)
+{
+    FILE *f = fopen(path,"r");
+    char line[64];
+    double t0 = now_s();
+    *n = 0; *sum = 0;
+    while (fgets(line,sizeof(line),f))
+    {
+        char *p;
+        int64_t t = strtoll(line,&p,10);
+        uint16_t tR = strtoul(p+1,&p,10), hR = strtoul(p+1,&p,10);
+        uint8_t res = strtoul(p+1,&p,10);
+        int16_t T, H;
+        conv(res,tR,hR,&T,&H);
+        *sum += t+T+H;
+        (*n)++;
+    }
+    fclose(f);
+    return now_s()-t0;
+}
+
+static void sum_fn(void *ctx, const int64_t *t, const int16_t *T, const int16_t *H, size_t n)
+{
+    size_t i;
+    for (i=0;i<n;i++) *(int64_t*)ctx += t[i]+T[i]+H[i];
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t days = (argc>1)?atoi(argv[1]):365;
+    const char *path = (argc>2)?argv[2]:"shtarc_test.arc";
+    uint32_t samples = days*(DAY_MS/PERIOD_MS-120), i;
+    char text[256], cut[256];
+    shtarc_writer_t w;
+    shtarc_t a;
+    shtarc_iter_t it;
+    shtarc_raw_t s;
+    shtarc_query_t q;
+    int64_t t, day0, sum;
+    uint16_t tR, hR;
+    uint8_t res;
+    double t0, gen_time, ingest, scan_raw, scan_all, text_w, text_r;
+    long text_size;
+    uint64_t n;
+    int ok;
+
+    if ((days<LOW_TO+1)||(days>10000))
+    {
+        fprintf(stderr,"days %d .. 10000\n",LOW_TO+1);
+        return 2;
+    }
+    snprintf(text,sizeof(text),"%s.txt",path);
+    snprintf(cut,sizeof(cut),"%s.cut",path);
+    gen(0,&day0,&tR,&hR,&res);
+
+    // generator alone (subtracted from ingest rates)
+    t0 = now_s();
+    for (sum=0,i=0;i<samples;i++)
+    {
+        gen(i,&t,&tR,&hR,&res);
+        sum += t+tR+hR+res;
+    }
+    gen_time = now_s()-t0;
+    CHECK(sum!=0);
+
+    // writer
+    t0 = now_s();
+    CHECK(shtarc_create(&w,path,0)==0);
+    for (ok=1,i=0;i<samples;i++)
+    {
+        gen(i,&t,&tR,&hR,&res);
+        ok &= (shtarc_append(&w,t,tR,hR,res)==0);
+    }
+    CHECK(ok);
+    CHECK(shtarc_append(&w,t-1,tR,hR,res)!=0); // time going back
+    CHECK(shtarc_append(&w,t,0x4000,hR,res)!=0); // not 14bit
+    CHECK(shtarc_append(&w,t,tR,0x1000,res)!=0); // not 12bit
+    CHECK(shtarc_finish(&w)==0);
+    ingest = now_s()-t0-gen_time;
+
+    // reader, iterator
+    CHECK(shtarc_open(&a,path)==0);
+    CHECK(a.samples==samples);
+    CHECK(a.chunks>=samples/SHTARC_CHUNK);
+    shtarc_iter_init(&it,&a,INT64_MIN);
+    for (ok=1,i=0;shtarc_iter_next(&it,&s);i++)
+    {
+        gen(i,&t,&tR,&hR,&res);
+        ok &= (s.t==t)&&(s.tR==tR)&&(s.hR==hR)&&(s.res==res);
+    }
+    CHECK(ok && (i==samples));
+    t0 = now_s();
+    shtarc_iter_init(&it,&a,INT64_MIN);
+    for (sum=0;shtarc_iter_next(&it,&s);) sum += s.t+s.tR+s.hR;
+    scan_raw = now_s()-t0;
+    CHECK(sum!=0);
+    // from the middle of chunk (first sample at that time or later, sample in 10 min gap)
+    gen(100000,&t,&tR,&hR,&res);
+    shtarc_iter_init(&it,&a,t-1);
+    CHECK(shtarc_iter_next(&it,&s) && (s.t==t) && (s.tR==tR));
+    gen(6000,&t,&tR,&hR,&res);
+    shtarc_iter_init(&it,&a,t-60000);
+    CHECK(shtarc_iter_next(&it,&s) && (s.t==t));
+    shtarc_iter_init(&it,&a,INT64_MAX);
+    CHECK(!shtarc_iter_next(&it,&s));
+
+    printf("%u days, %u samples, %zu chunks (%d samples)\n",days,samples,a.chunks,SHTARC_CHUNK);
+    printf("%-28s %9s %7s %7s %10s %9s\n","query","samples","chunks","skipped","converted","ms");
+    shtarc_query_all(&q);
+    query_check(&a,samples,"all",&q);
+    q.t_from = day0+100*DAY_MS+DAY_MS/3;
+    q.t_to = q.t_from+DAY_MS;
+    query_check(&a,samples,"one day",&q);
+    shtarc_query_all(&q);
+    q.T_min = 250;
+    query_check(&a,samples,"T >= 25.0",&q);
+    q.T_min = 150; q.T_max = 160;
+    q.H_min = 400; q.H_max = 450;
+    query_check(&a,samples,"T 15..16, RH 40..45",&q);
+    shtarc_query_all(&q);
+    q.t_from = day0+LOW_FROM*DAY_MS-DAY_MS/2;
+    q.t_to = day0+LOW_TO*DAY_MS+DAY_MS/2;
+    q.H_max = 500;
+    query_check(&a,samples,"low res days, RH <= 50.0",&q);
+    shtarc_query_all(&q);
+    q.T_min = 500;
+    query_check(&a,samples,"T >= 50.0 (none)",&q);
+    q.t_from = q.t_to = 0;
+    CHECK(shtarc_query(&a,&q,qfn,NULL,NULL)!=0); // empty time range
+
+    shtarc_query_all(&q);
+    sum = 0;
+    t0 = now_s();
+    shtarc_query(&a,&q,sum_fn,&sum,NULL);
+    scan_all = now_s()-t0;
+    shtarc_close(&a);
+
+    // incomplete last chunk (writer killed) .. ignored by reader, cut off by append
+    {
+        FILE *f = fopen(path,"rb"), *g = fopen(cut,"wb");
+        static char buf[1<<16];
+        long size, left;
+        fseek(f,0,SEEK_END);
+        size = ftell(f);
+        fseek(f,0,SEEK_SET);
+        for (left=size-100;left>0;)
+        {
+            size_t r = fread(buf,1,(left<(long)sizeof(buf))?(size_t)left:sizeof(buf),f);
+            fwrite(buf,1,r,g);
+            left -= r;
+        }
+        fclose(f);
+        fclose(g);
+    }
+    CHECK(shtarc_open(&a,cut)==0);
+    n = a.samples;
+    CHECK((n<samples)&&(n+SHTARC_CHUNK>=samples)); // last chunk lost
+    shtarc_close(&a);
+    CHECK(shtarc_append_open(&w,cut)==0);
+    CHECK(w.samples==n);
+    for (ok=1,i=n;i<samples;i++)
+    {
+        gen(i,&t,&tR,&hR,&res);
+        ok &= (shtarc_append(&w,t,tR,hR,res)==0);
+    }
+    CHECK(ok);
+    CHECK(shtarc_finish(&w)==0);
+    CHECK(shtarc_open(&a,cut)==0);
+    CHECK(a.samples==samples);
+    shtarc_query_all(&q);
+    query_check(&a,samples,"all (cut and appended)",&q);
+    shtarc_close(&a);
+    CHECK(shtarc_append_open(&w,text)!=0); // not archive (no file yet)
+
+    // text log
+    text_w = text_write(text,samples,&text_size)-gen_time;
+    text_r = text_scan(text,&n,&t);
+    CHECK((n==samples)&&(t==sum));
+
+    {
+        FILE *f = fopen(path,"rb");
+        long size;
+        fseek(f,0,SEEK_END);
+        size = ftell(f);
+        fclose(f);
+        printf("\n%-34s %12s %12s\n","","archive","text log");
+        printf("%-34s %12.2f %12.2f\n","bytes per sample",(double)size/samples,(double)text_size/samples);
+        printf("%-34s %12.1f %12.1f\n","ingest, M samples/s",samples/ingest/1e6,samples/text_w/1e6);
+        printf("%-34s %12.1f %12s\n","scan raw (iterator), M samples/s",samples/scan_raw/1e6,"-");
+        printf("%-34s %12.1f %12.1f\n","scan and convert, M samples/s",samples/scan_all/1e6,samples/text_r/1e6);
+        printf("(generator of samples %.0f ns per sample, not included)\n",gen_time/samples*1e9);
+    }
+
+    remove(path);
+    remove(cut);
+    remove(text);
+    printf("%d tests, %d failed\n",tests,failed);
+    return (failed!=0);
+}
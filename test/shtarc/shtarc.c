@@ -0,0 +1,465 @@
+/*
+ * shtarc.c
+ *
+ *  Created on: 17.10.2026
+ *      Author: agent
+ *
+ *  Description: columnar archive of raw SHT11 registers (see shtarc.h)
+ *
+ *  Functions:
+ *  	writer .. shtarc_create(), shtarc_append_open(), shtarc_append(), shtarc_finish()
+ *  	reader .. shtarc_open(), shtarc_close(), shtarc_iter_init(), shtarc_iter_next()
+ *  	query .. shtarc_query_all(), shtarc_query()
+ *
+ */
+
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "../../sht11con.h"
+#include "shtarc.h"
+
+/// max. time delta in chunk (ms, 31 bits - about 24 days, longer gap starts new chunk)
+#define MAX_DELTA 0x7fffffffLL
+/// samples per query block
+#define QBLOCK 256
+
+/** columns */
+
+uint32_t shtarc_col_size(uint32_t n, unsigned bits)
+{
+    if (!bits || !n) return 0;
+    return (uint32_t)(((uint64_t)n*bits+63)/64+1)*8;
+}
+
+/// size of columns of chunk
+static uint32_t chunk_size(uint32_t n, unsigned dbits)
+{
+    return shtarc_col_size(n,SHTARC_TBITS)+shtarc_col_size(n,SHTARC_HBITS)+shtarc_col_size(n?n-1:0,dbits);
+}
+
+/// value i to bit packed column (column zeroed before)
+static void put(uint8_t *col, unsigned bits, size_t i, uint32_t v)
+{
+    uint64_t w;
+    size_t b = i*bits;
+    memcpy(&w,col+(b>>3),8);
+    w |= (uint64_t)v<<(b&7);
+    memcpy(col+(b>>3),&w,8);
+}
+
+static unsigned bits_of(uint32_t v)
+{
+    unsigned b = 0;
+    while (v) { b++; v >>= 1; }
+    return b;
+}
+
+/// chunk header check (avail .. bytes from chunk start to end of file), returns chunk length or 0
+static size_t chunk_check(const shtarc_chunk_t *c, size_t avail, uint32_t chunk_max)
+{
+    if ((avail<sizeof(*c))||(c->magic!=SHTARC_CHUNK_MAGIC)) return 0;
+    if ((c->n==0)||(c->n>chunk_max)||(c->dbits>31)||(c->res>SHTARC_RES_LOW)||(c->t_last<c->t_first)) return 0;
+    if (c->size!=chunk_size(c->n,c->dbits)) return 0;
+    if (avail-sizeof(*c)<c->size) return 0; // incomplete
+    return sizeof(*c)+c->size;
+}
+
+/** writer */
+
+static int writer_alloc(shtarc_writer_t *w)
+{
+    w->t = malloc(w->chunk_max*sizeof(*w->t));
+    w->tR = malloc(w->chunk_max*sizeof(*w->tR));
+    w->hR = malloc(w->chunk_max*sizeof(*w->hR));
+    w->buf = malloc(chunk_size(w->chunk_max,31));
+    return (w->t && w->tR && w->hR && w->buf)?0:-1;
+}
+
+static void writer_free(shtarc_writer_t *w)
+{
+    free(w->t); free(w->tR); free(w->hR); free(w->buf);
+    w->t = NULL; w->tR = w->hR = NULL; w->buf = NULL;
+}
+
+/// new archive (chunk_max 0 .. SHTARC_CHUNK)
+int shtarc_create(shtarc_writer_t *w, const char *path, uint32_t chunk_max)
+{
+    shtarc_hdr_t h;
+
+    memset(w,0,sizeof(*w));
+    w->chunk_max = chunk_max?chunk_max:SHTARC_CHUNK;
+    w->f = fopen(path,"wb");
+    if (!w->f) return -1;
+    memset(&h,0,sizeof(h));
+    memcpy(h.magic,SHTARC_MAGIC,8);
+    h.version = SHTARC_VERSION;
+    h.chunk_max = w->chunk_max;
+    if ((fwrite(&h,sizeof(h),1,w->f)!=1)||(writer_alloc(w)!=0))
+    {
+        fclose(w->f);
+        writer_free(w);
+        return -1;
+    }
+    return 0;
+}
+
+/// append to existing archive (incomplete last chunk is cut off)
+int shtarc_append_open(shtarc_writer_t *w, const char *path)
+{
+    shtarc_hdr_t h;
+    shtarc_chunk_t c;
+    long pos = sizeof(h), end;
+
+    memset(w,0,sizeof(*w));
+    w->f = fopen(path,"r+b");
+    if (!w->f) return -1;
+    fseek(w->f,0,SEEK_END);
+    end = ftell(w->f);
+    fseek(w->f,0,SEEK_SET);
+    if ((fread(&h,sizeof(h),1,w->f)!=1)||memcmp(h.magic,SHTARC_MAGIC,8)||(h.version!=SHTARC_VERSION)||!h.chunk_max)
+    {
+        fclose(w->f);
+        return -1;
+    }
+    w->chunk_max = h.chunk_max;
+    for (;;)
+    {
+        size_t len;
+        fseek(w->f,pos,SEEK_SET);
+        if (fread(&c,sizeof(c),1,w->f)!=1) break;
+        if (!(len = chunk_check(&c,end-pos,w->chunk_max))) break;
+        w->last_t = c.t_last;
+        w->samples += c.n;
+        w->chunks++;
+        pos += len;
+    }
+    fflush(w->f);
+    if (((pos!=end)&&(ftruncate(fileno(w->f),pos)!=0))||(writer_alloc(w)!=0))
+    {
+        fclose(w->f);
+        writer_free(w);
+        return -1;
+    }
+    fseek(w->f,pos,SEEK_SET);
+    return 0;
+}
+
+/// write collected samples as chunk
+static int flush_chunk(shtarc_writer_t *w)
+{
+    shtarc_chunk_t c;
+    uint32_t i, dmax = 0;
+    uint8_t *tcol, *hcol, *dcol;
+
+    if (!w->n) return 0;
+    memset(&c,0,sizeof(c));
+    c.magic = SHTARC_CHUNK_MAGIC;
+    c.n = w->n;
+    c.t_first = w->t[0];
+    c.t_last = w->t[w->n-1];
+    c.res = w->res;
+    c.tmin = c.tmax = w->tR[0];
+    c.hmin = c.hmax = w->hR[0];
+    c.dmin = (w->n>1)?(uint32_t)(w->t[1]-w->t[0]):0;
+    for (i=0;i<w->n;i++)
+    {
+        if (w->tR[i]<c.tmin) c.tmin = w->tR[i];
+        if (w->tR[i]>c.tmax) c.tmax = w->tR[i];
+        if (w->hR[i]<c.hmin) c.hmin = w->hR[i];
+        if (w->hR[i]>c.hmax) c.hmax = w->hR[i];
+        if (i)
+        {
+            uint32_t d = (uint32_t)(w->t[i]-w->t[i-1]);
+            if (d<c.dmin) c.dmin = d;
+            if (d>dmax) dmax = d;
+        }
+    }
+    c.dbits = bits_of(dmax-c.dmin);
+    c.size = chunk_size(c.n,c.dbits);
+
+    memset(w->buf,0,c.size);
+    tcol = w->buf;
+    hcol = tcol+shtarc_col_size(c.n,SHTARC_TBITS);
+    dcol = hcol+shtarc_col_size(c.n,SHTARC_HBITS);
+    for (i=0;i<w->n;i++)
+    {
+        put(tcol,SHTARC_TBITS,i,w->tR[i]);
+        put(hcol,SHTARC_HBITS,i,w->hR[i]);
+        if (i && c.dbits) put(dcol,c.dbits,i-1,(uint32_t)(w->t[i]-w->t[i-1])-c.dmin);
+    }
+    if ((fwrite(&c,sizeof(c),1,w->f)!=1)||(fwrite(w->buf,1,c.size,w->f)!=c.size)) return -1;
+    w->chunks++;
+    w->n = 0;
+    return 0;
+}
+
+/// add sample (registers 14bit T, 12bit RH, time in ms not decreasing), -1 on error
+int shtarc_append(shtarc_writer_t *w, int64_t t, uint16_t tR, uint16_t hR, uint8_t res)
+{
+    if ((tR>>SHTARC_TBITS)||(hR>>SHTARC_HBITS)||(res>SHTARC_RES_LOW)) return -1;
+    if (w->samples && (t<w->last_t)) return -1;
+    if (w->n && ((w->n==w->chunk_max)||(res!=w->res)||(t-w->last_t>MAX_DELTA)))
+        if (flush_chunk(w)!=0) return -1;
+    w->t[w->n] = t;
+    w->tR[w->n] = tR;
+    w->hR[w->n] = hR;
+    w->n++;
+    w->res = res;
+    w->last_t = t;
+    w->samples++;
+    return 0;
+}
+
+/// write last chunk and close
+int shtarc_finish(shtarc_writer_t *w)
+{
+    int r = flush_chunk(w);
+    if (fclose(w->f)!=0) r = -1;
+    writer_free(w);
+    return r;
+}
+
+/** reader */
+
+int shtarc_open(shtarc_t *a, const char *path)
+{
+    const shtarc_hdr_t *h;
+    struct stat st;
+    size_t pos, len, cap = 0;
+    int fd;
+
+    memset(a,0,sizeof(*a));
+    fd = open(path,O_RDONLY);
+    if (fd<0) return -1;
+    if ((fstat(fd,&st)!=0)||(st.st_size<(off_t)sizeof(*h)))
+    {
+        close(fd);
+        return -1;
+    }
+    a->size = st.st_size;
+    a->map = mmap(NULL,a->size,PROT_READ,MAP_SHARED,fd,0);
+    close(fd);
+    if (a->map==MAP_FAILED) { a->map = NULL; return -1; }
+    h = (const shtarc_hdr_t*)a->map;
+    if (memcmp(h->magic,SHTARC_MAGIC,8)||(h->version!=SHTARC_VERSION)||!h->chunk_max)
+    {
+        shtarc_close(a);
+        return -1;
+    }
+    a->chunk_max = h->chunk_max;
+
+    // chunk index (headers only, columns are not touched)
+    for (pos=sizeof(*h);(len = chunk_check((const shtarc_chunk_t*)(a->map+pos),a->size-pos,a->chunk_max));pos+=len)
+    {
+        if (a->chunks==cap)
+        {
+            const shtarc_chunk_t **p = realloc(a->chunk,(cap = cap?cap*2:256)*sizeof(*p));
+            if (!p) { shtarc_close(a); return -1; }
+            a->chunk = p;
+        }
+        a->chunk[a->chunks++] = (const shtarc_chunk_t*)(a->map+pos);
+        a->samples += ((const shtarc_chunk_t*)(a->map+pos))->n;
+    }
+    return 0;
+}
+
+void shtarc_close(shtarc_t *a)
+{
+    if (a->map) munmap((void*)a->map,a->size);
+    free(a->chunk);
+    memset(a,0,sizeof(*a));
+}
+
+/// first chunk ending at t or later
+static size_t find_chunk(const shtarc_t *a, int64_t t)
+{
+    size_t lo = 0, hi = a->chunks;
+    while (lo<hi)
+    {
+        size_t m = (lo+hi)/2;
+        if (a->chunk[m]->t_last<t) lo = m+1;
+        else hi = m;
+    }
+    return lo;
+}
+
+/// time of sample i>0 from time of sample i-1
+static inline int64_t next_time(const shtarc_chunk_t *c, const uint8_t *dcol, int64_t t, uint32_t i)
+{
+    return t+c->dmin+(c->dbits?shtarc_get(dcol,c->dbits,i-1):0);
+}
+
+/// iterator from first sample at t_from or later
+void shtarc_iter_init(shtarc_iter_t *it, const shtarc_t *a, int64_t t_from)
+{
+    it->a = a;
+    it->chunk = find_chunk(a,t_from);
+    it->i = 0;
+    if (it->chunk<a->chunks)
+    {
+        const shtarc_chunk_t *c = a->chunk[it->chunk];
+        it->t = c->t_first;
+        while (it->t<t_from) { it->i++; it->t = next_time(c,shtarc_dcol(c),it->t,it->i); }
+    }
+}
+
+/// next raw sample (0 .. end of archive)
+int shtarc_iter_next(shtarc_iter_t *it, shtarc_raw_t *s)
+{
+    const shtarc_chunk_t *c;
+
+    if (it->chunk>=it->a->chunks) return 0;
+    c = it->a->chunk[it->chunk];
+    s->t = it->t;
+    s->tR = shtarc_get(shtarc_tcol(c),SHTARC_TBITS,it->i);
+    s->hR = shtarc_get(shtarc_hcol(c),SHTARC_HBITS,it->i);
+    s->res = c->res;
+    if (++it->i<c->n) it->t = next_time(c,shtarc_dcol(c),it->t,it->i);
+    else if (++it->chunk<it->a->chunks)
+    {
+        it->i = 0;
+        it->t = it->a->chunk[it->chunk]->t_first;
+    }
+    return 1;
+}
+
+/** query */
+
+void shtarc_query_all(shtarc_query_t *q)
+{
+    q->t_from = INT64_MIN;
+    q->t_to = INT64_MAX;
+    q->T_min = q->H_min = INT16_MIN;
+    q->T_max = q->H_max = INT16_MAX;
+}
+
+static inline void conv(uint8_t res, uint16_t tR, uint16_t hR, int16_t *T, int16_t *H)
+{
+    if (res==SHTARC_RES_LOW) sht2int_lowres(tR,hR,T,H);
+    else sht2int(tR,hR,T,H);
+}
+
+/// first T register with T > limit (T doesn't depend on RH register and grows with tR)
+static int t_above(uint8_t res, int limit)
+{
+    int a = 0, b = (res==SHTARC_RES_LOW)?0x1000:0x4000;
+    int16_t T, H;
+    while (a<b)
+    {
+        int m = (a+b)/2;
+        conv(res,m,0,&T,&H);
+        if (T>limit) b = m;
+        else a = m+1;
+    }
+    return a;
+}
+
+/// T and RH bounds of chunk from its register summary
+/// T grows with tR. RH is f(hR) + g(tR) before clamping: f grows with hR, temperature
+/// compensation g = (T-25)*(t1-t2*tR) is a parabola with maximum in the middle of its
+/// roots. Rounding of fixed-point RH is covered by +-1.
+static void chunk_bounds(const shtarc_chunk_t *c, int16_t *Tlo, int16_t *Thi, int16_t *Hlo, int16_t *Hhi)
+{
+    double top = (c->res==SHTARC_RES_LOW)?(((25.0-D1L)/D2L+T1L/T2L)/2):(((25.0-D1)/D2+T1/T2)/2);
+    int16_t T, H;
+
+    conv(c->res,c->tmin,c->hmin,Tlo,Hlo);
+    conv(c->res,c->tmax,c->hmin,Thi,&H);
+    if (H<*Hlo) *Hlo = H;
+    conv(c->res,c->tmin,c->hmax,&T,Hhi);
+    conv(c->res,c->tmax,c->hmax,&T,&H);
+    if (H>*Hhi) *Hhi = H;
+    if ((top>c->tmin)&&(top<c->tmax))
+    {
+        conv(c->res,(uint16_t)top,c->hmax,&T,&H);
+        if (H>*Hhi) *Hhi = H;
+        conv(c->res,(uint16_t)top+1,c->hmax,&T,&H);
+        if (H>*Hhi) *Hhi = H;
+    }
+    (*Hlo)--;
+    (*Hhi)++;
+}
+
+/// converted samples of range to fn (blocks of up to QBLOCK samples), -1 on error
+int shtarc_query(const shtarc_t *a, const shtarc_query_t *q, shtarc_fn_t fn, void *ctx, shtarc_qstat_t *st)
+{
+    int64_t bt[QBLOCK];
+    uint16_t btR[QBLOCK], bhR[QBLOCK];
+    int win[2][2];     // T register window per resolution (empty .. lo > hi)
+    int16_t bT[QBLOCK], bH[QBLOCK];
+    shtarc_qstat_t s;
+    size_t ci;
+    int r;
+
+    if (q->t_from>=q->t_to) return -1;
+    memset(&s,0,sizeof(s));
+    for (r=0;r<2;r++)
+    {
+        win[r][0] = t_above(r,q->T_min-1);
+        win[r][1] = t_above(r,q->T_max)-1;
+    }
+
+    for (ci=find_chunk(a,q->t_from);ci<a->chunks;ci++)
+    {
+        const shtarc_chunk_t *c = a->chunk[ci];
+        const uint8_t *tcol = shtarc_tcol(c), *hcol = shtarc_hcol(c), *dcol = shtarc_dcol(c);
+        int16_t Tlo, Thi, Hlo, Hhi;
+        int64_t t = c->t_first;
+        uint32_t i = 0;
+        int full;
+
+        if (c->t_first>=q->t_to) break;
+        s.chunks++;
+        chunk_bounds(c,&Tlo,&Thi,&Hlo,&Hhi);
+        if ((Thi<q->T_min)||(Tlo>q->T_max)||(Hhi<q->H_min)||(Hlo>q->H_max)||(win[c->res][0]>win[c->res][1]))
+        {
+            s.skipped++;
+            continue;
+        }
+        full = (c->t_first>=q->t_from)&&(c->t_last<q->t_to)&&(Tlo>=q->T_min)&&(Thi<=q->T_max)&&
+               (Hlo>=q->H_min)&&(Hhi<=q->H_max);
+
+        while (i<c->n)
+        {
+            size_t k = 0, m, j;
+            // raw filter (time, T register window), only matching samples are converted
+            for (m=(c->n-i<QBLOCK)?c->n-i:QBLOCK;m--;)
+            {
+                uint16_t tR = shtarc_get(tcol,SHTARC_TBITS,i);
+                if (full || ((t>=q->t_from)&&(t<q->t_to)&&(tR>=win[c->res][0])&&(tR<=win[c->res][1])))
+                {
+                    bt[k] = t;
+                    btR[k] = tR;
+                    bhR[k] = shtarc_get(hcol,SHTARC_HBITS,i);
+                    k++;
+                }
+                if (++i<c->n) t = next_time(c,dcol,t,i);
+            }
+#if (SHT_CONV==SHT_CONV_FIXED)
+            if (c->res==SHTARC_RES_HIGH) sht2int_batch(btR,bhR,bT,bH,k); // the same results as sht2int
+            else
+#endif
+            for (j=0;j<k;j++) sht2int_lowres(btR[j],bhR[j],&bT[j],&bH[j]);
+            s.converted += k;
+            if (!full) // RH range
+            {
+                for (j=m=0;j<k;j++)
+                    if ((bH[j]>=q->H_min)&&(bH[j]<=q->H_max))
+                    {
+                        bt[m] = bt[j]; bT[m] = bT[j]; bH[m] = bH[j];
+                        m++;
+                    }
+                k = m;
+            }
+            if (k) fn(ctx,bt,bT,bH,k);
+            s.matched += k;
+            if (t>=q->t_to) break;
+        }
+    }
+    if (st) *st = s;
+    return 0;
+}
@@ -0,0 +1,156 @@
+/*
+ * shtarc.h
+ *
+ *  Created on: 17.10.2026
+ *      Author: agent
+ *
+ *  Description: columnar archive of raw SHT11 registers (host side, years of samples)
+ *
+ *  File:
+ *  	header (shtarc_hdr_t, 64 bytes)
+ *  	chunks appended one after another (up to chunk_max samples, time ordered):
+ *  		chunk header (shtarc_chunk_t, 48 bytes) .. time range, min/max of registers
+ *  		T column .. 14 bits per sample
+ *  		RH column .. 12 bits per sample
+ *  		time column .. (delta - dmin) with dbits per sample, none for regular sampling
+ *  	columns are bit packed lsb first (little endian), every column padded to 8 bytes
+ *  	plus 8 bytes, so any value is one unaligned 64bit load
+ *
+ *  Low resolution samples (12bit T, 8bit RH) are stored in the same columns, resolution
+ *  is a chunk property (new chunk on resolution change).
+ *  Chunk which is not complete at the end of the file (writer killed) is ignored by
+ *  reader and cut off by shtarc_append_open().
+ *
+ *  Functions:
+ *  	shtarc_create(w,path,chunk_max), shtarc_append_open(w,path) .. writer
+ *  	shtarc_append(w,t,tR,hR,res) .. add sample (time in ms, not decreasing)
+ *  	shtarc_finish(w) .. write last chunk and close
+ *  	shtarc_open(a,path), shtarc_close(a) .. reader (mmap, chunk index)
+ *  	shtarc_iter_init(it,a,t), shtarc_iter_next(it,s) .. raw samples, no copy of columns
+ *  	shtarc_query(a,q,fn,ctx,st) .. converted samples of time/T/RH range (sht11con.c),
+ *  		chunks outside of range by summary are skipped, only matching samples converted
+ */
+
+#ifndef __SHTARC_H__
+#define __SHTARC_H__
+
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+
+#define SHTARC_MAGIC "SHTARC01"
+#define SHTARC_VERSION 1
+#define SHTARC_CHUNK_MAGIC 0x4B4E4843 // "CHNK"
+/// default samples per chunk
+#define SHTARC_CHUNK 4096
+/// column widths
+#define SHTARC_TBITS 14
+#define SHTARC_HBITS 12
+
+/// resolution of chunk (the same as SHT_RES_x)
+#define SHTARC_RES_HIGH 0
+#define SHTARC_RES_LOW 1
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t chunk_max;
+    uint8_t reserved[48];
+} shtarc_hdr_t;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t n;                         // samples
+    int64_t t_first, t_last;            // ms
+    uint16_t tmin, tmax, hmin, hmax;    // registers
+    uint32_t dmin;                      // min. time delta (ms)
+    uint8_t dbits;                      // bits of (delta - dmin)
+    uint8_t res;                        // SHTARC_RES_x
+    uint16_t reserved;
+    uint32_t size;                      // bytes of columns
+    uint32_t reserved2;
+} shtarc_chunk_t;
+
+/// writer
+typedef struct {
+    FILE *f;
+    uint32_t chunk_max, n;
+    int64_t *t, last_t;
+    uint16_t *tR, *hR;
+    uint8_t res;
+    uint8_t *buf;                       // chunk being written
+    uint64_t samples, chunks;
+} shtarc_writer_t;
+
+/// reader
+typedef struct {
+    const uint8_t *map;
+    size_t size;
+    uint32_t chunk_max;
+    const shtarc_chunk_t **chunk;       // chunk index (pointers to map)
+    size_t chunks;
+    uint64_t samples;
+} shtarc_t;
+
+/// raw sample
+typedef struct {
+    int64_t t;
+    uint16_t tR, hR;
+    uint8_t res;
+} shtarc_raw_t;
+
+/// iterator over raw samples
+typedef struct {
+    const shtarc_t *a;
+    size_t chunk;
+    uint32_t i;
+    int64_t t;
+} shtarc_iter_t;
+
+/// query range (time [from,to), T and RH * 10 inclusive)
+typedef struct {
+    int64_t t_from, t_to;
+    int16_t T_min, T_max;
+    int16_t H_min, H_max;
+} shtarc_query_t;
+
+/// query counters
+typedef struct {
+    uint64_t chunks, skipped;           // chunks in time range, skipped by summary
+    uint64_t converted, matched;        // samples converted, given to callback
+} shtarc_qstat_t;
+
+/// query callback (block of samples, T and RH * 10)
+typedef void (*shtarc_fn_t)(void *ctx, const int64_t *t, const int16_t *T, const int16_t *H, size_t n);
+
+int shtarc_create(shtarc_writer_t *w, const char *path, uint32_t chunk_max);
+int shtarc_append_open(shtarc_writer_t *w, const char *path);
+int shtarc_append(shtarc_writer_t *w, int64_t t, uint16_t tR, uint16_t hR, uint8_t res);
+int shtarc_finish(shtarc_writer_t *w);
+
+int shtarc_open(shtarc_t *a, const char *path);
+void shtarc_close(shtarc_t *a);
+
+void shtarc_iter_init(shtarc_iter_t *it, const shtarc_t *a, int64_t t_from);
+int shtarc_iter_next(shtarc_iter_t *it, shtarc_raw_t *s);
+
+/// whole archive
+void shtarc_query_all(shtarc_query_t *q);
+int shtarc_query(const shtarc_t *a, const shtarc_query_t *q, shtarc_fn_t fn, void *ctx, shtarc_qstat_t *st);
+
+/// column data of chunk
+static inline const uint8_t *shtarc_tcol(const shtarc_chunk_t *c) { return (const uint8_t*)(c+1); }
+uint32_t shtarc_col_size(uint32_t n, unsigned bits);
+static inline const uint8_t *shtarc_hcol(const shtarc_chunk_t *c) { return shtarc_tcol(c)+shtarc_col_size(c->n,SHTARC_TBITS); }
+static inline const uint8_t *shtarc_dcol(const shtarc_chunk_t *c) { return shtarc_hcol(c)+shtarc_col_size(c->n,SHTARC_HBITS); }
+
+/// value i of bit packed column
+static inline uint32_t shtarc_get(const uint8_t *col, unsigned bits, size_t i)
+{
+    uint64_t v;
+    size_t b = i*bits;
+    memcpy(&v,col+(b>>3),8);
+    return (uint32_t)(v>>(b&7))&((1u<<bits)-1);
+}
+
+#endif
@@ -0,0 +1,96 @@
+#! /usr/bin/env python3
+
+''' binary framed protocol of msp430 sht11 (see proto.h)
+
+frame: sync 0xA5, type, seq, len, payload, crc (crc-8 of the sensor over type..payload)
+run the module to self test parser '''
+
+SYNC = 0xA5
+
+CMD_POLL = 0x01
+CMD_STREAM = 0x02
+DATA = 0x81
+ACK = 0x82
+
+def crc8(data):
+    ''' sensor crc-8 (x^8+x^5+x^4+1, msb first, start 0, result bit reversed) '''
+    c = 0
+    for b in data:
+        c ^= b
+        for i in range(8):
+            c = ((c<<1)^0x31)&0xFF if c&0x80 else (c<<1)&0xFF
+    return int('{:08b}'.format(c)[::-1],2)
+
+def frame(ftype,seq,payload=b''):
+    ''' build frame (bytes) '''
+    body = bytes([ftype,seq&0xFF,len(payload)])+bytes(payload)
+    return bytes([SYNC])+body+bytes([crc8(body)])
+
+def command_poll(seq):
+    return frame(CMD_POLL,seq)
+
+def command_stream(seq,samples):
+    ''' samples per frame (0 stops stream) '''
+    return frame(CMD_STREAM,seq,bytes([samples]))
+
+class Parser():
+    ''' incremental frame parser (feed bytes, get frames)
+    frame is tuple (type, seq, payload), bad frames are skipped (resync on next 0xA5) '''
+
+    def __init__(self):
+        self.buf = bytearray()
+        self.lastSeq = None
+        self.lost = 0 # frames lost (sequence gaps)
+        self.errors = 0 # crc errors
+
+    def feed(self,data):
+        ''' add received bytes, returns list of complete frames '''
+        self.buf += data
+        frames = []
+        while True:
+            i = self.buf.find(SYNC)
+            if i<0:
+                self.buf.clear()
+                break
+            del self.buf[:i]
+            if len(self.buf)<5:
+                break
+            n = self.buf[3]
+            if len(self.buf)<n+5:
+                break
+            if crc8(self.buf[1:4+n])!=self.buf[4+n]:
+                self.errors += 1
+                del self.buf[0] # resync
+                continue
+            f = (self.buf[1],self.buf[2],bytes(self.buf[4:4+n]))
+            del self.buf[:n+5]
+            if self.lastSeq is not None:
+                self.lost += (f[1]-self.lastSeq-1)&0xFF
+            self.lastSeq = f[1]
+            frames.append(f)
+        return frames
+
+def samples(f):
+    ''' data frame payload to list of samples (lists of values, T and RH * 10) '''
+    ftype,seq,p = f
+    if ftype!=DATA or len(p)<2:
+        return []
+    cnt,ch = p[0],p[1]
+    out = []
+    for s in range(cnt):
+        vals = []
+        for c in range(ch):
+            i = 2+(s*ch+c)*2
+            v = p[i]|(p[i+1]<<8)
+            vals.append(v-0x10000 if v&0x8000 else v)
+        out.append(vals)
+    return out
+
+if __name__ == '__main__':
+    # poll answer printed by test/prototest (T -15.8 C, RH 45.6 %)
+    ans = bytes.fromhex('A5 81 00 06 01 02 62 FF C8 01 2C')
+    p = Parser()
+    fr = p.feed(b'\x00garbage'+ans[:4])+p.feed(ans[4:]+frame(DATA,2,bytes([1,2,1,0,2,0])))
+    assert len(fr)==2 and samples(fr[0])==[[-158,456]] and p.lost==1
+    assert frame(DATA,0,ans[4:10])==ans
+    print('ok')
@@ -0,0 +1,399 @@
+/*
+ * sht11.c unit tests and timing against simulated SHT11 (host build, SHT_HOST)
+ */
+
+#include <stdio.h>
+#include <inttypes.h>
+#include <string.h>
+
+#include "../../sht11.h"
+#include "../../sht11m.h"
+#include "../../sht11hal.h"
+#include "../../prof.h"
+#include "shtsim.h"
+
+/// sensibus basics (not in sht11.h interface)
+char sht_read_byte(unsigned char ack);
+void sht_connectionreset(void);
+char sht_softreset(void);
+
+/// byte transport (timing printout)
+#ifdef SHT_SPI
+#define SHT_TRANSPORT "usci"
+#else
+#define SHT_TRANSPORT "gpio"
+#endif
+
+/// test counters
+int tests = 0, failed = 0;
+
+#define CHECK(cond) check((cond),#cond,__LINE__)
+
+void check(int ok, const char *what, int line)
+{
+    tests++;
+    if (ok) return;
+    failed++;
+    printf("FAILED (line %d): %s\n",line,what);
+}
+
+/// async callback
+unsigned int cb_count = 0, cb_value = 0, cb_error = 0;
+
+void callback(unsigned char error, unsigned int value)
+{
+    cb_count++;
+    cb_error = error;
+    cb_value = value;
+}
+
+/// measure and check values
+void test_measure(void)
+{
+    unsigned int v = 0;
+    shtsim_reset();
+    sht11_init();
+    shtsim_set_values(0x1A2B,0x0567);
+    CHECK(sht_measure_check(&v,TEMP)==0);
+    CHECK(v==0x1A2B);
+    CHECK(sht_measure_check(&v,HUMI)==0);
+    CHECK(v==0x0567);
+    // 14bit conversion takes 320ms
+    CHECK(shtsim_time()>320000UL);
+}
+
+/// status register write/read with crc
+void test_statusreg(void)
+{
+    unsigned char st, crc;
+    unsigned char data[2];
+    shtsim_reset();
+    sht11_init();
+    CHECK(sht_read_statusreg(&st,&crc)==0);
+    CHECK(st==0);
+    data[0] = STATUS_REG_R; data[1] = st;
+    CHECK(crc==sht_crc(data,2));
+    st = 0x04;
+    CHECK(sht_write_statusreg(&st)==0);
+    CHECK(shtsim_status()==0x04);
+    CHECK(sht_read_statusreg(&st,&crc)==0);
+    CHECK(st==0x04);
+    // corrupted checksum is detected
+    shtsim_crc_fault(1);
+    CHECK(sht_read_statusreg(&st,&crc)!=0);
+    CHECK(sht_read_statusreg(&st,&crc)==0);
+}
+
+/// soft reset clears status and blocks commands for 11ms
+void test_softreset(void)
+{
+    unsigned int v;
+    unsigned char st = 0x04;
+    shtsim_reset();
+    sht11_init();
+    CHECK(sht_write_statusreg(&st)==0);
+    CHECK(sht_softreset()==0);
+    CHECK(shtsim_status()==0);
+    CHECK(sht_measure_start(TEMP)!=0); // sensor still resetting
+    shtsim_delay(11000);
+    CHECK(sht_measure_check(&v,TEMP)==0);
+}
+
+/// connection reset after interrupted readout
+void test_connectionreset(void)
+{
+    unsigned int v;
+    shtsim_reset();
+    sht11_init();
+    CHECK(sht_measure_start(TEMP)==0);
+    while (!sht_measure_test_done()) shtsim_delay(100);
+    sht_read_byte(1); // read MSB only, then leave
+    sht_connectionreset();
+    CHECK(sht_measure_check(&v,HUMI)==0);
+    CHECK(v==1500);
+}
+
+/// low resolution mode (status register, crc seed, conversion time)
+void test_resolution(void)
+{
+    unsigned int v;
+    unsigned char st, crc;
+    unsigned char data[2];
+    uint64_t t;
+    shtsim_reset();
+    sht11_init();
+    shtsim_set_values(0x3ABC,0x0DEF);
+    CHECK(sht_get_resolution()==SHT_RES_HIGH);
+    CHECK(sht_set_resolution(SHT_RES_LOW)==0);
+    CHECK(sht_get_resolution()==SHT_RES_LOW);
+    CHECK(shtsim_status()==STATUS_LOWRES);
+    CHECK(sht_read_statusreg(&st,&crc)==0);
+    data[0] = STATUS_REG_R; data[1] = st;
+    CHECK(crc==sht_crc(data,2)); // crc starts with status nibble
+    t = shtsim_time();
+    CHECK(sht_measure_check(&v,TEMP)==0);
+    CHECK(v==0x0ABC);
+    CHECK(sht_measure_check(&v,HUMI)==0);
+    CHECK(v==0x00EF);
+    CHECK(shtsim_time()-t<110000UL); // 80+20ms
+    shtsim_crc_fault(1);
+    CHECK(sht_measure_check(&v,TEMP)!=0);
+    CHECK(sht_softreset()==0);
+    CHECK(sht_get_resolution()==SHT_RES_HIGH);
+}
+
+/// sensor not connected
+void test_nosensor(void)
+{
+    unsigned int v;
+    shtsim_reset();
+    shtsim_connect(0);
+    sht11_init();
+    CHECK(sht_measure_check(&v,TEMP)!=0);
+}
+
+/// asynchronous measurement
+void test_async(void)
+{
+    unsigned int v = 0;
+    shtsim_reset();
+    sht11_init();
+    shtsim_set_values(0x1234,0x0ABC);
+    cb_count = 0;
+    CHECK(sht_measure_async(TEMP,callback)==0);
+    CHECK(sht_measure_async(TEMP,callback)!=0); // busy
+    while (!sht_measure_async_done()) if (!shtsim_sleep()) break;
+    CHECK(sht_measure_async_result(&v)==0);
+    CHECK(v==0x1234);
+    CHECK((cb_count==1)&&(cb_error==0)&&(cb_value==0x1234));
+    // corrupted checksum
+    shtsim_crc_fault(1);
+    CHECK(sht_measure_async(HUMI,callback)==0);
+    while (!sht_measure_async_done()) if (!shtsim_sleep()) break;
+    CHECK(sht_measure_async_result(&v)!=0);
+    // sensor not connected .. timeout
+    shtsim_connect(0);
+    CHECK(sht_measure_async(HUMI,callback)!=0);
+    shtsim_connect(1);
+}
+
+/// asynchronous measurement waiting in simulated sleep (measure function for sht_measure_retry)
+unsigned char measure_async_wait(unsigned int *value, unsigned char mode)
+{
+    if (sht_measure_async(mode,0)!=0) return sht_measure_async_result(value);
+    return sht_measure_async_wait(value);
+}
+
+/// error recovery (error classes, recovery actions, retry budget)
+void test_recovery(void)
+{
+    unsigned int v = 0;
+    sht_err_stats_t e;
+    uint64_t t, a;
+    int i;
+
+    shtsim_reset();
+    sht11_init();
+    for (i=0;i<SHT_RETRY_BUDGET;i++) sht_measure_retry(&v,HUMI,sht_measure_check); // full budget
+    sht_clear_err_stats();
+
+    // error classes
+    shtsim_crc_fault(1);
+    CHECK(sht_measure_check(&v,TEMP)==SHT_ERR_CRC);
+    shtsim_ack_fault(1);
+    CHECK(sht_measure_check(&v,TEMP)==SHT_ERR_ACK);
+    shtsim_hang(1);
+    CHECK(sht_measure_check(&v,TEMP)==SHT_ERR_TIMEOUT);
+    CHECK(measure_async_wait(&v,TEMP)==SHT_ERR_TIMEOUT);
+    shtsim_hang(0);
+
+    // crc error .. retry only
+    shtsim_crc_fault(1);
+    CHECK(sht_measure_retry(&v,TEMP,sht_measure_check)==0);
+    CHECK(v==6470);
+    sht_get_err_stats(&e);
+    CHECK((e.crc==1)&&(e.connresets==0)&&(e.softresets==0)&&(e.recovered==1));
+
+    // latched bus (readout left in the middle) .. connection reset
+    CHECK(sht_measure_start(TEMP)==0);
+    while (!sht_measure_test_done()) shtsim_delay(100);
+    sht_read_byte(1);
+    CHECK(sht_measure_retry(&v,HUMI,sht_measure_check)==0);
+    CHECK(v==1500);
+    sht_get_err_stats(&e);
+    CHECK((e.timeout==1)&&(e.connresets==1)&&(e.softresets==0)&&(e.recovered==2));
+
+    // command not acknowledged .. connection reset
+    shtsim_ack_fault(1);
+    CHECK(sht_measure_retry(&v,TEMP,sht_measure_check)==0);
+    sht_get_err_stats(&e);
+    CHECK((e.noack==1)&&(e.connresets==2)&&(e.recovered==3));
+
+    // hung sensor (asynchronous path) .. connection reset is not enough, soft reset,
+    // low resolution restored
+    CHECK(sht_set_resolution(SHT_RES_LOW)==0);
+    sht_clear_err_stats();
+    shtsim_hang(1);
+    CHECK(sht_measure_retry(&v,TEMP,measure_async_wait)==0);
+    CHECK(v==(6470&0x0FFF));
+    sht_get_err_stats(&e);
+    CHECK((e.timeout==2)&&(e.connresets==1)&&(e.softresets==1)&&(e.recovered==1));
+    CHECK(shtsim_status()==STATUS_LOWRES);
+    CHECK(sht_get_resolution()==SHT_RES_LOW);
+    CHECK(sht_measure_retry(&v,TEMP,sht_measure_check)==0); // budget refill
+    CHECK(sht_measure_retry(&v,TEMP,sht_measure_check)==0);
+    CHECK(sht_measure_retry(&v,TEMP,sht_measure_check)==0);
+
+    // sensor gone .. retries until the budget is spent, then one attempt per measurement
+    sht_clear_err_stats();
+    shtsim_connect(0);
+    t = shtsim_time(); a = shtsim_active();
+    for (i=0;i<20;i++) CHECK(sht_measure_retry(&v,TEMP,sht_measure_check)==SHT_ERR_ACK);
+    sht_get_err_stats(&e);
+    CHECK((e.failed==20)&&(e.noack==20+SHT_RETRY_BUDGET));
+    printf("20 measurements without sensor: %llu cycles, %llu active\n",
+           (unsigned long long)(shtsim_time()-t),(unsigned long long)(shtsim_active()-a));
+    // sensor back .. first measurement good, no retry
+    shtsim_connect(1);
+    CHECK(sht_measure_retry(&v,TEMP,sht_measure_check)==0);
+    sht_get_err_stats(&e);
+    CHECK(e.recovered==0);
+    CHECK(sht_set_resolution(SHT_RES_HIGH)==0);
+}
+
+/// multi-sensor bus (4 sensors, one not connected)
+void test_multi(void)
+{
+    sht_bus_t bus;
+    uint8_t ch;
+    shtsim_reset();
+    for (ch=0;ch<4;ch++) shtsim_set_values_ch(ch,0x1000+ch,0x0200+ch);
+    shtsim_connect_ch(2,0);
+    shtm_init(&bus,0x0F);
+    CHECK(shtm_measure_check(&bus,TEMP)==0x04);
+    CHECK((bus.value[0]==0x1000)&&(bus.value[1]==0x1001)&&(bus.value[3]==0x1003));
+    CHECK(shtm_measure_check(&bus,HUMI)==0x04);
+    CHECK((bus.value[0]==0x0200)&&(bus.value[1]==0x0201)&&(bus.value[3]==0x0203));
+    // low resolution on all sensors (crc start value from status register)
+    shtsim_connect_ch(2,1);
+    CHECK(shtm_write_statusreg(&bus,STATUS_LOWRES)==0);
+    CHECK(shtsim_status_ch(3)==STATUS_LOWRES);
+    CHECK(shtm_measure_check(&bus,HUMI)==0);
+    CHECK(bus.value[2]==0x0002);
+    CHECK(shtm_softreset(&bus)==0);
+    CHECK(shtsim_status_ch(1)==0);
+}
+
+#ifdef SHT_PROF
+/// profiling stats (phase counts, durations from simulated Timer_A)
+void test_prof(void)
+{
+    unsigned int v;
+    prof_stat_t s, c2;
+    int c;
+    char line[PROF_PHASES*36+2];
+    unsigned int i, n = 0;
+    shtsim_reset();
+    sht11_init();
+    prof_reset();
+    CHECK(sht_measure_check(&v,TEMP)==0);
+    prof_get(PROF_TRANSSTART,&s);
+    CHECK((s.count==1)&&(s.min==s.max));
+    prof_get(PROF_WRITE_BYTE,&s);
+    CHECK(s.count==1);
+    prof_get(PROF_READ,&s);
+    CHECK(s.count==1);
+    prof_get(PROF_WAIT,&s);
+    CHECK((s.count==1)&&(s.max*PROF_TICK_CYCLES>=SHTSIM_CONV14-1000));
+    CHECK(sht_measure_async(HUMI,0)==0);
+    while (!sht_measure_async_done()) if (!shtsim_sleep()) break;
+    prof_get(PROF_READ_ISR,&s);
+#ifdef SHT_SPI
+    CHECK(s.count==1); // whole readout in DATA interrupt
+#else
+    CHECK(s.count==3*9*2); // 3 bytes, 9 clocks, 2 edges
+#endif
+    CHECK((s.min<=s.sum/s.count)&&(s.sum/s.count<=s.max));
+    // conversion timeout interrupt counted too
+    shtsim_hang(1);
+    CHECK(measure_async_wait(&v,TEMP)==SHT_ERR_TIMEOUT);
+    shtsim_hang(0);
+    prof_get(PROF_READ_ISR,&c2);
+    CHECK(c2.count==s.count+1);
+    sht11_init();
+    // byte transfer (cycles, the CPU is active all the time)
+    prof_get(PROF_WRITE_BYTE,&s);
+    printf("%s transport (modelled, %d cycles per pin access): write byte %lu cycles",SHT_TRANSPORT,SHTSIM_OP_CYCLES,s.sum/s.count*PROF_TICK_CYCLES);
+    prof_get(PROF_READ_BYTE,&s);
+    CHECK(s.count==3);
+    printf(", read byte %lu cycles\n",s.sum/s.count*PROF_TICK_CYCLES);
+    // dump (uart tx source)
+    CHECK(prof_dump_start()==0);
+    CHECK(prof_dump_start()!=0);
+    while ((c=prof_dump_getc())>=0) putchar(c);
+    CHECK(prof_dump_start()==0);
+    while (prof_dump_getc()>=0);
+    // mean of a phase with sum over 2^29 ticks (long running board)
+    prof_reset();
+    for (i=0;i<20000;i++) prof_add(PROF_WAIT,40000);
+    CHECK(prof_dump_start()==0);
+    while ((c=prof_dump_getc())>=0) if (n<sizeof(line)-1) line[n++] = c;
+    line[n] = 0;
+    CHECK(strstr(line,"P2,4E20,0004E200,0004E200,0004E200\n")!=0);
+    prof_reset();
+}
+#endif
+
+/// measurement timing (blocking and asynchronous)
+void timing(void)
+{
+    unsigned int v;
+    uint64_t t, a;
+
+    shtsim_reset();
+    sht11_init();
+    t = shtsim_time(); a = shtsim_active();
+    sht_measure_check(&v,TEMP);
+    printf("%s transport (modelled, %d cycles per pin access, 1MHz)\n",SHT_TRANSPORT,SHTSIM_OP_CYCLES);
+    printf("sht_measure_check(TEMP): %8llu cycles, %8llu active\n",
+           (unsigned long long)(shtsim_time()-t),(unsigned long long)(shtsim_active()-a));
+    t = shtsim_time(); a = shtsim_active();
+    sht_measure_check(&v,HUMI);
+    printf("sht_measure_check(HUMI): %8llu cycles, %8llu active\n",
+           (unsigned long long)(shtsim_time()-t),(unsigned long long)(shtsim_active()-a));
+    t = shtsim_time(); a = shtsim_active();
+    sht_measure_async(TEMP,0);
+    while (!sht_measure_async_done()) if (!shtsim_sleep()) break;
+    printf("sht_measure_async(TEMP): %8llu cycles, %8llu active\n",
+           (unsigned long long)(shtsim_time()-t),(unsigned long long)(shtsim_active()-a));
+
+    sht_bus_t bus;
+    shtsim_reset();
+    shtm_init(&bus,0xFF);
+    t = shtsim_time(); a = shtsim_active();
+    shtm_measure_check(&bus,TEMP);
+    printf("shtm_measure_check(TEMP), 8 sensors: %8llu cycles, %8llu active\n",
+           (unsigned long long)(shtsim_time()-t),(unsigned long long)(shtsim_active()-a));
+}
+
+/// test body
+int main(void)
+{
+    test_measure();
+    test_statusreg();
+    test_softreset();
+    test_connectionreset();
+    test_resolution();
+    test_nosensor();
+    test_async();
+    test_recovery();
+    test_multi();
+#ifdef SHT_PROF
+    test_prof();
+#endif
+
+    timing();
+
+    printf("%d tests, %d failed\n",tests,failed);
+    return (failed!=0);
+}
@@ -0,0 +1,600 @@
+/*
+ * shtsim.c
+ *
+ *  Created on: 17.10.2026
+ *      Author: agent
+ *
+ *  Host side simulator of SHT11 Sensibus slave
+ *
+ *  interface functions:
+ *
+ *      shtsim_reset() .. power-on reset
+ *      shtsim_set_values(tR,hR) .. values returned by measurements
+ *      shtsim_connect(present) .. connect/disconnect sensor
+ *      shtsim_status() .. status register
+ *      shtsim_crc_fault(count) .. corrupt checksum of next count transmissions
+ *      shtsim_ack_fault(count) .. don't acknowledge next count commands
+ *      shtsim_hang(on) .. conversions never finish (until soft reset)
+ *      shtsim_..._ch(ch,..) .. the same for sensor on DATA line ch (multi-sensor bus)
+ *      shtsim_sleep() .. sleep until next event (runs interrupt routines)
+ *      shtsim_time(), shtsim_active(), shtsim_transstarts() .. statistics
+ *      shtsim_tar() .. Timer_A counter (SMCLK/8, profiling timestamps, prof.h)
+ *
+ *  hal functions (called by sht11.c through sht11hal.h):
+ *
+ *      shtsim_port_init(), shtsim_data_out(x), shtsim_data_in(), shtsim_sck(x),
+ *      shtsim_delay(cycles), shtsim_irq(on), shtsim_irq_force(), shtsim_timer(period)
+ *      shtsim_mport_init(mask), shtsim_mdata_out(mask,low), shtsim_mdata_in() .. multi-sensor bus
+ *      shtsim_spi_init(br), shtsim_spi_on(out), shtsim_spi_off(), shtsim_spi_tx(x),
+ *      shtsim_spi_done(), shtsim_spi_rx() .. USCI_B0 byte transport (SHT_SPI)
+ *
+ *  up to 8 sensors share one SCK, sensor n uses DATA line n (line 0 is single sensor DATA)
+ *
+ */
+
+#include <string.h>
+
+#include "../../sht11hal.h" // hal functions
+#include "shtsim.h" // self
+
+/// sht commands (see sht11.h)
+#define CMD_STATUS_W 0x06
+#define CMD_STATUS_R 0x07
+#define CMD_TEMP 0x03
+#define CMD_HUMI 0x05
+#define CMD_RESET 0x1E
+
+/// interrupt routines (sht11.c)
+void Port_2(void);
+void Timer1_A0(void);
+
+/// sensor interface states
+enum {S_IDLE,S_CMD,S_WRST,S_CONVERT,S_TX};
+
+/// number of simulated sensors (DATA lines, shared SCK)
+#define SENSORS 8
+
+/// sensor state
+typedef struct {
+    uint8_t present;
+    uint16_t tR, hR;
+    uint8_t status;
+    uint8_t state;
+    uint8_t ts;         // transmission start detection phase
+    uint8_t bit;
+    uint8_t rx;         // received byte
+    uint8_t cmd;
+    uint8_t tx[3];      // bytes to transmit
+    uint8_t txlen, txpos;
+    uint8_t ack;        // master ACK
+    uint64_t busy;      // end of conversion or soft reset
+    uint8_t slave_low;  // sensor pulls DATA down
+    uint32_t transstarts;
+    uint8_t crc_faults; // transmissions with corrupted checksum to come
+    uint8_t ack_faults; // commands not acknowledged to come
+    uint8_t hang;       // conversions never finish (cleared by soft reset)
+} sensor_t;
+
+/// simulator state
+struct {
+    sensor_t s[SENSORS];
+    // lines (mcu_low bit n .. MCU pulls DATA line n down)
+    uint8_t mcu_low, sck;
+    // mcu
+    uint8_t irq_ie, irq_ifg;
+    uint32_t timer;     // timer period (ACLK ticks, 0 stopped)
+    uint64_t timer_next;
+    uint8_t timer_ifg;
+    // USCI_B0 (SPI master on single sensor lines): pins handed over, SIMO drives DATA,
+    // clock divider, received byte, done flag
+    uint8_t spi_on, spi_out, spi_br, spi_rx, spi_ifg;
+    // statistics
+    uint64_t now, active;
+} sim;
+
+/** local functions */
+
+/// DATA line n (pullup, open drain on both sides)
+static uint8_t wire(uint8_t n)
+{
+    return (((sim.mcu_low>>n)&1)||sim.s[n].slave_low)?0:1;
+}
+
+/// all DATA lines (bit n .. line n)
+static uint8_t wires(void)
+{
+    uint8_t n, w = 0;
+    for (n=0;n<SENSORS;n++) w |= wire(n)<<n;
+    return w;
+}
+
+/// sensor CRC (datasheet: init by reversed status nibble, poly x^8+x^5+x^4+1, result reversed)
+static uint8_t rev8(uint8_t b)
+{
+    uint8_t r=0, i;
+    for (i=0;i<8;i++) { r=(r<<1)|(b&1); b>>=1; }
+    return r;
+}
+
+static uint8_t crc(sensor_t *s, const uint8_t *data, uint8_t len)
+{
+    uint8_t c = rev8(s->status&0x0F);
+    uint8_t i;
+    while (len--)
+    {
+        c ^= *data++;
+        for (i=0;i<8;i++) c = (c&0x80)?((c<<1)^0x31):(c<<1);
+    }
+    return rev8(c);
+}
+
+/// present transmitted bit on DATA
+static void tx_bit(sensor_t *s)
+{
+    s->slave_low = (s->tx[s->txpos]&(0x80>>s->bit))?0:1;
+}
+
+/// start transmission of prepared bytes (crc of command and bytes appended)
+static void tx_start(sensor_t *s, uint8_t len)
+{
+    uint8_t buf[3] = {s->cmd,s->tx[0],s->tx[1]};
+    s->tx[len] = crc(s,buf,len+1);
+    if (s->crc_faults) { s->crc_faults--; s->tx[len] ^= 0x01; }
+    s->txlen = len+1;
+    s->txpos = 0;
+    s->bit = 0;
+    s->state = S_TX;
+    tx_bit(s);
+}
+
+/// process elapsed time (conversion done, timer)
+static void process_time(void)
+{
+    uint8_t n;
+    for (n=0;n<SENSORS;n++)
+    {
+        sensor_t *s = &sim.s[n];
+        if ((s->state==S_CONVERT)&&(sim.now>=s->busy))
+        {
+            uint8_t lowres = s->status&0x01;
+            uint16_t v;
+            if (s->cmd==CMD_TEMP) v = s->tR & (lowres?0x0FFF:0x3FFF);
+            else v = s->hR & (lowres?0x00FF:0x0FFF);
+            s->tx[0] = v>>8;
+            s->tx[1] = v;
+            uint8_t w = wire(n);
+            tx_start(s,2); // MSB bit 7 is 0 - pulls DATA down (measurement ready)
+            if ((n==0)&&w&&!wire(n)) sim.irq_ifg = 1;
+        }
+    }
+    if (sim.timer && (sim.now>=sim.timer_next))
+    {
+        sim.timer_ifg = 1;
+        while (sim.timer_next<=sim.now) sim.timer_next += (uint64_t)sim.timer*SHTSIM_ACLK_CYCLES;
+    }
+}
+
+/// spend CPU cycles
+static void spend(uint64_t cycles)
+{
+    sim.now += cycles;
+    sim.active += cycles;
+    process_time();
+}
+
+/// command decoded (after 8 bits), returns 1 if command is acknowledged
+static uint8_t command(uint8_t c)
+{
+    switch (c)
+    {
+        case CMD_TEMP: case CMD_HUMI: case CMD_STATUS_R: case CMD_STATUS_W: case CMD_RESET: return 1;
+        default: break;
+    }
+    return 0;
+}
+
+/// command acknowledged (after 9th clock)
+static void execute(sensor_t *s)
+{
+    if (s->state==S_WRST)
+    {
+        s->status = (s->status&~0x07)|(s->rx&0x07);
+        s->state = S_IDLE;
+        return;
+    }
+    s->cmd = s->rx;
+    switch (s->cmd)
+    {
+        case CMD_TEMP:
+            s->busy = sim.now + ((s->status&0x01)?SHTSIM_CONV12:SHTSIM_CONV14);
+            s->state = s->hang ? S_IDLE : S_CONVERT; // hung sensor keeps DATA high
+            break;
+        case CMD_HUMI:
+            s->busy = sim.now + ((s->status&0x01)?SHTSIM_CONV8:SHTSIM_CONV12);
+            s->state = s->hang ? S_IDLE : S_CONVERT;
+            break;
+        case CMD_STATUS_R:
+            s->tx[0] = s->status;
+            tx_start(s,1);
+            break;
+        case CMD_STATUS_W:
+            s->state = S_WRST;
+            s->bit = 0;
+            s->rx = 0;
+            break;
+        case CMD_RESET:
+            s->status = 0;
+            s->hang = 0;
+            s->busy = sim.now + SHTSIM_RESET;
+            s->state = S_IDLE;
+            break;
+        default:
+            s->state = S_IDLE;
+            break;
+    }
+}
+
+/// transmission start detected
+static void transstart(sensor_t *s)
+{
+    s->transstarts++;
+    s->slave_low = 0;
+    s->state = S_IDLE;
+    if (sim.now<s->busy) return; // soft reset in progress
+    s->state = S_CMD;
+    s->bit = 0;
+    s->rx = 0;
+}
+
+/// line change seen by one sensor (old values of SCK and its DATA line)
+static void sensor_lines(uint8_t n, uint8_t osck, uint8_t owire)
+{
+    sensor_t *s = &sim.s[n];
+    uint8_t w = wire(n);
+
+    if (!s->present) return;
+
+    // transmission start detection
+    if (osck==sim.sck)
+    {
+        if (sim.sck && (owire!=w))
+        {
+            if (!w) s->ts = 1;
+            else if (s->ts==3) { s->ts = 0; transstart(s); return; }
+            else s->ts = 0;
+        }
+        return;
+    }
+    if (!sim.sck) s->ts = (s->ts==1)?2:0;
+    else s->ts = ((s->ts==2)&&!w)?3:0;
+
+    if (sim.sck) // rising edge
+    {
+        switch (s->state)
+        {
+            case S_CMD: case S_WRST:
+                if (s->bit<8) { s->rx = (s->rx<<1)|w; s->bit++; }
+                break;
+            case S_TX:
+                if (s->bit==8) s->ack = !w;
+                break;
+            default:
+                break;
+        }
+        return;
+    }
+
+    // falling edge
+    switch (s->state)
+    {
+        case S_CMD: case S_WRST:
+            if (s->bit==8)
+            {
+                if ((s->state==S_CMD)&&!command(s->rx)) { s->state = S_IDLE; break; }
+                if ((s->state==S_CMD)&&s->ack_faults) { s->ack_faults--; s->state = S_IDLE; break; }
+                s->slave_low = 1; // ACK
+                s->bit = 9;
+            }
+            else if (s->bit==9)
+            {
+                s->slave_low = 0;
+                execute(s);
+            }
+            break;
+        case S_TX:
+            if (s->bit<8)
+            {
+                s->bit++;
+                if (s->bit<8) tx_bit(s);
+                else s->slave_low = 0; // release for master ACK
+            }
+            else
+            {
+                s->txpos++;
+                if (s->ack && (s->txpos<s->txlen)) { s->bit = 0; tx_bit(s); }
+                else { s->slave_low = 0; s->state = S_IDLE; }
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+/// line change (old values of SCK and DATA lines)
+static void lines(uint8_t osck, uint8_t owires)
+{
+    uint8_t n;
+    if ((owires&0x01) && !wire(0)) sim.irq_ifg = 1; // falling edge flag (line 0 only)
+    for (n=0;n<SENSORS;n++) sensor_lines(n,osck,(owires>>n)&1);
+}
+
+/// run pending interrupt routines (returns 1 if any)
+static uint8_t dispatch(void)
+{
+    uint8_t ret = 0;
+    if (sim.irq_ie && sim.irq_ifg)
+    {
+        spend(SHTSIM_ISR_CYCLES);
+        Port_2();
+        ret = 1;
+    }
+    if (sim.timer_ifg)
+    {
+        sim.timer_ifg = 0;
+        spend(SHTSIM_ISR_CYCLES);
+        Timer1_A0();
+        ret = 1;
+    }
+    return ret;
+}
+
+/** interface functions */
+
+void shtsim_reset(void)
+{
+    uint8_t n;
+    memset(&sim,0,sizeof(sim));
+    for (n=0;n<SENSORS;n++)
+    {
+        sim.s[n].present = 1;
+        sim.s[n].tR = 6470; // 25 C
+        sim.s[n].hR = 1500;
+    }
+}
+
+void shtsim_set_values(uint16_t tR, uint16_t hR)
+{
+    shtsim_set_values_ch(0,tR,hR);
+}
+
+void shtsim_set_values_ch(uint8_t ch, uint16_t tR, uint16_t hR)
+{
+    sim.s[ch].tR = tR;
+    sim.s[ch].hR = hR;
+}
+
+void shtsim_connect(uint8_t present)
+{
+    shtsim_connect_ch(0,present);
+}
+
+void shtsim_connect_ch(uint8_t ch, uint8_t present)
+{
+    sensor_t *s = &sim.s[ch];
+    s->present = present;
+    if (!present) { s->slave_low = 0; s->state = S_IDLE; }
+}
+
+uint8_t shtsim_status(void)
+{
+    return shtsim_status_ch(0);
+}
+
+void shtsim_crc_fault(uint8_t count)
+{
+    sim.s[0].crc_faults = count;
+}
+
+void shtsim_ack_fault(uint8_t count)
+{
+    sim.s[0].ack_faults = count;
+}
+
+void shtsim_hang(uint8_t on)
+{
+    sim.s[0].hang = on;
+}
+
+uint8_t shtsim_status_ch(uint8_t ch)
+{
+    return sim.s[ch].status;
+}
+
+uint8_t shtsim_sleep(void)
+{
+    uint8_t n;
+
+    if (dispatch()) return 1;
+
+    uint64_t next = 0;
+    for (n=0;n<SENSORS;n++)
+        if ((sim.s[n].state==S_CONVERT) && ((next==0)||(sim.s[n].busy<next))) next = sim.s[n].busy;
+    if (sim.timer && ((next==0)||(sim.timer_next<next))) next = sim.timer_next;
+    if (next==0) return 0;
+    if (next>sim.now) sim.now = next;
+    process_time();
+    dispatch();
+    return 1;
+}
+
+uint64_t shtsim_time(void)
+{
+    return sim.now;
+}
+
+unsigned int shtsim_tar(void)
+{
+    return (unsigned int)(sim.now>>3)&0xFFFF; // Timer_A SMCLK/8
+}
+
+uint64_t shtsim_active(void)
+{
+    return sim.active;
+}
+
+uint32_t shtsim_transstarts(void)
+{
+    return sim.s[0].transstarts;
+}
+
+/** hal functions */
+
+void shtsim_port_init(void)
+{
+    uint8_t osck = sim.sck, ow = wires();
+    sim.mcu_low |= 0x01; // P2DIR|=0x03, P2OUT&=~0x03 (DATA driven low)
+    sim.sck = 0;
+    spend(2*SHTSIM_OP_CYCLES);
+    lines(osck,ow);
+}
+
+void shtsim_data_out(unsigned char x)
+{
+    uint8_t ow = wires();
+    if (x!=0) sim.mcu_low |= 0x01; else sim.mcu_low &= ~0x01;
+    spend(SHTSIM_OP_CYCLES);
+    lines(sim.sck,ow);
+}
+
+unsigned char shtsim_data_in(void)
+{
+    spend(SHTSIM_OP_CYCLES);
+    return wire(0);
+}
+
+void shtsim_sck(unsigned char x)
+{
+    uint8_t osck = sim.sck;
+    sim.sck = (x!=0);
+    spend(SHTSIM_OP_CYCLES);
+    lines(osck,wires());
+}
+
+void shtsim_delay(unsigned long cycles)
+{
+    spend(cycles);
+}
+
+void shtsim_irq(unsigned char on)
+{
+    sim.irq_ie = on;
+    sim.irq_ifg = 0;
+    spend(3*SHTSIM_OP_CYCLES);
+}
+
+void shtsim_irq_force(void)
+{
+    sim.irq_ifg = 1;
+    spend(SHTSIM_OP_CYCLES);
+}
+
+void shtsim_timer(unsigned int period)
+{
+    sim.timer = period;
+    sim.timer_ifg = 0;
+    sim.timer_next = sim.now + (uint64_t)period*SHTSIM_ACLK_CYCLES;
+    spend(3*SHTSIM_OP_CYCLES);
+}
+
+void shtsim_mport_init(unsigned char mask)
+{
+    uint8_t osck = sim.sck, ow = wires();
+    sim.mcu_low &= ~mask; // DATA lines released
+    sim.sck = 0;
+    spend(4*SHTSIM_OP_CYCLES);
+    lines(osck,ow);
+}
+
+void shtsim_mdata_out(unsigned char mask, unsigned char low)
+{
+    uint8_t ow = wires();
+    sim.mcu_low = (sim.mcu_low&~mask)|(low&mask);
+    spend(2*SHTSIM_OP_CYCLES);
+    lines(sim.sck,ow);
+}
+
+unsigned char shtsim_mdata_in(void)
+{
+    spend(SHTSIM_OP_CYCLES);
+    return wires();
+}
+
+/** USCI_B0 (SHT_SPI transport) */
+
+void shtsim_spi_init(unsigned char br)
+{
+    sim.spi_br = br ? br : 1;
+    sim.spi_ifg = 0;
+    spend(8*SHTSIM_OP_CYCLES);
+}
+
+void shtsim_spi_on(unsigned char out)
+{
+    uint8_t ow = wires();
+    sim.mcu_low &= ~0x01; // DATA pin released (SCK pin released, UCB0CLK idles low)
+    sim.spi_on = 1;
+    sim.spi_out = out;
+    spend(5*SHTSIM_OP_CYCLES);
+    lines(sim.sck,ow);
+}
+
+void shtsim_spi_off(void)
+{
+    uint8_t ow = wires();
+    if (sim.spi_out) sim.mcu_low &= ~0x01; // SIMO released
+    sim.spi_on = 0;
+    spend(5*SHTSIM_OP_CYCLES);
+    lines(sim.sck,ow);
+}
+
+/// 8 clocks, SIMO changes on falling edge (first bit before), SOMI sampled on rising edge
+void shtsim_spi_tx(unsigned char x)
+{
+    uint8_t i, ow, rx = 0;
+    spend(SHTSIM_OP_CYCLES);
+    if (!sim.spi_on) return;
+    for (i=0;i<8;i++)
+    {
+        ow = wires();
+        if (sim.spi_out)
+        {
+            if (x&(0x80>>i)) sim.mcu_low &= ~0x01;
+            else sim.mcu_low |= 0x01;
+        }
+        lines(sim.sck,ow);
+        ow = wires();
+        sim.sck = 1;
+        spend(sim.spi_br/2);
+        lines(0,ow);
+        rx = (rx<<1)|wire(0);
+        ow = wires();
+        sim.sck = 0;
+        spend(sim.spi_br-sim.spi_br/2);
+        lines(1,ow);
+    }
+    sim.spi_rx = rx;
+    sim.spi_ifg = 1;
+}
+
+unsigned char shtsim_spi_done(void)
+{
+    spend(SHTSIM_OP_CYCLES);
+    return sim.spi_ifg;
+}
+
+unsigned char shtsim_spi_rx(void)
+{
+    spend(SHTSIM_OP_CYCLES);
+    sim.spi_ifg = 0;
+    return sim.spi_rx;
+}
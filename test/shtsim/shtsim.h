@@ -0,0 +1,71 @@
+/*
+ * shtsim.h
+ *
+ *  Created on: 17.10.2026
+ *      Author: agent
+ *
+ *  Host side simulator of SHT11 Sensibus slaves (and of the MCU pins they are wired to)
+ *
+ *  sht11.c built with SHT_HOST calls the pin/delay functions of this module
+ *  (see sht11hal.h). Time is counted in MCU cycles (1MHz, so 1 cycle = 1us).
+ *  Every pin access costs SHTSIM_OP_CYCLES (approx. MSP430 bit instruction).
+ *
+ *  simulated: transmission start detection, command ACK, conversion latency
+ *  per resolution, measurement/status readout with CRC, status register,
+ *  soft reset (11ms), connection reset, DATA interrupt and Timer1_A (ACLK),
+ *  faults (checksum, command acknowledge, hung conversion), USCI_B0 byte transport (SHT_SPI)
+ *
+ */
+
+#ifndef __SHTSIM_H__
+#define __SHTSIM_H__
+
+#include <inttypes.h>
+
+/// cycles per pin access
+#define SHTSIM_OP_CYCLES 5
+/// cycles per interrupt entry and exit
+#define SHTSIM_ISR_CYCLES 11
+/// cycles per ACLK tick (VLO 12kHz, MCLK 1MHz)
+#define SHTSIM_ACLK_CYCLES 83
+
+/// conversion time (cycles) 14bit/12bit/8bit
+#define SHTSIM_CONV14 320000UL
+#define SHTSIM_CONV12 80000UL
+#define SHTSIM_CONV8 20000UL
+/// soft reset time (cycles)
+#define SHTSIM_RESET 11000UL
+
+/// power-on reset of the simulator (sensor present, status 0)
+void shtsim_reset(void);
+/// set register values the sensor measures (masked to current resolution)
+void shtsim_set_values(uint16_t tR, uint16_t hR);
+/// connect/disconnect the sensor
+void shtsim_connect(uint8_t present);
+/// sensor status register
+uint8_t shtsim_status(void);
+/// corrupt checksum of next count transmissions
+void shtsim_crc_fault(uint8_t count);
+/// don't acknowledge next count commands (corrupted command bits)
+void shtsim_ack_fault(uint8_t count);
+/// sensor hangs - acknowledges measurements, but never finishes them (soft reset clears it)
+void shtsim_hang(uint8_t on);
+
+/// the same for sensor on DATA line ch (0..7, multi-sensor bus)
+void shtsim_set_values_ch(uint8_t ch, uint16_t tR, uint16_t hR);
+void shtsim_connect_ch(uint8_t ch, uint8_t present);
+uint8_t shtsim_status_ch(uint8_t ch);
+
+/// sleep (LPM) until next event and run interrupt routines (0 nothing to wait for)
+uint8_t shtsim_sleep(void);
+
+/// simulated time (cycles)
+uint64_t shtsim_time(void);
+/// cycles the CPU was active (pin access, delays, interrupts)
+uint64_t shtsim_active(void);
+/// Timer_A counter (SMCLK/8, timestamps of prof.h)
+unsigned int shtsim_tar(void);
+/// count of transmission starts seen by sensor
+uint32_t shtsim_transstarts(void);
+
+#endif
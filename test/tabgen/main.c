@@ -0,0 +1,158 @@
+/*
+ * tabgen - lookup table generator for sht2int table engine (SHT_CONV_TABLE)
+ *
+ *  usage: tabgen [output_file [dew_file]] (default ../../sht11tab.h ../../sht11dew.h)
+ *
+ *  tables are computed from sht11con.h constants:
+ *      temperature table .. T*10 (Q4) at every 64th 14bit register value
+ *      linear RH table .. RH*10 (Q4) at every 64th 12bit register value
+ *      compensation table .. RH temp. compensation *10 (Q4) at every 64th temp. register value
+ *  values between table points are linearly interpolated
+ *
+ *  dew point / absolute humidity tables (sht_dewpoint, sht_abshum, log2 domain Q11):
+ *      log2(1+i/32), 2^(i/32) (Q12) .. mantissa of log2(RH) and 2^x
+ *      Magnus b*T/(c+T) / ln2 at T*10 = -400+32*i
+ *      log2 of saturated vapour density *10 (g/m^3) at T*10 = -400+32*i
+ *      dew point *10 (Q2) at log2 gamma = -15+i/4 (gamma = ln(RH/100) + b*T/(c+T))
+ */
+
+#include <stdio.h>
+#include <math.h>
+#include <inttypes.h>
+
+#include "../../sht11con.h"
+
+/// register value step between table points (must match SHT_TAB_SHIFT)
+#define STEP 64
+
+/// round to Q4 fixed-point
+int16_t q4(double x)
+{
+    x *= 16.0;
+    return (int16_t)((x<0)?(x-0.5):(x+0.5));
+}
+
+/// round to Qn fixed-point
+int16_t qn(double x, int n)
+{
+    x *= (double)(1<<n);
+    return (int16_t)((x<0)?(x-0.5):(x+0.5));
+}
+
+/// write one table
+void put_table(FILE *f, const char *name, const char *desc, int16_t *tab, int len)
+{
+    int i;
+    fprintf(f,"/// %s\n",desc);
+    fprintf(f,"static const int16_t %s[%d] = {",name,len);
+    for (i=0;i<len;i++)
+    {
+        if ((i%8)==0) fprintf(f,"\n   ");
+        fprintf(f," %6d%s",tab[i],(i!=(len-1))?",":"");
+    }
+    fprintf(f,"};\n\n");
+}
+
+/** dew point tables */
+
+/// table lengths (T*10 -400 .. 1250 step 32, log2 gamma -15 .. 9 step 1/4)
+#define DEW_MANT 33
+#define DEW_TEMP 53
+#define DEW_GAMMA 97
+
+/// Magnus exponent b*T/(c+T) (T in C)
+double magnus(double t)
+{
+    return DP_B*t/(DP_C+t);
+}
+
+/// dew point and absolute humidity tables
+int dewgen(const char *fname)
+{
+    int16_t lg[DEW_MANT], pw[DEW_MANT], gt[DEW_TEMP], at[DEW_TEMP], td[DEW_GAMMA];
+    int i;
+
+    for (i=0;i<DEW_MANT;i++)
+    {
+        lg[i] = qn(log2(1.0+i/32.0),11);
+        pw[i] = qn(pow(2.0,i/32.0),12);
+    }
+    for (i=0;i<DEW_TEMP;i++)
+    {
+        double t = (-400+32*i)/10.0;
+        gt[i] = qn(magnus(t)/M_LN2,11);
+        at[i] = qn(log2(10.0*AH_K*DP_E0*exp(magnus(t))/(273.15+t)),11);
+    }
+    for (i=0;i<DEW_GAMMA;i++)
+    {
+        double g = (-15.0+i/4.0)*M_LN2;
+        td[i] = qn(DP_C*g/(DP_B-g)*10.0,2);
+    }
+
+    FILE *f = fopen(fname,"w");
+    if (f==NULL)
+    {
+        printf("Can't open %s\n",fname);
+        return 1;
+    }
+    fprintf(f,"/*\n * sht11dew.h\n *\n *  Generated by test/tabgen from sht11con.h constants - do not edit\n *\n");
+    fprintf(f," *  Dew point and absolute humidity tables (sht_dewpoint, sht_abshum), log2 domain Q11\n */\n\n");
+    fprintf(f,"#ifndef __SHT11DEW_H__\n#define __SHT11DEW_H__\n\n#include <inttypes.h>\n\n");
+    fprintf(f,"/// table ranges (T*10 from -400 step 32, log2 gamma Q11 from -15 step 1/4)\n");
+    fprintf(f,"#define SHT_DEW_T0 (-400)\n#define SHT_DEW_TMAX 1250\n#define SHT_DEW_TSHIFT 5\n");
+    fprintf(f,"#define SHT_DEW_G0 (-15*2048)\n#define SHT_DEW_GMAX (9*2048-1)\n#define SHT_DEW_GSHIFT 9\n\n");
+    put_table(f,"sht_dew_log2","log2(1+i/32) (Q11)",lg,DEW_MANT);
+    put_table(f,"sht_dew_pow2","2^(i/32) (Q12)",pw,DEW_MANT);
+    put_table(f,"sht_dew_gtab","Magnus b*T/(c+T)/ln2 (Q11) at T*10 = -400+32*i",gt,DEW_TEMP);
+    put_table(f,"sht_dew_atab","log2 saturated vapour density*10 g/m^3 (Q11) at T*10 = -400+32*i",at,DEW_TEMP);
+    put_table(f,"sht_dew_tdtab","dew point*10 (Q2) at log2 gamma = -15+i/4",td,DEW_GAMMA);
+    fprintf(f,"#endif\n");
+    fclose(f);
+
+    printf("Tables written to %s (%d bytes)\n",fname,(int)(sizeof(lg)+sizeof(pw)+sizeof(gt)+sizeof(at)+sizeof(td)));
+    return 0;
+}
+
+/// generator body
+int main(int argc, char *argv[])
+{
+    const char *fname = "../../sht11tab.h";
+    int16_t ttab[16384/STEP+1];
+    int16_t rtab[4096/STEP+1];
+    int16_t ctab[16384/STEP+1];
+    int i;
+
+    if (argc>=2) fname = argv[1];
+
+    for (i=0;i<=16384/STEP;i++)
+    {
+        double tR = (double)(i*STEP);
+        double dT = D1 + D2*tR;
+        ttab[i] = q4(dT*10.0);
+        ctab[i] = q4((dT - 25.0) * (T1 - T2*tR) * 10.0);
+    }
+    for (i=0;i<=4096/STEP;i++)
+    {
+        double hR = (double)(i*STEP);
+        rtab[i] = q4((C1 + C2*hR + C3*hR*hR) * 10.0);
+    }
+
+    FILE *f = fopen(fname,"w");
+    if (f==NULL)
+    {
+        printf("Can't open %s\n",fname);
+        return 1;
+    }
+    fprintf(f,"/*\n * sht11tab.h\n *\n *  Generated by test/tabgen from sht11con.h constants - do not edit\n *\n");
+    fprintf(f," *  SHT11 conversion tables for sht2int table engine (SHT_CONV_TABLE)\n */\n\n");
+    fprintf(f,"#ifndef __SHT11TAB_H__\n#define __SHT11TAB_H__\n\n#include <inttypes.h>\n\n");
+    fprintf(f,"/// register value step between table points (1<<SHT_TAB_SHIFT)\n#define SHT_TAB_SHIFT 6\n\n");
+    put_table(f,"sht_ttab","T*10 (Q4) at tR = i*64",ttab,16384/STEP+1);
+    put_table(f,"sht_rtab","linear RH*10 (Q4) at hR = i*64",rtab,4096/STEP+1);
+    put_table(f,"sht_ctab","RH temp. compensation *10 (Q4) at tR = i*64",ctab,16384/STEP+1);
+    fprintf(f,"#endif\n");
+    fclose(f);
+
+    printf("Tables written to %s (%d bytes)\n",fname,(int)(sizeof(ttab)+sizeof(rtab)+sizeof(ctab)));
+    return dewgen((argc==3)?argv[2]:"../../sht11dew.h");
+}
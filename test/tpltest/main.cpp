@@ -0,0 +1,134 @@
+/*
+ * sht11.hpp test - template driver against simulated SHT11 next to the C driver,
+ * compile time constants (delays for 1, 8, 16MHz, checksums), timing (host build, SHT_HOST)
+ */
+
+#include <cstdio>
+#include <cinttypes>
+
+#include "../../sht11.hpp"
+
+extern "C" {
+#include "../shtsim/shtsim.h"
+}
+
+/// test counters
+int tests = 0, failed = 0;
+
+#define CHECK(cond) check((cond),#cond,__LINE__)
+
+void check(int ok, const char *what, int line)
+{
+    tests++;
+    if (ok) return;
+    failed++;
+    printf("FAILED (line %d): %s\n",line,what);
+}
+
+/// board variants (simulated port, DATA pin 0, SCK pin 1)
+typedef Sht11<sht::SimPort,0,1> S1;
+typedef Sht11<sht::SimPort,0,1,8000000UL> S8;
+typedef Sht11<sht::SimPort,0,1,16000000UL,SHT_RES_LOW> S16L;
+typedef Sht11<sht::SimPort,0,1,1048576UL> S1D; // DCO 32 x 32768Hz
+
+/// compile time constants
+void constants(void)
+{
+    unsigned char cmd;
+
+    CHECK((S1::MHZ==1)&&(S8::MHZ==8)&&(S16L::MHZ==16)&&(S1D::MHZ==2));
+    printf("delay cycles (pulse, step, wait loop, reset): ");
+    printf("1MHz %lu/%lu/%lu/%lu, ",S1::PULSE_US*S1::MHZ,S1::STEP_US*S1::MHZ,S1::POLL_US*S1::MHZ,S1::RESET_US*S1::MHZ);
+    printf("8MHz %lu/%lu/%lu/%lu, ",S8::PULSE_US*S8::MHZ,S8::STEP_US*S8::MHZ,S8::POLL_US*S8::MHZ,S8::RESET_US*S8::MHZ);
+    printf("16MHz %lu/%lu/%lu/%lu\n",S16L::PULSE_US*S16L::MHZ,S16L::STEP_US*S16L::MHZ,S16L::POLL_US*S16L::MHZ,S16L::RESET_US*S16L::MHZ);
+    CHECK(S16L::PULSE_US*S16L::MHZ==80);
+
+    CHECK((S1::DATA==0x01)&&(S1::SCK==0x02));
+    CHECK((S1::STATUS==0)&&(S16L::STATUS==STATUS_LOWRES));
+    CHECK((S1::TIMEOUT_TEMP==SHT_TIMEOUT_14BIT)&&(S16L::TIMEOUT_HUMI==SHT_TIMEOUT_8BIT));
+
+    // command checksums against C driver crc
+    cmd = MEASURE_TEMP; CHECK(S1::CRC_TEMP==sht_crc_status(0,&cmd,1));
+    cmd = MEASURE_HUMI; CHECK(S1::CRC_HUMI==sht_crc_status(0,&cmd,1));
+    cmd = MEASURE_HUMI; CHECK(S16L::CRC_HUMI==sht_crc_status(STATUS_LOWRES,&cmd,1));
+    cmd = STATUS_REG_R; CHECK(S16L::CRC_STATUS==sht_crc_status(STATUS_LOWRES,&cmd,1));
+}
+
+/// measurements, errors, recovery
+void measure(void)
+{
+    unsigned int v = 0;
+    unsigned char s = 0xFF;
+
+    shtsim_reset();
+    CHECK(S1::init()==0);
+    shtsim_set_values(0x1A2B,0x0ABC);
+    CHECK((S1::measure<TEMP>(v)==0)&&(v==0x1A2B));
+    CHECK((S8::measure(v,HUMI)==0)&&(v==0x0ABC));
+    CHECK((S1::read_status(s)==0)&&(s==0));
+
+    // without waiting
+    CHECK(S1::start(HUMI)==0);
+    CHECK(S1::done()==0);
+    while (!S1::done()) shtsim_delay(100);
+    CHECK((S1::read(v,HUMI)==0)&&(v==0x0ABC));
+
+    // C driver on the same sensor (the same values)
+    sht11_init();
+    CHECK((sht_measure_check(&v,TEMP)==0)&&(v==0x1A2B));
+    CHECK((S1::measure<TEMP>(v)==0)&&(v==0x1A2B));
+
+    // errors
+    shtsim_crc_fault(1);
+    CHECK(S1::measure<TEMP>(v)==SHT_ERR_CRC);
+    shtsim_ack_fault(1);
+    CHECK(S1::measure<HUMI>(v)==SHT_ERR_ACK);
+    shtsim_hang(1);
+    CHECK(S1::measure<TEMP>(v)==SHT_ERR_TIMEOUT);
+    CHECK(S1::reset()==0);
+    CHECK((S1::measure<TEMP>(v)==0)&&(v==0x1A2B));
+    shtsim_connect(0);
+    CHECK(S1::measure<TEMP>(v)==SHT_ERR_ACK);
+    shtsim_connect(1);
+    S1::connection_reset();
+    CHECK(S1::measure<TEMP>(v)==0);
+
+    // low resolution (status written by init, kept by reset, crc starts with status)
+    CHECK(S16L::init()==0);
+    CHECK(shtsim_status()==STATUS_LOWRES);
+    CHECK((S16L::measure<TEMP>(v)==0)&&(v==(0x1A2B&0x0FFF)));
+    CHECK((S16L::measure<HUMI>(v)==0)&&(v==(0x0ABC&0x00FF)));
+    CHECK(S16L::reset()==0);
+    CHECK((S16L::read_status(s)==0)&&(s==STATUS_LOWRES));
+}
+
+/// time (ms) and active cycles per measurement, template and C driver
+void timing(void)
+{
+    unsigned int v;
+    uint64_t t, a;
+    int i;
+
+    printf("%-10s %10s %14s\n","driver","ms","active cycles");
+    shtsim_reset();
+    S1::init();
+    sht11_init();
+    for (i=0;i<2;i++)
+    {
+        t = shtsim_time(); a = shtsim_active();
+        if (i==0) S1::measure<TEMP>(v);
+        else sht_measure_check(&v,TEMP);
+        t = shtsim_time()-t; a = shtsim_active()-a;
+        printf("%-10s %10.2f %14" PRIu64 "\n",i?"sht11.c":"sht11.hpp",t/1000.0,a);
+        CHECK(t<SHTSIM_CONV14+2000);
+    }
+}
+
+int main(void)
+{
+    constants();
+    measure();
+    timing();
+    printf("%d tests, %d failed\n",tests,failed);
+    return (failed!=0);
+}
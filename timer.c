@@ -4,39 +4,228 @@
  *  Created on: 22.8.2012
  *      Author: ohejda
  *
- *  Description: timer module using interrupts
+ *  Description: tick-less scheduler of periodic tasks (see timer.h)
  *
  *  Functions:
  *  	timer_init(void) .. timer initialization
+ *  	timer_now(void) .. time (32 bit, timer ticks)
+ *  	sched_add(task,period), sched_set_period(id,period) .. task table
+ *  	sched_run(void) .. run due tasks, sleep until next one
  *
  *  Interrupt routines:
- *  	Timer A0 interrupt service routine .. set new timeout and exit sleep mode
+ *  	Timer A0 interrupt service routine .. mark due tasks, set next alarm, exit sleep mode
+ *  	Timer A1 interrupt service routine .. timer overflow (high word of time)
  *
  */
 
 // include section
+#include <stdint.h>
+#ifndef SHT_HOST
 #include <msp430g2553.h>
+
+#define TIMER_TAR() TAR
+#define TIMER_ALARM(t) {CCR0 = (t);}
+#define TIMER_ALARM_NOW() {CCTL0 |= CCIFG;}	// interrupt right away
+#define TIMER_OVF_PENDING() (TACTL&TAIFG)
+#define TIMER_IV() TAIV
+#ifdef SHT_PROF
+#define TIMER_SLEEP() __bis_SR_register(LPM0_bits + GIE)
+#else
+#define TIMER_SLEEP() __bis_SR_register(LPM3_bits + GIE)
+#endif
+
+#else
+// host build, timer is simulated by test (test/schedtest)
+uint16_t timer_host_tar(void);
+void timer_host_alarm(uint16_t t);
+void timer_host_alarm_now(void);
+unsigned char timer_host_ovf(void);
+unsigned int timer_host_iv(void);
+void timer_host_sleep(void);
+
+#define TIMER_TAR() timer_host_tar()
+#define TIMER_ALARM(t) timer_host_alarm(t)
+#define TIMER_ALARM_NOW() timer_host_alarm_now()
+#define TIMER_OVF_PENDING() timer_host_ovf()
+#define TIMER_IV() timer_host_iv()
+#define TIMER_SLEEP() timer_host_sleep()
+#define __get_interrupt_state() 0
+#define __set_interrupt_state(x) ((void)(x))
+#define __disable_interrupt() ((void)0)
+#define __enable_interrupt() ((void)0)
+#define __bic_SR_register_on_exit(x) ((void)0)
+#define __interrupt
+#define TA0IV_TAIFG 0x0A
+#endif
+
 // self
 #include "timer.h"
 
+/** module local definitions */
+
+// task (function, period, next deadline)
+typedef struct {
+	sched_task_t task;
+	unsigned long period;
+	unsigned long next;
+} sched_slot_t;
+
+sched_slot_t sched_tab[SCHED_TASKS];
+unsigned char sched_cnt = 0;
+volatile unsigned char sched_pending = 0; // due tasks (bit per task)
+
+// time high word (timer overflows)
+volatile uint16_t timer_hi = 0;
+
+/** timer section */
+
+//----------------------------------------------------------------------------------
 // timer init
+//----------------------------------------------------------------------------------
 void timer_init(void)
 {
-	CCTL0 = CCIE;				// CCR0 interrupt enabled
-	CCR0 = TIMER_INTERVAL;
-	TACTL = TASSEL_2 + MC_2 + ID_3;	// SMCLK, contmode, fosc/8
+#ifndef SHT_HOST
+	CCTL0 = 0;						// CCR0 interrupt enabled by first task
+	#ifdef SHT_PROF
+	TACTL = TASSEL_2 + MC_2 + ID_3 + TAIE;	// SMCLK, contmode, fosc/8, overflow interrupt
+	#else
+	TACTL = TASSEL_1 + MC_2 + TAIE;	// ACLK, contmode, overflow interrupt
+	#endif
+#endif
+	timer_hi = 0;
+	sched_cnt = 0;
+	sched_pending = 0;
 }
 
-// Timer A0 interrupt service routine
-#pragma vector=TIMER0_A0_VECTOR
-__interrupt void Timer_A (void)
+//----------------------------------------------------------------------------------
+// time in timer ticks
+//----------------------------------------------------------------------------------
+unsigned long timer_now(void)
 {
-	static unsigned int cnt = 0;
-	CCR0 += TIMER_INTERVAL;				// Add Offset to CCR0
-	cnt++;
-	if (cnt>=TIMER_MULTIPLIER)
+	uint16_t hi, lo;
+	unsigned int ie = __get_interrupt_state();
+	__disable_interrupt();
+	do lo = TIMER_TAR(); while (lo!=TIMER_TAR()); // timer clock is asynchronous to MCLK
+	hi = timer_hi;
+	if (TIMER_OVF_PENDING() && (lo<0x8000)) hi++; // overflow not serviced yet
+	__set_interrupt_state(ie);
+	return ((unsigned long)hi<<16) | lo;
+}
+
+/** scheduler section */
+
+//----------------------------------------------------------------------------------
+// mark due tasks and set alarm to nearest deadline (interrupts disabled)
+//----------------------------------------------------------------------------------
+static void sched_update(void)
+{
+	unsigned long now = timer_now();
+	long d, dmin = 0x7FFFFFFFL;
+	unsigned char i;
+
+	if (sched_cnt==0) return;
+	for (i=0;i<sched_cnt;i++)
 	{
-		cnt=0;
-		__bic_SR_register_on_exit(CPUOFF);        // Clear CPUOFF bit from 0(SR)
+		sched_slot_t *s = &sched_tab[i];
+		d = (long)(s->next-now);
+		if (d<=0) // due
+		{
+			sched_pending |= 1<<i;
+			s->next += s->period;
+			d = (long)(s->next-now);
+			if (d<=0) // periods missed, start again from now
+			{
+				s->next = now+s->period;
+				d = s->period;
+			}
+		}
+		if (d<dmin) dmin = d;
 	}
+	TIMER_ALARM((uint16_t)(now+dmin)); // far alarm matches earlier, update is then repeated
+	if ((dmin<0x8000) && ((int16_t)((uint16_t)(now+dmin)-TIMER_TAR())<=0)) TIMER_ALARM_NOW(); // passed while setting
+}
+
+//----------------------------------------------------------------------------------
+// add periodic task (first run one period from now), returns task id (-1 table full)
+//----------------------------------------------------------------------------------
+char sched_add(sched_task_t task, unsigned long period)
+{
+	unsigned char id;
+	unsigned int ie = __get_interrupt_state();
+
+	if (sched_cnt>=SCHED_TASKS) return -1;
+	__disable_interrupt();
+	id = sched_cnt++;
+	sched_tab[id].task = task;
+	sched_tab[id].period = period;
+	sched_tab[id].next = timer_now()+period;
+	sched_update();
+#ifndef SHT_HOST
+	CCTL0 = CCIE;
+#endif
+	__set_interrupt_state(ie);
+	return id;
+}
+
+//----------------------------------------------------------------------------------
+// change task period (next run one period from now)
+//----------------------------------------------------------------------------------
+void sched_set_period(char id, unsigned long period)
+{
+	unsigned int ie = __get_interrupt_state();
+
+	unsigned char n = id;
+
+	if (n>=sched_cnt) return; // also -1 (no task)
+	__disable_interrupt();
+	sched_tab[n].period = period;
+	sched_tab[n].next = timer_now()+period;
+	sched_update();
+	__set_interrupt_state(ie);
+}
+
+//----------------------------------------------------------------------------------
+// run due tasks (sleep until some task is due)
+//----------------------------------------------------------------------------------
+void sched_run(void)
+{
+	unsigned char i, pending;
+
+	__disable_interrupt();
+	while (sched_pending==0)
+	{
+		TIMER_SLEEP(); // leave on alarm interrupt
+		__disable_interrupt();
+	}
+	pending = sched_pending;
+	sched_pending = 0;
+	__enable_interrupt();
+
+	for (i=0;i<sched_cnt;i++)
+		if (pending&(1<<i)) sched_tab[i].task();
+}
+
+/** interrupt section */
+
+//----------------------------------------------------------------------------------
+// Timer A0 interrupt service routine (alarm)
+//----------------------------------------------------------------------------------
+#ifndef SHT_HOST
+#pragma vector=TIMER0_A0_VECTOR
+#endif
+__interrupt void Timer_A (void)
+{
+	sched_update();
+	if (sched_pending) __bic_SR_register_on_exit(LPM3_bits); // exit sleep mode (LPM0 or LPM3)
+}
+
+//----------------------------------------------------------------------------------
+// Timer A1 interrupt service routine (overflow)
+//----------------------------------------------------------------------------------
+#ifndef SHT_HOST
+#pragma vector=TIMER0_A1_VECTOR
+#endif
+__interrupt void Timer_A1 (void)
+{
+	if (TIMER_IV()==TA0IV_TAIFG) timer_hi++;
 }
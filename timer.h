@@ -4,25 +4,64 @@
  *  Created on: 22.8.2012
  *      Author: ohejda
  *
- *  Description: timer module using interrupts
+ *  Description: tick-less scheduler of periodic tasks (Timer0_A, continuous mode)
  *
  *  Functions:
  *  	timer_init(void) .. timer initialization
+ *  	timer_now(void) .. time (32 bit, timer ticks)
+ *  	sched_add(task,period) .. add periodic task (returns task id, -1 table full)
+ *  	sched_set_period(id,period) .. change task period (next run one period from now)
+ *  	sched_run(void) .. run due tasks, sleep until next one (main loop)
  *
  *  Interrupt routines:
- *  	Timer A0 interrupt service routine .. set new timeout and exit sleep mode
+ *  	Timer A0 interrupt service routine .. mark due tasks, set next alarm, exit sleep mode
+ *  	Timer A1 interrupt service routine .. timer overflow (high word of time)
  *
+ *  Timer runs from ACLK and CCR0 is set to the nearest task deadline only, so
+ *  the CPU sleeps in LPM3 (DCO and SMCLK off) between the tasks. Alarms beyond
+ *  the 16 bit range just wake the interrupt, which sets the next one.
+ *  Tasks run from sched_run() in main context in table order, a task which
+ *  became due more times meanwhile runs once (missed periods are skipped).
+ *  Uart keeps working in LPM3, USCI turns SMCLK on by itself when it needs it.
+ *
+ *  SHT_PROF build keeps timer on SMCLK/8, because profiling timestamps are
+ *  taken from TAR (see prof.h), so the CPU sleeps in LPM0 there.
+ *
+ *  VLO frequency varies with the part, voltage and temperature (4..20kHz),
+ *  set TIMER_ACLK_HZ=32768 when a crystal is fitted (and select it in main.c).
  */
 
 #ifndef __TIMER_H__
 #define __TIMER_H__
 
-// timer counter multiplier (10 * 0.5s = 5s)
-#define TIMER_MULTIPLIER 10
+// ACLK frequency (default VLO, typ. 12kHz)
+#ifndef TIMER_ACLK_HZ
+#define TIMER_ACLK_HZ 12000
+#endif
+
+// timer frequency (ticks per second)
+#ifdef SHT_PROF
+#define TIMER_HZ 125000UL // SMCLK/8 (1MHz DCO, SHT_PROF needs it, see prof.h)
+#else
+#define TIMER_HZ ((unsigned long)TIMER_ACLK_HZ)
+#endif
+
+// period to ticks (max. half of 32 bit range, 4.7 hours at SMCLK/8)
+#define TIMER_S(s) ((unsigned long)(s)*TIMER_HZ)
+#define TIMER_MS(ms) ((unsigned long)(ms)*TIMER_HZ/1000)
+
+// task table length
+#ifndef SCHED_TASKS
+#define SCHED_TASKS 4
+#endif
 
-// timer interval (0.5s / 1MHz osc / fosc/8)
-#define TIMER_INTERVAL 62500
+// task function
+typedef void (*sched_task_t)(void);
 
 void timer_init(void);
+unsigned long timer_now(void);
+char sched_add(sched_task_t task, unsigned long period);
+void sched_set_period(char id, unsigned long period);
+void sched_run(void);
 
 #endif
@@ -6,8 +6,12 @@
  *
  *  Description: uart module template implementing char reception and
  *  	circular transmit buffer with functions putc and puts
- *  	if it receives '?' char it answers with "Hello World !" string
+ *  	if it receives '?' char it answers with debug values (snapshot published by main)
  *  	runs completely in interrupts
+ *  	if it receives 's' char it answers with tx buffer stats (drops,high water,length)
+ *  	buffered chars, block and source are sent as whole transfers (one finishes, then
+ *  	the next starts), buffered chars wait during a source and are dropped if it is long
+ *  	baud rate is selected from modulation table of SMCLK (UART_SMCLK 1/8/16MHz)
  *  	have fun!
  */
 
@@ -32,18 +36,63 @@
 #endif
 #undef UART_TX_LED
 
-// uart buffer length (mask preferred)
-#define UART_TX_BUFLEN 16
-#define UART_TX_BUFMASK 0x0F
+// uart buffer length (power of 2 preferred, mask is used then)
+#ifndef UART_TX_BUFLEN
+#define UART_TX_BUFLEN 32
+#endif
+#if ((UART_TX_BUFLEN&(UART_TX_BUFLEN-1))==0)
+#define UART_TX_BUFMASK (UART_TX_BUFLEN-1)
+#endif
+
+// baud rate table (SLAU144 USCI UART, UCOS16=0), UCA0MCTL = UCBRSx<<1
+typedef struct {
+	unsigned long baud;
+	unsigned int br;
+	unsigned char brs;
+} uart_baud_t;
+
+const uart_baud_t uart_baud_tab[] = {
+#if UART_SMCLK==16000000
+	{9600,1666,6},{19200,833,2},{38400,416,6},{57600,277,7},{115200,138,7}
+#elif UART_SMCLK==8000000
+	{9600,833,2},{19200,416,6},{38400,208,3},{57600,138,7},{115200,69,4}
+#elif UART_SMCLK==1000000
+	{9600,104,1},{19200,52,0},{38400,26,0},{57600,17,3},{115200,8,6}
+#else
+#error "uart: no baud rate table for UART_SMCLK"
+#endif
+};
+#define UART_BAUDS (sizeof(uart_baud_tab)/sizeof(uart_baud_t))
+
+// debug values (bcd T, RH, dew point, absolute humidity - see main.c)
+#define CHANNELS 4
+unsigned int debug_value[CHANNELS] = {0,0,0,0};
 
-#define CHANNELS 2
-unsigned int debug_value[CHANNELS] = {0,0};
+// '?' answer snapshot (4 hex digits per channel, ',' separated, '\n' terminated), double
+// buffered: main encodes the back buffer and publishes it by one index write, rx interrupt
+// hands the published one to tx (no formatting in interrupt, no mixed channels)
+#define SNAP_LEN (CHANNELS*5)
+char uart_snap[2][SNAP_LEN];
+volatile unsigned char uart_snap_idx = 0;
 
 // uart circular buffer
 char uart_tx_buffer[UART_TX_BUFLEN]={'\0'};
 unsigned int uart_tx_inptr=0, uart_tx_outptr=0;
 // uart transmit flag (0 not transmitting, 1 transmitting)
 bool uart_tx_transmitt = false;
+// active transfer (buffered chars, block, source), it is finished before the next one
+// starts, so buffered chars never get inside a block ('?' answer) or source frame
+enum {UART_TX_IDLE,UART_TX_RING,UART_TX_BLOCK,UART_TX_SOURCE};
+unsigned char uart_tx_active = UART_TX_IDLE;
+// uart tx block (sent from caller memory when buffer is empty), tx source (streaming
+// when buffer and block are empty) and rx command handler
+const char *uart_tx_block = 0;
+unsigned int uart_tx_block_len = 0;
+uart_source_t uart_tx_source = 0, uart_tx_source_next = 0;
+uart_rx_handler_t uart_rx_handler = 0;
+
+// uart tx buffer stats (chars dropped, max. chars waiting in buffer)
+uart_stats_t uart_stats = {0,0};
 
 // local function definition
 int uart_start_tx(void);
@@ -69,6 +118,34 @@ unsigned int get_debug_value(unsigned int channel)
 	return (debug_value[channel]);
 }
 
+// encode debug values to back buffer of '?' answer and publish it (-1 if back buffer
+// is still being sent, values stay set for next publish)
+int publish_debug_values(void)
+{
+	unsigned char back = uart_snap_idx^1;
+	char *p = uart_snap[back];
+	unsigned int i, v;
+	unsigned int ie = __get_interrupt_state();
+	__disable_interrupt();
+	if ((uart_tx_block_len!=0)&&(uart_tx_block>=p)&&(uart_tx_block<p+SNAP_LEN))
+	{
+		__set_interrupt_state(ie);
+		return -1;
+	}
+	__set_interrupt_state(ie);
+	for (i=0;i<CHANNELS;i++) // rx interrupt sends only the published buffer
+	{
+		v = debug_value[i];
+		*p++ = h2c(v>>12);
+		*p++ = h2c(v>>8);
+		*p++ = h2c(v>>4);
+		*p++ = h2c(v);
+		*p++ = (i!=(CHANNELS-1)) ? ',' : '\n';
+	}
+	uart_snap_idx = back; // publish (byte write)
+	return 0;
+}
+
 // uart initialization
 void uart_init(void)
 {
@@ -77,48 +154,137 @@ void uart_init(void)
 	P1SEL = BIT1 + BIT2 ;   // P1.1 = RXD, P1.2=TXD
 	P1SEL2 = BIT1 + BIT2 ;  // P1.1 = RXD, P1.2=TXD
 	UCA0CTL1 |= UCSSEL_2;   // SMCLK
-	UCA0BR0 = 104;          // 1MHz 9600
-	UCA0BR1 = 0;            // 1MHz 9600
-	UCA0MCTL = UCBRS0;      // Modulation UCBRSx = 1
+	publish_debug_values(); // '?' answer valid from start
+	uart_set_baud(UART_BAUD); // default baud rate (starts USCI state machine)
+}
+
+// uart baud rate (returns -1 if not in table), waits until running transmission ends
+int uart_set_baud(unsigned long baud)
+{
+	unsigned int i, ie;
+	for (i=0;i<UART_BAUDS;i++) if (uart_baud_tab[i].baud==baud) break;
+	if (i==UART_BAUDS) return -1;
+	ie = __get_interrupt_state();
+	__disable_interrupt();   // tx interrupt can't load next char between wait and reset
+	while (UCA0STAT&UCBUSY); // don't break character being sent
+	UCA0CTL1 |= UCSWRST;    // USCI reset
+	UCA0BR0 = uart_baud_tab[i].br;
+	UCA0BR1 = uart_baud_tab[i].br>>8;
+	UCA0MCTL = uart_baud_tab[i].brs<<1; // Modulation UCBRSx
 	UCA0CTL1 &= ~UCSWRST;   // **Initialize USCI state machine**
-	IE2 |= UCA0RXIE;        // Enable USCI_A0 RX interrupt
+	IE2 |= UCA0RXIE;        // Enable USCI_A0 RX interrupt (cleared by reset)
+	if (uart_tx_transmitt) IE2 |= UCA0TXIE; // continue transmitting
+	__set_interrupt_state(ie);
+	return 0;
 }
 
-// uart start transmitting (transmit next character in buffer)
-int uart_start_tx(void)
+// next char of active transfer (-1 at its end)
+static int uart_tx_next(void)
 {
-	if (uart_tx_inptr==uart_tx_outptr)
+	int c;
+	switch (uart_tx_active)
 	{
-		uart_tx_transmitt=false; // clear transmit flag
-		return -1; // don't start when buffer empty
-	}
-	UART_TX_LED_ON(); // LED ON
-	//while (!(IFG2&UCA0TXIFG));	// USCI_A0 TX buffer ready?
+	case UART_TX_RING:
+		if (uart_tx_inptr==uart_tx_outptr) return -1;
 #ifdef UART_TX_BUFMASK
-	unsigned int new_ptr = (uart_tx_outptr+1)&UART_TX_BUFMASK;
+		uart_tx_outptr = (uart_tx_outptr+1)&UART_TX_BUFMASK;
 #else
-	unsigned int new_ptr = (uart_tx_outptr+1)%UART_TX_BUFLEN;
+		uart_tx_outptr = (uart_tx_outptr+1)%UART_TX_BUFLEN;
 #endif
+		return (unsigned char)uart_tx_buffer[uart_tx_outptr];
+	case UART_TX_BLOCK:
+		if (uart_tx_block_len==0) return -1;
+		uart_tx_block_len--;
+		return (unsigned char)*uart_tx_block++;
+	case UART_TX_SOURCE:
+		c = uart_tx_source();
+		if (c<0) // source finished, waiting one goes next
+		{
+			uart_tx_source = uart_tx_source_next;
+			uart_tx_source_next = 0;
+		}
+		return c;
+	}
+	return -1;
+}
+
+// uart start transmitting (next char of active transfer, when it ends next transfer
+// starts: buffered chars, block, source)
+int uart_start_tx(void)
+{
+	int c;
+	while ((c = uart_tx_next())<0)
+	{
+		if (uart_tx_inptr!=uart_tx_outptr) uart_tx_active = UART_TX_RING;
+		else if (uart_tx_block_len!=0) uart_tx_active = UART_TX_BLOCK;
+		else if (uart_tx_source) uart_tx_active = UART_TX_SOURCE;
+		else
+		{
+			uart_tx_active = UART_TX_IDLE;
+			uart_tx_transmitt=false; // clear transmit flag
+			return -1; // don't start when nothing to send
+		}
+	}
+	UART_TX_LED_ON(); // LED ON
 	uart_tx_transmitt=true; // set transmit flag
-	UCA0TXBUF = uart_tx_buffer[new_ptr]; // TX character
-	uart_tx_outptr = new_ptr;
+	UCA0TXBUF = c; // TX character
 	IE2 |= UCA0TXIE;		// Enable USCI_A0 TX interrupt
 	return 0; // return ok
 }
 
+// chars waiting in buffer
+static unsigned int uart_tx_used(void)
+{
+#ifdef UART_TX_BUFMASK
+	return (uart_tx_inptr-uart_tx_outptr)&UART_TX_BUFMASK;
+#else
+	return (uart_tx_inptr+UART_TX_BUFLEN-uart_tx_outptr)%UART_TX_BUFLEN;
+#endif
+}
+
 // uart put char function
 int uart_putc(char c)
 {
+	return (uart_write(&c,1)==1) ? 0 : -1;
+}
+
+// uart write (all chars or nothing, copied in one critical section)
+// returns len or -1 if buffer has not enough space (counted as dropped)
+int uart_write(const char *buf, unsigned int len)
+{
+	unsigned int i, used;
+	unsigned int ie = __get_interrupt_state();
+	__disable_interrupt();
+	used = uart_tx_used();
+	if (len>(UART_TX_BUFLEN-1-used)) // buffer full
+	{
+		uart_stats.drops += len;
+		__set_interrupt_state(ie);
+		return -1;
+	}
+	for (i=0;i<len;i++)
+	{
 #ifdef UART_TX_BUFMASK
-	unsigned int new_ptr = (uart_tx_inptr+1)&UART_TX_BUFMASK;
+		uart_tx_inptr = (uart_tx_inptr+1)&UART_TX_BUFMASK;
 #else
-	int new_ptr = (uart_tx_inptr+1)%UART_TX_BUFLEN;
+		uart_tx_inptr = (uart_tx_inptr+1)%UART_TX_BUFLEN;
 #endif
-	if (new_ptr==uart_tx_outptr) return -1; // buffer full
-	uart_tx_buffer[new_ptr] = c;
-	uart_tx_inptr=new_ptr;
-	if (!uart_tx_transmitt) return uart_start_tx(); // return ok (if buffer not empty)
-	return 0; // return ok
+		uart_tx_buffer[uart_tx_inptr] = buf[i];
+	}
+	used += len;
+	if (used>uart_stats.hiwater) uart_stats.hiwater = used;
+	if (!uart_tx_transmitt) uart_start_tx(); // start transmitting
+	__set_interrupt_state(ie);
+	return len;
+}
+
+// uart tx buffer stats
+void uart_get_stats(uart_stats_t *stats)
+{
+	unsigned int ie = __get_interrupt_state();
+	__disable_interrupt();
+	*stats = uart_stats;
+	__set_interrupt_state(ie);
 }
 
 // uart put string function
@@ -131,6 +297,67 @@ int uart_puts(char *s)
 	return ptr;
 }
 
+// uart send block from caller memory (buffered chars go first), memory must stay
+// unchanged until sent (-1 if other block is being sent)
+int uart_send_block(const char *buf, unsigned int len)
+{
+	unsigned int ie = __get_interrupt_state();
+	__disable_interrupt();
+	if (uart_tx_block_len!=0)
+	{
+		__set_interrupt_state(ie);
+		return -1; // other block running
+	}
+	uart_tx_block = buf;
+	uart_tx_block_len = len;
+	if (!uart_tx_transmitt) uart_start_tx(); // start if not transmitting
+	__set_interrupt_state(ie);
+	return 0; // return ok
+}
+
+// uart stream from source (buffered chars go first)
+int uart_send_source(uart_source_t src)
+{
+	unsigned int ie = __get_interrupt_state();
+	__disable_interrupt();
+	if (uart_tx_source)
+	{
+		__set_interrupt_state(ie);
+		return -1; // other source running
+	}
+	uart_tx_source = src;
+	if (!uart_tx_transmitt) uart_start_tx(); // start if not transmitting
+	__set_interrupt_state(ie);
+	return 0; // return ok
+}
+
+// uart stream from source, if other source is running it waits until that one finishes
+// (-1 if other source is already waiting)
+int uart_queue_source(uart_source_t src)
+{
+	unsigned int ie = __get_interrupt_state();
+	__disable_interrupt();
+	if (uart_tx_source)
+	{
+		if (uart_tx_source_next)
+		{
+			__set_interrupt_state(ie);
+			return -1; // other source waiting
+		}
+		uart_tx_source_next = src;
+		__set_interrupt_state(ie);
+		return 0; // started by tx interrupt
+	}
+	__set_interrupt_state(ie);
+	return uart_send_source(src);
+}
+
+// uart rx command handler
+void uart_set_rx_handler(uart_rx_handler_t handler)
+{
+	uart_rx_handler = handler;
+}
+
 // interrupt handlers
 
 // uart RX interrupt handler
@@ -139,19 +366,27 @@ __interrupt void USCI0RX_ISR(void)
 {
 	UART_TX_LED_ON();
 	char c = UCA0RXBUF;		// read char
+	if (uart_rx_handler && uart_rx_handler(c)) return; // handled by application (commands)
 	if (c=='?')
 	{
+		// published snapshot (answer to '?' being sent counts as dropped)
+		if (uart_send_block(uart_snap[uart_snap_idx],SNAP_LEN)!=0) uart_stats.drops += SNAP_LEN;
+		//uart_puts("Hello World!\n");
+	}
+	if (c=='s')
+	{
+		unsigned int v[3] = {uart_stats.drops,uart_stats.hiwater,UART_TX_BUFLEN};
+		char ans[15];
 		int i;
-		for (i=0;i<CHANNELS;i++)
+		for (i=0;i<3;i++)
 		{
-			uart_putc(h2c(debug_value[i]>>12));
-			uart_putc(h2c(debug_value[i]>>8));
-			uart_putc(h2c(debug_value[i]>>4));
-			uart_putc(h2c(debug_value[i]));
-			if (i!=(CHANNELS-1)) uart_putc(',');
+			ans[i*5] = h2c(v[i]>>12);
+			ans[i*5+1] = h2c(v[i]>>8);
+			ans[i*5+2] = h2c(v[i]>>4);
+			ans[i*5+3] = h2c(v[i]);
+			ans[i*5+4] = (i!=2) ? ',' : '\n';
 		}
-		uart_putc('\n');
-		//uart_puts("Hello World!\n");
+		uart_write(ans,15); // whole answer or nothing
 	}
 }
 
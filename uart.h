@@ -9,16 +9,57 @@
  *  	uart_init .. initialization
  *  	uart_putc .. put char function
  *  	uart_puts .. put string function
+ *  	uart_write .. put buffer function (all or nothing)
+ *  	uart_set_baud .. baud rate (9600 .. 115200)
+ *  	uart_get_stats .. tx buffer stats (backpressure)
+ *  	uart_send_block .. send block from caller memory (no copy)
+ *  	uart_send_source .. stream characters from source (bulk transfers)
+ *  	uart_queue_source .. the same, or wait until running source finishes (one waiting source)
+ *  	set_debug_value, publish_debug_values .. '?' answer (double buffered snapshot)
+ *  	uart_set_rx_handler .. handler of received commands
  */
 
 #ifndef UART_H_
 #define UART_H_
 
+// SMCLK frequency (1, 8 or 16MHz DCO calibration) and baud rate after init
+#ifndef UART_SMCLK
+#define UART_SMCLK 1000000
+#endif
+#ifndef UART_BAUD
+#define UART_BAUD 9600
+#endif
+
+// tx buffer stats
+typedef struct {
+	unsigned int drops;		// chars dropped (buffer full)
+	unsigned int hiwater;	// max. chars waiting in buffer
+} uart_stats_t;
+
+// debug values ('?' answer): set channels, then publish all at once (encoded answer
+// swapped in, -1 if back buffer is still being sent - values are kept for next publish)
 void set_debug_value(unsigned int value, unsigned int channel);
 unsigned int get_debug_value(unsigned int channel);
+int publish_debug_values(void);
 
 void uart_init(void); // initialization
 int uart_putc(char c); // put char function
 int uart_puts(char *s); // put string function
+int uart_write(const char *buf, unsigned int len); // put buffer function (len or -1 if not enough space)
+int uart_set_baud(unsigned long baud); // set baud rate (-1 if not supported)
+void uart_get_stats(uart_stats_t *stats); // tx buffer stats
+
+// send block from caller memory after buffered chars (-1 if other block is being sent)
+int uart_send_block(const char *buf, unsigned int len);
+
+// tx source, called from tx interrupt when buffer is empty (returns char, -1 at the end)
+typedef int (*uart_source_t)(void);
+int uart_send_source(uart_source_t src); // stream from source (-1 if other source running)
+int uart_queue_source(uart_source_t src); // stream from source now or after running one (-1 if other waits)
+
+// rx handler, called from rx interrupt with every received char (returns 1 if char handled,
+// 0 leaves it to uart module - '?' debug values)
+typedef int (*uart_rx_handler_t)(char c);
+void uart_set_rx_handler(uart_rx_handler_t handler);
 
 #endif /* UART_H_ */